@@ -15,9 +15,35 @@
 
 /* Includes ------------------------------------------------------------------*/
 #include "stm32f4xx.h"
+#include "stdbool.h"
 #include "utl.h"
+#include "dma.h"
+#include "iox.h"
+
+#define ADC_SCAN_MAX            16u     /* regular sequence length */
+#define ADC_CHANNELS            16u     /* external inputs on ADC1 */
+
+typedef void (*adc_half_callback_fn) (uint32_t half);
 
 extern void adc_init(void);
 extern uint16_t adc_get_measurement(void);
 
+/**
+ * Convert 'n' (1..ADC_SCAN_MAX) channels in one regular-sequence scan
+ * into 'out', in the order given, waiting for the last. False if the
+ * channel list is bad or the DMA stream is taken.
+ */
+extern bool adc_scan(uint8_t const *chans, uint32_t n, uint16_t *out);
+
+/**
+ * Pin for an ADC1 input channel: PA0-7, PB0-1, PC0-5. False if there is
+ * no such channel.
+ */
+extern bool adc_channel_pin(uint32_t ch, iox_port_t *port, uint32_t *pin);
+
+extern bool adc_capture_start(uint16_t *buf, uint32_t len,
+                              adc_half_callback_fn cb);
+extern void adc_capture_stop(void);
+extern uint32_t adc_capture_pos(uint32_t len);
+
 #endif
\ No newline at end of file
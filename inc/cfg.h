@@ -0,0 +1,64 @@
+/**
+  ******************************************************************************
+  * @file    cfg.h
+  * @author  Joe Todd
+  * @version
+  * @date
+  * @brief   Header for cfg.c
+  *
+  * Configuration record in internal flash, sectors 1 and 2 (see
+  * stm32_flash.ld):
+  *
+  *     0x08004000  sector 1   16KB
+  *     0x08008000  sector 2   16KB
+  *
+  * Each save goes to the sector not holding the current record, so the
+  * current one is untouched until the new one is complete. A record is
+  *
+  *     0   magic       programmed last: a torn record has none
+  *     4   crc         CRC unit over bytes 8.. as words
+  *     8   seq         higher is newer
+  *     12  version     u16, schema of the payload
+  *     14  size        u16, payload bytes
+  *     16  payload
+  ******************************************************************************
+*/
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef CFG_H
+#define CFG_H
+
+/* Includes ------------------------------------------------------------------*/
+#include "stdint.h"
+#include "stdbool.h"
+#include "stm32f4xx.h"
+#include "stm32f4xx_conf.h"
+#include "crc.h"
+
+#define CFG_MAX_SIZE        256u    /* largest payload */
+
+/**
+ * Return codes
+ */
+typedef enum {
+    cfg_ok,
+    cfg_empty,          /* no valid record */
+    cfg_error,
+} cfg_rc_t;
+
+/**
+ * Copy the newest valid record into 'data', at most 'size' bytes; a
+ * shorter record leaves the rest of 'data' alone. '*version' and '*len'
+ * get the record's schema version and payload size. Only the newest
+ * record's CRC is checked unless it fails.
+ */
+extern cfg_rc_t cfg_load(void *data, uint32_t size, uint16_t *version,
+                         uint32_t *len);
+
+/**
+ * Write a new record. Erases one 16KB sector, which stalls the CPU for
+ * a few hundred milliseconds.
+ */
+extern cfg_rc_t cfg_save(void const *data, uint32_t size, uint16_t version);
+
+#endif
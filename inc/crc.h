@@ -0,0 +1,33 @@
+/**
+  ******************************************************************************
+  * @file    crc.h
+  * @author  Joe Todd
+  * @version
+  * @date
+  * @brief   Header for crc.c
+  *
+  ******************************************************************************
+*/
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef CRC_H
+#define CRC_H
+
+/* Includes ------------------------------------------------------------------*/
+#include "stdint.h"
+#include "stm32f4xx.h"
+#include "stm32f4xx_conf.h"
+
+/**
+ * Turn on the CRC unit.
+ */
+extern void crc_init(void);
+
+/**
+ * CRC-32 (poly 0x04C11DB7, init 0xFFFFFFFF, no reflection, no final xor)
+ * of 'words' 32-bit words, as computed by the on-chip CRC unit. The unit
+ * is not reentrant: do not use it from interrupts.
+ */
+extern uint32_t crc_block(uint32_t const *buf, uint32_t words);
+
+#endif
@@ -0,0 +1,76 @@
+/**
+  ******************************************************************************
+  * @file    ctl.h
+  * @author  Joe Todd
+  * @version
+  * @date
+  * @brief   Header for ctl.c
+  *
+  * Fixed-point PID watering controller, on the CMSIS-DSP Q15 PID.
+  *
+  *     error   (reading - setpoint) << 3, so the 12-bit ADC fills Q15 and
+  *             a positive error means drier than wanted
+  *     gains   Kp, Ki, Kd in Q15, 32768 = 1.0. Kp + Ki + Kd saturates at
+  *             just under 1.0, so keep their sum below 32768
+  *     output  Q15 demand 0..1.0, scaled to 0..max seconds of valve
+  *
+  * arm_pid_q15() is the incremental form, y[n] = y[n-1] + A0 e[n] +
+  * A1 e[n-1] + A2 e[n-2], so the integral lives in the last output. Clamping
+  * that output to 0..1.0 before it is fed back is the anti-windup: a long
+  * dry spell with the valve already fully open cannot build up a debt that
+  * floods the bed once it is wet again.
+  *
+  * Only integer code is used: the header's inline Q15 PID and the gains
+  * worked out here, as arm_pid_init_q15() lives in the DSP library, which
+  * is not linked.
+  ******************************************************************************
+*/
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef CTL_H
+#define CTL_H
+
+/* Includes ------------------------------------------------------------------*/
+#include "stdint.h"
+#include "stdbool.h"
+#include "stm32f4xx.h"
+
+#ifndef ARM_MATH_CM4
+#define ARM_MATH_CM4
+#endif
+#include "arm_math.h"
+
+typedef struct {
+    arm_pid_instance_q15 pid;
+    bool seed;              /* take the error history from the next reading */
+} ctl_t;
+
+/**
+ * Set the gains and clear the history.
+ */
+extern void ctl_init(ctl_t *ctl, uint16_t kp, uint16_t ki, uint16_t kd);
+
+/**
+ * Change the gains, keeping the history, so they can be tuned in place.
+ */
+extern void ctl_gains(ctl_t *ctl, uint16_t kp, uint16_t ki, uint16_t kd);
+
+/**
+ * Carry on from a demand saved before a reset. Only the demand is kept,
+ * so the next reading stands in for the two before it, and the P and D
+ * terms see no step.
+ */
+extern void ctl_resume(ctl_t *ctl, uint16_t demand);
+
+/**
+ * Run one step on a reading and return the valve time, 0..max seconds.
+ */
+extern uint32_t ctl_update(ctl_t *ctl, uint16_t level, uint16_t setpoint,
+                           uint32_t max);
+
+/**
+ * The last demand, Q15.
+ */
+extern uint16_t ctl_demand(ctl_t const *ctl);
+
+#endif
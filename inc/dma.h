@@ -6,6 +6,9 @@
   * @date    
   * @brief   Header for dma.c
   *
+  * Streams are numbered 0-15: DMA1 Streams 0-7, then DMA2 Streams 0-7,
+  * see DMA_STREAM(). A driver claims a stream and channel before using
+  * it and gets the stream's interrupts through its callback.
   ******************************************************************************
 */
   
@@ -15,9 +18,11 @@
 
 /* Includes ------------------------------------------------------------------*/
 #include "stdint.h"
+#include "stdbool.h"
 #include "stm32f4xx.h"
 #include "stm32f4xx_conf.h"
 #include "iox.h"
+#include "utl.h"
 
 
 /*
@@ -44,15 +49,147 @@
 #define  DMA_CR_CHSEL_Pos     25      /*!< Position of Channel selection */
 
 
+/*
+ * Stream numbering.
+ */
+#define DMA_STREAMS         16u
+#define DMA_STREAM(ctrl, n) ((((ctrl) - 1u) * 8u) + (n))   /* DMA_STREAM(2, 7) */
+
+/*
+ * Event flags as handed to callbacks, in the Stream 0 positions of LISR.
+ */
+#define DMA_FLAG_FE         0x01u       /* FIFO error */
+#define DMA_FLAG_DME        0x04u       /* direct mode error */
+#define DMA_FLAG_TE         0x08u       /* transfer error */
+#define DMA_FLAG_HT         0x10u       /* half transfer */
+#define DMA_FLAG_TC         0x20u       /* transfer complete */
+#define DMA_FLAG_ALL        0x3Du
+#define DMA_FLAG_ERRORS     (DMA_FLAG_FE | DMA_FLAG_DME | DMA_FLAG_TE)
+
+/**
+ * Return codes
+ */
+typedef enum {
+    dma_ok,
+    dma_conflict,       /* stream already claimed */
+    dma_invalid,        /* no such stream or channel */
+    dma_busy,           /* memory transfer still running */
+} dma_rc_t;
+
 /**
- * Initialise the DMA system.
+ * Called from the stream's interrupt with the flags that were raised.
+ */
+typedef void (*dma_callback_fn) (uint32_t flags, void *arg);
+
+typedef struct {
+    uint32_t transfers;     /* transfer complete */
+    uint32_t halves;        /* half transfer */
+    uint32_t errors;        /* transfer, direct mode or FIFO error */
+} dma_stats_t;
+
+/**
+ * Clock both controllers and release every stream.
  */
 extern void dma_init(void);
 
 /**
- * Configure a single DMA channel.
+ * Take a stream for 'chan'. 'cb' may be NULL if the stream's interrupt is
+ * not wanted. Returns dma_conflict, and counts it, if the stream is
+ * already claimed, or if the peripheral request on 'chan' is claimed on
+ * the other stream that can serve it.
+ */
+extern dma_rc_t dma_claim(uint32_t id, uint32_t chan, dma_callback_fn cb,
+                          void *arg);
+
+/**
+ * Stop a stream and give it back.
+ */
+extern void dma_release(uint32_t id);
+
+/**
+ * The stream's registers, for drivers that update a running stream.
+ */
+extern DMA_Stream_TypeDef *dma_stream(uint32_t id);
+
+/**
+ * Stop the stream, clear its flags and load the addresses, count, FIFO
+ * control and CR from 'cfg'. CHSEL comes from the claim and the stream
+ * is left disabled.
+ */
+extern void dma_configure(uint32_t id, DMA_Stream_TypeDef const *cfg);
+
+/**
+ * Enable the stream.
+ */
+extern void dma_start(uint32_t id);
+
+/**
+ * Disable the stream and wait for it to finish the current beat.
+ */
+extern void dma_stop(uint32_t id);
+
+/**
+ * Read and clear the stream's flags, counting them. A driver that polls
+ * a stream rather than waiting for its callback uses this so the counters
+ * stay right.
+ */
+extern uint32_t dma_ack(uint32_t id);
+
+extern void dma_get_stats(uint32_t id, dma_stats_t *stats);
+
+/**
+ * Stream interrupt service, called by the dispatcher.
+ */
+extern void dma_irq(uint32_t id);
+
+/**
+ * Claims refused because the stream, or its request on another stream,
+ * was taken.
+ */
+extern uint32_t dma_conflicts(void);
+
+/*
+ * Memory to memory service, on a stream of DMA2 (DMA1 cannot do memory to
+ * memory). Copies shorter than DMA_MEM_CROSSOVER bytes are done by the CPU,
+ * which finishes sooner than the DMA can be set up and its interrupt
+ * taken; the shell's bench command measures both paths so the crossover
+ * can be checked and moved.
+ */
+#define DMA_MEM_STREAM      DMA_STREAM(2, 1)
+#define DMA_MEM_CROSSOVER   64u
+
+/**
+ * Called when a memory transfer has finished, from the DMA interrupt, or
+ * before dma_memcpy()/dma_memset() return when the CPU did the work.
+ */
+typedef void (*dma_mem_done_fn) (bool ok, void *arg);
+
+/**
+ * Claim the memory to memory stream.
+ */
+extern dma_rc_t dma_mem_init(void);
+
+/**
+ * Copy 'len' bytes, or fill them with 'value'. Neither buffer may be
+ * touched until 'done' is called. Word aligned buffers and lengths go a
+ * word at a time, in 4-beat bursts if they are also 16 byte aligned.
+ * Returns dma_busy if the last transfer has not finished.
+ */
+extern dma_rc_t dma_memcpy(void *dst, void const *src, uint32_t len,
+                           dma_mem_done_fn done, void *arg);
+extern dma_rc_t dma_memset(void *dst, uint8_t value, uint32_t len,
+                           dma_mem_done_fn done, void *arg);
+
+/**
+ * True while a memory transfer is running.
+ */
+extern bool dma_mem_busy(void);
+
+/**
+ * Move the crossover, 0 to always use the DMA (an empty transfer still
+ * completes at once). Returns the old value.
  */
-extern void dma_init_dma1_chx(uint32_t str, DMA_Stream_TypeDef const *cfg);
+extern uint32_t dma_mem_crossover(uint32_t len);
 
 
-#endif
\ No newline at end of file
+#endif
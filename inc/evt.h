@@ -0,0 +1,75 @@
+/**
+  ******************************************************************************
+  * @file    evt.h
+  * @author  Joe Todd
+  * @version
+  * @date
+  * @brief   Header for evt.c
+  *
+  * Run-to-completion event loop. An event is one bit of a pending word,
+  * posted from anywhere, interrupts included; posting an event that is
+  * already pending just leaves it pending, so a burst of interrupts costs
+  * one handler run. The loop runs the pending event with the lowest id
+  * first, one handler at a time to completion, and sleeps with WFI when
+  * nothing is pending.
+  *
+  * A higher priority event therefore waits at most for the handler that
+  * is running, so handlers must not block: anything that waits is split
+  * at a timer alarm or an interrupt. evt_get_stats() reports the longest
+  * run of each handler, in core cycles, to check that bound.
+  ******************************************************************************
+*/
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef EVT_H
+#define EVT_H
+
+/* Includes ------------------------------------------------------------------*/
+#include "stdint.h"
+#include "stdbool.h"
+#include "stm32f4xx.h"
+#include "utl.h"
+
+/**
+ * Events, highest priority first.
+ */
+typedef enum {
+    evt_alarm,          /* timer alarm due: TIM5 */
+    evt_shell,          /* command frame arrived or reply sent */
+    evt_hold,           /* hold timer ran out: TIM2 */
+    evt_flush,          /* background log writes */
+    EVT_NUM
+} evt_id_t;
+
+typedef void (*evt_handler_fn) (void);
+
+typedef struct {
+    uint32_t posts;
+    uint32_t runs;          /* fewer than posts when posts coalesce */
+    uint32_t max_cycles;    /* longest single run */
+} evt_stats_t;
+
+/**
+ * Clear everything pending and every handler.
+ */
+extern void evt_init(void);
+
+/**
+ * Set the handler for an event. Posts to an event with no handler are
+ * dropped when it comes up.
+ */
+extern void evt_register(evt_id_t id, evt_handler_fn fn);
+
+/**
+ * Mark an event pending. Safe from any interrupt.
+ */
+extern void evt_post(evt_id_t id);
+
+/**
+ * Dispatch events for ever, sleeping whenever there are none.
+ */
+extern void evt_run(void) __attribute__((noreturn));
+
+extern void evt_get_stats(evt_id_t id, evt_stats_t *stats);
+
+#endif
@@ -0,0 +1,67 @@
+/**
+  ******************************************************************************
+  * @file    fault.h
+  * @author  Joe Todd
+  * @version
+  * @date
+  * @brief   Header for fault.c
+  *
+  * Post-mortem for HardFault, MemManage, BusFault and UsageFault. The
+  * handler saves the stacked exception frame, the fault status and
+  * address registers and the top of the faulting stack into a record in
+  * .noinit RAM, which the startup code does not clear, then resets. The
+  * next boot checks the record, keeps a copy for the shell's "fault"
+  * command and logs it.
+  *
+  * RAM survives a system reset but not a power cycle, so a record is only
+  * ever from the reset just gone. The fault count is kept apart from the
+  * record, so it runs on over any number of other resets in between.
+  ******************************************************************************
+*/
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef FAULT_H
+#define FAULT_H
+
+/* Includes ------------------------------------------------------------------*/
+#include "stdint.h"
+#include "stdbool.h"
+#include "stm32f4xx.h"
+
+#define FAULT_STACK_WORDS   16u
+
+typedef struct {
+    uint32_t magic;
+    uint32_t type;          /* exception: 3 hard, 4 mem, 5 bus, 6 usage */
+    uint32_t r0;            /* stacked frame */
+    uint32_t r1;
+    uint32_t r2;
+    uint32_t r3;
+    uint32_t r12;
+    uint32_t lr;
+    uint32_t pc;
+    uint32_t psr;
+    uint32_t exc_return;    /* LR on entry: which stack, FPU frame */
+    uint32_t sp;            /* frame address */
+    uint32_t cfsr;
+    uint32_t hfsr;
+    uint32_t mmfar;
+    uint32_t bfar;
+    uint32_t stack[FAULT_STACK_WORDS];  /* above the frame, 0 if off RAM */
+    uint32_t count;         /* faults since power up, this one included */
+    uint32_t check;         /* XOR of the words above, ~magic seeded */
+} fault_rec_t;
+
+/**
+ * Take over a record left by the last reset, and give MemManage, BusFault
+ * and UsageFault their own handlers instead of escalating to HardFault.
+ * Returns true if there was a record.
+ */
+extern bool fault_init(void);
+
+/**
+ * The record found at boot, or NULL if the last reset was not a fault.
+ */
+extern fault_rec_t const *fault_last(void);
+
+#endif
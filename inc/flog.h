@@ -0,0 +1,101 @@
+/**
+  ******************************************************************************
+  * @file    flog.h
+  * @author  Joe Todd
+  * @version
+  * @date
+  * @brief   Header for flog.c
+  *
+  * Event log in internal flash, sectors 3 and 4 (see stm32_flash.ld):
+  *
+  *     0x0800C000  sector 3   16KB
+  *     0x08010000  sector 4   64KB
+  *
+  * Each sector starts with a 16-byte header carrying a sequence number,
+  * followed by 12-byte records packed from the front. The sector with the
+  * higher sequence is being written; when it fills, the other one is
+  * erased and takes the next sequence, so the oldest history goes first.
+  ******************************************************************************
+*/
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef FLOG_H
+#define FLOG_H
+
+/* Includes ------------------------------------------------------------------*/
+#include "stdint.h"
+#include "stdbool.h"
+#include "stm32f4xx.h"
+#include "stm32f4xx_conf.h"
+#include "crc.h"
+
+#define FLOG_SECTORS        2u
+#define FLOG_STAGE          8u      /* records held in RAM between programs */
+
+/**
+ * Return codes
+ */
+typedef enum {
+    flog_ok,
+    flog_error,
+} flog_rc_t;
+
+typedef enum {
+    flog_type_moisture,
+    flog_type_water,
+    flog_type_reset,        /* zone = wdg_task_t, value = RCC_CSR >> 16 */
+    flog_type_fault,        /* zone = exception, value = CFSR low half */
+} flog_type_t;
+
+/**
+ * One record as stored. 'crc' is the CRC unit's result over the first two
+ * words; a slot whose time is still erased has never been written.
+ */
+typedef struct {
+    uint32_t time;
+    uint16_t value;
+    uint8_t zone;
+    uint8_t type;
+    uint32_t crc;
+} flog_rec_t;
+
+typedef struct {
+    uint32_t appended;
+    uint32_t programmed;
+    uint32_t erases;
+    uint32_t errors;        /* failed programs and erases */
+    uint32_t dropped;       /* appends refused while the stage was full */
+} flog_stats_t;
+
+/**
+ * Called oldest first by flog_walk(). Return false to stop.
+ */
+typedef bool (*flog_walk_fn) (flog_rec_t const *rec, void *arg);
+
+/**
+ * Find the sector being written and the end of the log in it. Formats the
+ * log if neither sector holds a valid header.
+ */
+extern flog_rc_t flog_init(void);
+
+/**
+ * Stage one record; the stage is programmed once it is full.
+ */
+extern flog_rc_t flog_append(uint32_t time, uint8_t zone, flog_type_t type,
+                             uint16_t value);
+
+/**
+ * Program whatever is staged. On an error the records not yet programmed
+ * stay staged, and flog_append() drops new ones once the stage is full.
+ */
+extern flog_rc_t flog_flush(void);
+
+/**
+ * Visit every programmed record whose CRC checks. Staged records are not
+ * included until they are flushed.
+ */
+extern void flog_walk(flog_walk_fn fn, void *arg);
+
+extern void flog_get_stats(flog_stats_t *stats);
+
+#endif
@@ -0,0 +1,55 @@
+/**
+  ******************************************************************************
+  * @file    hot.h
+  * @author  Joe Todd
+  * @version
+  * @date
+  * @brief   Header for hot.c
+  *
+  * Where the cycle had got to, in the RTC backup registers so that it
+  * outlives a reset (but not loss of VBAT). Times are rtc_now() seconds.
+  * With ZONE_MAX 16 it takes 17 of the 20 registers, magic and CRC included.
+  ******************************************************************************
+*/
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef HOT_H
+#define HOT_H
+
+/* Includes ------------------------------------------------------------------*/
+#include "stdint.h"
+#include "stdbool.h"
+#include "stm32f4xx.h"
+#include "crc.h"
+#include "zone.h"
+
+typedef struct {
+    uint32_t next_wake;     /* when the next sample cycle is due */
+    uint32_t uptime;        /* log time base, see main_stats */
+    uint32_t samples;
+    uint32_t waterings;
+    uint16_t level;         /* last reading, zone 0 */
+    uint16_t valve_busy;    /* 1 while the valve is open */
+    uint32_t valve_open;    /* when it was opened */
+    uint16_t valve_pulse;   /* length of the pulse in progress */
+    uint16_t valve_zone;    /* and whose valve it is */
+    uint16_t demand[ZONE_MAX]; /* each zone's PID output, see ctl_resume */
+} hot_t;
+
+/**
+ * Read the saved state. False, leaving 'hot' alone, if there is none or
+ * its checksum fails. The backup domain must already be open (rtc_init).
+ */
+extern bool hot_load(hot_t *hot);
+
+/**
+ * Save the state; a handful of register writes.
+ */
+extern void hot_save(hot_t const *hot);
+
+/**
+ * Forget the saved state.
+ */
+extern void hot_clear(void);
+
+#endif
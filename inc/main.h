@@ -26,6 +26,15 @@ typedef enum {
 	delay_flag_high,
 } delay_flag_t;
 
+typedef struct {
+    uint32_t uptime;        /* seconds, advanced once per cycle */
+    uint32_t samples;
+    uint32_t waterings;
+    uint32_t moisture;      /* last reading */
+} main_stats_t;
 
+extern main_stats_t main_stats;
 
-#endif /* __MAIN_H */
\ No newline at end of file
+
+
+#endif /* __MAIN_H */
\ No newline at end of file
@@ -0,0 +1,100 @@
+/**
+  ******************************************************************************
+  * @file    param.h
+  * @author  Joe Todd
+  * @version
+  * @date
+  * @brief   Header for param.c
+  *
+  * Run-time tunables. Each one has a name, so the shell can find it, and a
+  * range that every set is checked against. Saved values live in the
+  * flash config store (cfg.c). Pins are only configured at boot, so a
+  * pin change needs a save and a reset.
+  ******************************************************************************
+*/
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef PARAM_H
+#define PARAM_H
+
+/* Includes ------------------------------------------------------------------*/
+#include "stdint.h"
+#include "stdbool.h"
+#include "stm32f4xx.h"
+#include "cfg.h"
+
+/*
+ * Defaults, used until something has been saved.
+ */
+#define PARAM_MOIST_LEVEL   2048u
+#define PARAM_HOLD_TIME     (86400u / 2u)   /* one day - why are clock calculations out by 2? */
+#define PARAM_VALVE_PULSE   5u              /* seconds */
+#define PARAM_TESTING       0u              /* not testing mode */
+#define PARAM_SENSOR_EN_PORT 2u             /* iox_port_c */
+#define PARAM_SENSOR_EN_PIN 2u
+#define PARAM_VALVE_PORT    1u              /* iox_port_b */
+#define PARAM_VALVE_PIN     2u
+#define PARAM_DOSE_MAX      20u             /* seconds of valve at full demand */
+#define PARAM_KP            16384u          /* Q15, 0.5 */
+#define PARAM_KI            8192u           /* Q15, 0.25 */
+#define PARAM_KD            0u
+#define PARAM_SOAK_PULSE    10u             /* seconds */
+#define PARAM_SOAK_TIME     900u            /* seconds */
+#define PARAM_SOAK_BAND     200u            /* ADC counts */
+
+typedef struct {
+    uint32_t moist_level;   /* PID setpoint, ADC reading; higher is drier */
+    uint32_t hold_time;     /* sleep between cycles, TIM2 ticks at 0xF000 */
+    uint32_t valve_pulse;   /* shell water command, seconds */
+    uint32_t testing;       /* 2s cycle instead of a day */
+    uint32_t unused;        /* was the valve/stepper switch */
+    uint32_t sensor_en_port; /* iox_port_t powering the probe */
+    uint32_t sensor_en_pin;
+    uint32_t valve_port;    /* iox_port_t driving the valve */
+    uint32_t valve_pin;
+    uint32_t dose_max;      /* valve time at full PID demand, seconds */
+    uint32_t kp;            /* PID gains, Q15, see ctl.h */
+    uint32_t ki;
+    uint32_t kd;
+    uint32_t soak_pulse;    /* longest single valve pulse, seconds */
+    uint32_t soak_time;     /* wait after each pulse, seconds */
+    uint32_t soak_band;     /* stop once this far below the setpoint */
+    /* new fields go here, at the end */
+} param_t;
+
+extern param_t param;
+
+/**
+ * Load the saved values over the defaults. Returns true if saved values
+ * were found.
+ */
+extern bool param_init(void);
+
+/**
+ * Back to the defaults. Does not touch what is saved.
+ */
+extern void param_defaults(void);
+
+/**
+ * Write the current values to flash. False if the write failed.
+ */
+extern bool param_save(void);
+
+/**
+ * Number of parameters, and the name of the i'th, for listing.
+ */
+extern uint32_t param_count(void);
+extern char const *param_name(uint32_t i);
+
+/**
+ * Look up a value by name. False if there is no such parameter.
+ */
+extern bool param_get(char const *name, uint32_t *value);
+
+/**
+ * Set a value by name. False if there is no such parameter or the value
+ * is out of range, in which case nothing changes.
+ */
+extern bool param_set(char const *name, uint32_t value);
+
+#endif
@@ -0,0 +1,78 @@
+/**
+  ******************************************************************************
+  * @file    pool.h
+  * @author  Joe Todd
+  * @version
+  * @date
+  * @brief   Header for pool.c
+  *
+  * Fixed-block pools, in place of a heap (_Min_Heap_Size is 0). Each pool
+  * is a static array of equal blocks, sized at compile time with
+  * POOL_DEFINE, so memory use is known at link time and cannot fragment.
+  * Free blocks are kept on a list threaded through the blocks themselves:
+  * alloc and free each take one block off or put one on, O(1), with
+  * interrupts masked only for those few instructions, so both may be
+  * called from interrupts.
+  *
+  * Each pool counts its high-water mark and the allocations it refused,
+  * to size it from the field.
+  ******************************************************************************
+*/
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef POOL_H
+#define POOL_H
+
+/* Includes ------------------------------------------------------------------*/
+#include "stdint.h"
+#include "stdbool.h"
+#include "stm32f4xx.h"
+
+/*
+ * Blocks are rounded up to whole words, so every block is word aligned
+ * and can hold the free-list link.
+ */
+#define POOL_WORDS(size)    (((size) + 3u) / 4u)
+
+/**
+ * Storage and pool for 'blocks' blocks of 'size' bytes. pool_init() it
+ * before use.
+ */
+#define POOL_DEFINE(name, size, blocks) \
+    static uint32_t name##_mem[(blocks) * POOL_WORDS(size)]; \
+    static pool_t name = {name##_mem, POOL_WORDS(size) * 4u, (blocks), \
+                          0, 0, 0, 0}
+
+typedef struct {
+    void *mem;
+    uint32_t size;          /* bytes per block, a multiple of 4 */
+    uint32_t blocks;
+    void *free;             /* first free block */
+    uint32_t used;
+    uint32_t high;          /* most ever in use at once */
+    uint32_t exhausted;     /* allocations refused */
+} pool_t;
+
+/**
+ * Put every block on the free list and clear the counters.
+ */
+extern void pool_init(pool_t *pool);
+
+/**
+ * A block, or NULL, counted, if none are free.
+ */
+extern void *pool_alloc(pool_t *pool);
+
+/**
+ * Give a block back. It must have come from this pool.
+ */
+extern void pool_free(pool_t *pool, void *block);
+
+/**
+ * Blocks in use, now and at most.
+ */
+extern uint32_t pool_used(pool_t const *pool);
+extern uint32_t pool_high(pool_t const *pool);
+extern uint32_t pool_exhausted(pool_t const *pool);
+
+#endif
@@ -18,6 +18,7 @@
 #include "stm32f4xx.h"
 
 extern void clk_init(void);
+extern void clk_pll48_enable(void);
 
 
 #endif
\ No newline at end of file
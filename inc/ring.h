@@ -0,0 +1,88 @@
+/**
+  ******************************************************************************
+  * @file    ring.h
+  * @author  Joe Todd
+  * @version
+  * @date
+  * @brief   Header for ring.c
+  *
+  * Lock-free single-producer, single-consumer ring of fixed-size records,
+  * for handing data from an interrupt to the main loop or back. One side
+  * may only put and the other may only get, peek and drop; with that,
+  * neither side masks interrupts.
+  *
+  * head and tail are free-running counts: only the producer writes head
+  * and only the consumer writes tail, and head - tail is the fill even
+  * across the 32-bit wrap. The slot count is a power of two so the index
+  * is count & mask, and all the slots can be used.
+  *
+  * Ordering, with __DMB() between each pair:
+  *
+  *     producer    read tail | write record | publish head
+  *     consumer    read head | read record  | publish tail
+  *
+  * so a record is complete before it can be seen, and a slot is finished
+  * with before it can be reused. The Cortex-M4 does not reorder these
+  * itself, but the compiler may, and the barrier stops both.
+  ******************************************************************************
+*/
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef RING_H
+#define RING_H
+
+/* Includes ------------------------------------------------------------------*/
+#include "stdint.h"
+#include "stdbool.h"
+#include "stm32f4xx.h"
+
+typedef struct {
+    uint8_t *buf;
+    uint32_t size;              /* bytes per record */
+    uint32_t mask;              /* slots - 1 */
+    volatile uint32_t head;     /* records put, producer only */
+    volatile uint32_t tail;     /* records taken, consumer only */
+} ring_t;
+
+/**
+ * 'buf' holds 'slots' records of 'size' bytes; 'slots' must be a power of
+ * two. False, leaving the ring unusable, if it is not.
+ */
+extern bool ring_init(ring_t *ring, void *buf, uint32_t slots, uint32_t size);
+
+/**
+ * Producer: copy a record in. False if the ring is full.
+ */
+extern bool ring_put(ring_t *ring, void const *rec);
+
+/**
+ * Consumer: copy the oldest record out and free its slot. False if empty.
+ */
+extern bool ring_get(ring_t *ring, void *rec);
+
+/**
+ * Consumer: the oldest record in place, or NULL if empty. It stays valid
+ * until ring_drop().
+ */
+extern void *ring_peek(ring_t *ring);
+
+/**
+ * Consumer: free the oldest record's slot.
+ */
+extern void ring_drop(ring_t *ring);
+
+/**
+ * Byte rings (size 1): as many of 'len' bytes as fit or are waiting,
+ * in one pass, returning how many.
+ */
+extern uint32_t ring_write(ring_t *ring, void const *data, uint32_t len);
+extern uint32_t ring_read(ring_t *ring, void *data, uint32_t len);
+
+/**
+ * Either side: records waiting, and free slots. Only a snapshot, as the
+ * other side may be moving.
+ */
+extern uint32_t ring_count(ring_t const *ring);
+extern uint32_t ring_space(ring_t const *ring);
+
+#endif
@@ -0,0 +1,34 @@
+/**
+  ******************************************************************************
+  * @file    rtc.h
+  * @author  Joe Todd
+  * @version
+  * @date
+  * @brief   Header for rtc.c
+  *
+  ******************************************************************************
+*/
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef RTC_H
+#define RTC_H
+
+/* Includes ------------------------------------------------------------------*/
+#include "stdint.h"
+#include "stdbool.h"
+#include "stm32f4xx.h"
+
+/**
+ * Open the backup domain and keep the RTC counting seconds from LSI. The
+ * calendar is only set the first time, so it carries on across resets
+ * for as long as VBAT is held up. Returns true if it was already running.
+ */
+extern bool rtc_init(void);
+
+/**
+ * Seconds since the RTC was first started. LSI is only good to a few
+ * percent, which is fine for scheduling a daily cycle.
+ */
+extern uint32_t rtc_now(void);
+
+#endif
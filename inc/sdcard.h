@@ -0,0 +1,76 @@
+/**
+  ******************************************************************************
+  * @file    sdcard.h
+  * @author  Joe Todd
+  * @version
+  * @date
+  * @brief   Header for sdcard.c
+  *
+  ******************************************************************************
+*/
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef SDCARD_H
+#define SDCARD_H
+
+/* Includes ------------------------------------------------------------------*/
+#include "stdint.h"
+#include "stdbool.h"
+#include "stm32f4xx.h"
+#include "stm32f4xx_conf.h"
+#include "iox.h"
+#include "utl.h"
+#include "dma.h"
+#include "rcc.h"
+
+#define SDCARD_BLOCK_SIZE   512u
+
+/*
+ * SDIO_CK = 48MHz / (SDCARD_CLKDIV + 2) = 400kHz. The SDIO block needs
+ * PCLK2 >= 3/8 SDIO_CK, and PCLK2 is only 250kHz (see rcc.c), so the card
+ * clock cannot go any faster without raising HCLK.
+ */
+#define SDCARD_CLKDIV       118u
+
+/**
+ * Return codes
+ */
+typedef enum {
+    sdcard_ok,
+    sdcard_busy,
+    sdcard_error,
+} sdcard_rc_t;
+
+/**
+ * Power up the card and switch it to 4-bit transfer mode.
+ */
+extern sdcard_rc_t sdcard_init(void);
+
+/**
+ * Capacity in 512-byte blocks.
+ */
+extern uint32_t sdcard_blocks(void);
+
+/**
+ * Start a multi-block DMA write of 'count' blocks and return. 'buf' must be
+ * word aligned and left alone until sdcard_status() stops reporting busy.
+ */
+extern sdcard_rc_t sdcard_write(uint32_t block, void const *buf,
+                                uint32_t count);
+
+/**
+ * Read a single block, waiting for it to arrive.
+ */
+extern sdcard_rc_t sdcard_read(uint32_t block, void *buf);
+
+/**
+ * sdcard_ok once the last write has been programmed by the card.
+ */
+extern sdcard_rc_t sdcard_status(void);
+
+/**
+ * SDIO interrupt service, called by the dispatcher.
+ */
+extern void sdcard_irq(void);
+
+#endif
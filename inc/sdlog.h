@@ -0,0 +1,84 @@
+/**
+  ******************************************************************************
+  * @file    sdlog.h
+  * @author  Joe Todd
+  * @version
+  * @date
+  * @brief   Header for sdlog.c
+  *
+  * Card layout, in 512-byte blocks:
+  *
+  *     0       directory: header and up to SDLOG_MAX_SESSIONS entries
+  *     1...    capture sessions, back to back, raw little-endian 12-bit
+  *             samples in 16-bit words
+  *
+  * Each session reserves its extent when it starts, so capture only ever
+  * appends to a contiguous run of blocks and never touches the directory
+  * until it stops. A session left open by a reset keeps its whole
+  * reservation; the next one starts after it.
+  *
+  * Throughput (calculated for the clocks set up in rcc.c, not measured)
+  *
+  *     ADC      ADCCLK 125kHz, 15 cycles/sample  8.3ksps   16.7KB/s
+  *     SDIO     400kHz x 4 bits                            200KB/s burst
+  *     Half     4096 samples = 16 blocks, filled every     491ms
+  *     Write    16 blocks + CRC/stop overhead              ~45ms
+  *
+  * so each half-buffer write has ~440ms to absorb card busy time before
+  * the ADC laps it. SD cards may legally stall up to 250ms per write;
+  * laps that do overrun are counted in the directory entry.
+  ******************************************************************************
+*/
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef SDLOG_H
+#define SDLOG_H
+
+/* Includes ------------------------------------------------------------------*/
+#include "stdint.h"
+#include "stdbool.h"
+#include "sdcard.h"
+#include "adc.h"
+
+#define SDLOG_HALF_BLOCKS   16u
+#define SDLOG_HALF_SAMPLES  (SDLOG_HALF_BLOCKS * SDCARD_BLOCK_SIZE / 2u)
+#define SDLOG_MAX_SESSIONS  31u
+#define SDLOG_SAMPLE_RATE   8333u
+
+typedef struct {
+    uint32_t start;         /* first block */
+    uint32_t reserved;      /* blocks set aside */
+    uint32_t blocks;        /* blocks written, SDLOG_OPEN while running */
+    uint32_t overruns;      /* half-buffers lost */
+} sdlog_session_t;
+
+#define SDLOG_OPEN          0xFFFFFFFFu
+
+/**
+ * Initialise the card and read the directory, formatting a blank card.
+ */
+extern sdcard_rc_t sdlog_init(void);
+
+/**
+ * Open a new session of up to 'blocks' blocks (0 = rest of the card) and
+ * start the ADC streaming into it.
+ */
+extern sdcard_rc_t sdlog_start(uint32_t blocks);
+
+/**
+ * Hand full half-buffers to the card. Call often from the main loop.
+ * Returns false once the session has stopped.
+ */
+extern bool sdlog_service(void);
+
+/**
+ * Stop the ADC, write what is left and close the directory entry.
+ */
+extern void sdlog_stop(void);
+
+/**
+ * The current (or last) session.
+ */
+extern sdlog_session_t const *sdlog_session(void);
+
+#endif
@@ -0,0 +1,41 @@
+/**
+  ******************************************************************************
+  * @file    semi.h
+  * @author  Joe Todd
+  * @version
+  * @date
+  * @brief   Header for semi.c
+  *
+  * ARM semihosting: text out to the debugger's or emulator's console, and
+  * an exit status back to it. Each call is a BKPT 0xAB, which halts a
+  * board with no debugger attached, so only the builds that run under
+  * OpenOCD with semihosting enabled or under QEMU with -semihosting use
+  * it.
+  ******************************************************************************
+*/
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef SEMI_H
+#define SEMI_H
+
+/* Includes ------------------------------------------------------------------*/
+#include "stdint.h"
+#include "stdbool.h"
+
+/**
+ * Write a NUL-terminated string.
+ */
+extern void semi_puts(char const *s);
+
+/**
+ * Write 'v' in decimal.
+ */
+extern void semi_putu(uint32_t v);
+
+/**
+ * End the session, passing or failing. Does not return under a host;
+ * on a debugger that ignores it, spins.
+ */
+extern void semi_exit(bool ok) __attribute__((noreturn));
+
+#endif
@@ -0,0 +1,86 @@
+/**
+  ******************************************************************************
+  * @file    shell.h
+  * @author  Joe Todd
+  * @version
+  * @date
+  * @brief   Header for shell.c
+  *
+  * Line-based command interpreter on the UART. One frame is one command:
+  *
+  *     help                    list commands
+  *     get [name]              show one or all parameters
+  *     set <name> <value>      change a parameter until reset
+  *     save                    keep the parameters over a reset
+  *     defaults                back to the built-in parameters
+  *     sample                  read the probes now
+  *     water [pulse [zone]]    open a zone's valve now, zone 0 default
+  *     stats                   counters from each module
+  *     bench                   CPU against DMA memcpy/memset, in cycles
+  *     fault                   registers saved by the last crash
+  *     irq                     per-interrupt counts, run and wait cycles
+  *     hist <zone> [block [first]]
+  *                             readings kept in a zone's history, one
+  *                             block at a time, the newest by default
+  *
+  * sample only reports: the readings go out as telemetry and into stats,
+  * and the uptime, the logs and the hold are left alone. water runs
+  * alongside the hold. Replies are plain text, one line each, ending "ok"
+  * or "err".
+  ******************************************************************************
+*/
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef SHELL_H
+#define SHELL_H
+
+/* Includes ------------------------------------------------------------------*/
+#include "stdint.h"
+#include "stdbool.h"
+#include "uart.h"
+#include "param.h"
+#include "slog.h"
+#include "flog.h"
+#include "telem.h"
+#include "dma.h"
+#include "utl.h"
+#include "main.h"
+#include "zone.h"
+#include "evt.h"
+#include "wdg.h"
+#include "fault.h"
+#include "stm32f4xx_it.h"
+
+#define SHELL_LINE          48u
+#define SHELL_ARGS          4u
+#define SHELL_OUT           768u
+#define SHELL_BENCH_MAX     1024u   /* largest bench transfer, bytes */
+#define SHELL_HIST_MAX      32u     /* history samples per reply */
+
+/**
+ * Actions the shell asks the main loop to carry out.
+ */
+typedef enum {
+    shell_req_none,
+    shell_req_sample,
+    shell_req_water,
+} shell_req_t;
+
+/**
+ * Handle any commands that have arrived. Does nothing, and leaves the
+ * commands queued, while the previous reply is still being sent.
+ */
+extern void shell_poll(void);
+
+/**
+ * True if there is a command or a request waiting.
+ */
+extern bool shell_pending(void);
+
+/**
+ * Take the outstanding request, if any. 'arg' gets its argument: for
+ * water, the pulse in the low byte and the zone above it.
+ */
+extern shell_req_t shell_take_request(uint32_t *arg);
+
+#endif
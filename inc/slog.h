@@ -0,0 +1,103 @@
+/**
+  ******************************************************************************
+  * @file    slog.h
+  * @author  Joe Todd
+  * @version
+  * @date
+  * @brief   Header for slog.c
+  *
+  ******************************************************************************
+*/
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef SLOG_H
+#define SLOG_H
+
+/* Includes ------------------------------------------------------------------*/
+#include "stdint.h"
+#include "stdbool.h"
+#include "spiflash.h"
+
+/*
+ * Page buffers held in RAM while waiting to be programmed, and the
+ * largest number of flash sectors that will be indexed (4 bytes each).
+ */
+#define SLOG_NUM_BUFS       4u
+#define SLOG_MAX_SECTORS    256u
+
+/**
+ * Return codes
+ */
+typedef enum {
+    slog_ok,
+    slog_busy,
+    slog_full,
+    slog_error,
+} slog_rc_t;
+
+typedef enum {
+    slog_type_moisture,
+    slog_type_water,
+} slog_type_t;
+
+/**
+ * One 8-byte log record. 'tag' holds the zone in the high nibble and
+ * the record type in the low nibble.
+ */
+typedef struct {
+    uint32_t time;
+    uint16_t value;
+    uint8_t tag;
+    uint8_t check;
+} slog_rec_t;
+
+typedef struct {
+    uint32_t appended;
+    uint32_t dropped;
+    uint32_t erase_full;    /* of those, refused with the erase queue full */
+    uint32_t programs;
+    uint32_t erases;
+} slog_stats_t;
+
+/**
+ * Query callback, return false to stop the query early.
+ */
+typedef bool (*slog_query_fn) (slog_rec_t const *rec, void *arg);
+
+#define slog_rec_zone(rec)  ((rec)->tag >> 4)
+#define slog_rec_type(rec)  ((slog_type_t) ((rec)->tag & 0x0F))
+
+/**
+ * Probe the flash and rebuild the sector index from the sector headers.
+ */
+extern bool slog_init(void);
+
+/**
+ * Queue one record. Never waits for the flash; if every page buffer is
+ * waiting to be programmed, or a new sector is due while the erase queue
+ * is full, the record is dropped and slog_full returned.
+ * Timestamps must not go backwards.
+ */
+extern slog_rc_t slog_append(uint32_t time, uint8_t zone, slog_type_t type,
+                             uint16_t value);
+
+/**
+ * Queue the partly filled page buffer for programming.
+ */
+extern void slog_flush(void);
+
+/**
+ * Start the next program or erase if the flash is idle. Returns true
+ * while there is still work queued.
+ */
+extern bool slog_service(void);
+
+/**
+ * Call 'fn' for every programmed record with from <= time <= to.
+ */
+extern slog_rc_t slog_query(uint32_t from, uint32_t to, slog_query_fn fn,
+                            void *arg);
+
+extern void slog_get_stats(slog_stats_t *stats);
+
+#endif
@@ -0,0 +1,69 @@
+/**
+  ******************************************************************************
+  * @file    soak.h
+  * @author  Joe Todd
+  * @version
+  * @date
+  * @brief   Header for soak.c
+  *
+  * Cycle-and-soak watering. A zone's dose is given in pulses of at most
+  * param.soak_pulse seconds. After each one the water is left to soak in
+  * for param.soak_time seconds, then the probe is read again, and the
+  * zone stops early once it reads at or below setpoint - param.soak_band,
+  * the wet end of the hysteresis band. Heavy soil takes up water slower
+  * than a long pulse delivers it, so this is what keeps it from running
+  * off.
+  *
+  *     idle -> wait -> pulse -> soak -> settle -> wait ... -> idle
+  *               (valve)  (valve open)   (probe on)
+  *
+  * Every step is a timer alarm, so nothing blocks. Only one valve is open
+  * at a time, to keep the supply pressure up, and waiting zones take the
+  * valve in zone order, so other zones water while one soaks.
+  ******************************************************************************
+*/
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef SOAK_H
+#define SOAK_H
+
+/* Includes ------------------------------------------------------------------*/
+#include "stdint.h"
+#include "stdbool.h"
+#include "timer.h"
+#include "zone.h"
+#include "param.h"
+
+typedef enum {
+    soak_open,          /* valve about to open; value = seconds */
+    soak_close,         /* valve has shut; value = seconds it was open */
+    soak_reading,       /* re-measured after a soak; value = reading */
+    soak_done,          /* zone finished; value = seconds given in all */
+} soak_event_t;
+
+/**
+ * Told about each step, to log it and keep the hot state up to date.
+ */
+typedef void (*soak_event_fn) (uint32_t zone, soak_event_t ev,
+                               uint32_t value);
+
+extern void soak_init(soak_event_fn fn);
+
+/**
+ * Start giving a zone 'seconds' of water. With 'soak' false it is one
+ * pulse, however long, with no re-measuring: a manual or resumed dose.
+ * False if the zone is already being watered.
+ */
+extern bool soak_start(uint32_t zone, uint32_t seconds, bool soak);
+
+/**
+ * Shut the valve and drop every zone's remaining dose.
+ */
+extern void soak_stop(void);
+
+/**
+ * True while any zone is still being watered.
+ */
+extern bool soak_busy(void);
+
+#endif
@@ -0,0 +1,59 @@
+/**
+  ******************************************************************************
+  * @file    spiflash.h
+  * @author  Joe Todd
+  * @version
+  * @date
+  * @brief   Header for spiflash.c
+  *
+  ******************************************************************************
+*/
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef SPIFLASH_H
+#define SPIFLASH_H
+
+/* Includes ------------------------------------------------------------------*/
+#include "stdint.h"
+#include "stdbool.h"
+#include "stm32f4xx.h"
+#include "iox.h"
+
+/*
+ * Geometry common to 25-series SPI NOR parts (W25Qxx, MX25Lxx, ...).
+ */
+#define SPIFLASH_PAGE_SIZE      256u
+#define SPIFLASH_SECTOR_SIZE    4096u
+
+/**
+ * Initialise SPI1 and probe the chip. Returns false if nothing answers.
+ */
+extern bool spiflash_init(void);
+
+/**
+ * Size of the chip in bytes, from the JEDEC capacity code.
+ */
+extern uint32_t spiflash_size(void);
+
+/**
+ * True while a program or erase is in progress inside the chip.
+ */
+extern bool spiflash_busy(void);
+
+/**
+ * Read 'len' bytes from 'addr'. Must not be called while busy.
+ */
+extern void spiflash_read(uint32_t addr, void *buf, uint32_t len);
+
+/**
+ * Start programming up to one page. Returns without waiting for the chip;
+ * poll spiflash_busy() before issuing the next command.
+ */
+extern void spiflash_program(uint32_t addr, void const *buf, uint32_t len);
+
+/**
+ * Start erasing the 4KB sector containing 'addr'. Returns without waiting.
+ */
+extern void spiflash_erase_sector(uint32_t addr);
+
+#endif
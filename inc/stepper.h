@@ -20,4 +20,9 @@ extern void stepper_init(void);
 extern void stepper_turn_cw(uint16_t turns);
 extern void stepper_turn_acw(uint16_t turns);
 
+/**
+ * Drive the coils for half phase state 'state' (0-7), without waiting.
+ */
+extern void stepper_step(uint32_t state);
+
 #endif
\ No newline at end of file
@@ -1,63 +1,85 @@
 /**
   ******************************************************************************
-  * @file    stm32f4xx_it.h 
-  * @author  MCD Application Team
-  * @version V1.0.0
-  * @date    11-September-2013
-  * @brief   This file contains the headers of the interrupt handlers.
-  ******************************************************************************
-  * @attention
-  *
-  * <h2><center>&copy; COPYRIGHT 2013 STMicroelectronics</center></h2>
+  * @file    stm32f4xx_it.h
+  * @author  Joe Todd
+  * @version
+  * @date
+  * @brief   Header for stm32f4xx_it.c
   *
-  * Licensed under MCD-ST Liberty SW License Agreement V2, (the "License");
-  * You may not use this file except in compliance with the License.
-  * You may obtain a copy of the License at:
+  * Interrupt dispatch. Every peripheral vector the application uses is
+  * defined here and calls its driver's service function, timed with the
+  * DWT cycle counter. For each source it keeps:
   *
-  *        http://www.st.com/software_license_agreement_liberty_v2
-  *
-  * Unless required by applicable law or agreed to in writing, software 
-  * distributed under the License is distributed on an "AS IS" BASIS, 
-  * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
-  * See the License for the specific language governing permissions and
-  * limitations under the License.
+  *     count           entries
+  *     max_cycles      longest single run of the service function
+  *     total_cycles    sum of the runs, to compare against sampling time
+  *     max_latency     longest wait from pending to entry
+  *     total_latency
   *
+  * The NVIC does not timestamp a request, so latency is the time a source
+  * was seen pending by the dispatcher, at the entry or exit of another
+  * handler, before it was taken. It catches waits behind other handlers
+  * but not behind PRIMASK sections, so it is a lower bound. Every source
+  * is at the reset priority, so handlers never nest and the counters need
+  * no locking.
   ******************************************************************************
-  */ 
+*/
 
 /* Define to prevent recursive inclusion -------------------------------------*/
-#ifndef __STM32F4xx_IT_H
-#define __STM32F4xx_IT_H
-
-#ifdef __cplusplus
- extern "C" {
-#endif 
+#ifndef STM32F4XX_IT_H
+#define STM32F4XX_IT_H
 
 /* Includes ------------------------------------------------------------------*/
-#include "usb_conf.h"
-
-/* Exported types ------------------------------------------------------------*/
-/* Exported constants --------------------------------------------------------*/
-/* Exported macro ------------------------------------------------------------*/
-/* Exported functions ------------------------------------------------------- */
-
-void NMI_Handler(void);
-void HardFault_Handler(void);
-void MemManage_Handler(void);
-void BusFault_Handler(void);
-void UsageFault_Handler(void);
-void SVC_Handler(void);
-void DebugMon_Handler(void);
-void PendSV_Handler(void);
-void SysTick_Handler(void);
-void EXTI0_IRQHandler(void);
-void OTG_FS_WKUP_IRQHandler(void);
-void OTG_FS_IRQHandler(void);
-
-#ifdef __cplusplus
-}
-#endif
+#include "stdint.h"
+#include "stm32f4xx.h"
+#include "utl.h"
+
+/**
+ * Dispatched sources.
+ */
+typedef enum {
+    it_tim2,            /* hold timer */
+    it_tim5,            /* alarms */
+    it_usart1,
+    it_sdio,
+    it_dma1_s0,
+    it_dma1_s1,
+    it_dma1_s2,
+    it_dma1_s3,
+    it_dma1_s4,
+    it_dma1_s5,
+    it_dma1_s6,
+    it_dma1_s7,
+    it_dma2_s0,
+    it_dma2_s1,
+    it_dma2_s2,
+    it_dma2_s3,
+    it_dma2_s4,
+    it_dma2_s5,
+    it_dma2_s6,
+    it_dma2_s7,
+    IT_NUM
+} it_id_t;
 
-#endif /* __STM32F4xx_IT_H */
+typedef struct {
+    uint32_t count;
+    uint32_t max_cycles;
+    uint32_t total_cycles;
+    uint32_t max_latency;
+    uint32_t total_latency;
+} it_stats_t;
 
-/************************ (C) COPYRIGHT STMicroelectronics *****END OF FILE****/ 
+/**
+ * Clear the counters and start the cycle counter. Call before any source
+ * is enabled.
+ */
+extern void it_init(void);
+
+extern void it_get_stats(it_id_t id, it_stats_t *stats);
+
+/**
+ * Short name of a source, for reports.
+ */
+extern char const *it_name(it_id_t id);
+
+#endif
@@ -0,0 +1,95 @@
+/**
+  ******************************************************************************
+  * @file    telem.h
+  * @author  Joe Todd
+  * @version
+  * @date
+  * @brief   Header for telem.c
+  *
+  * Record layout, little-endian, before framing:
+  *
+  *     0   version         TELEM_VERSION
+  *     1   type            telem_type_t
+  *     2   seq             u16, increments per record
+  *     4   time            u32, seconds
+  *     8   payload         4 or 8 bytes, see below
+  *     n   crc             u32, CRC unit over bytes 0..n-1 as LE words
+  *
+  *     sample      zone u8, pad u8, value u16
+  *     water       zone u8, pad u8, amount u16
+  *     counter     id u16, pad u16, value u32
+  *     fault       code u16, aux u16, value u32
+  *
+  * Fault codes: 1 watchdog reset (aux task, value RCC_CSR), 2 crash (aux
+  * exception number, value faulting PC).
+  *
+  * The record is COBS encoded and terminated with a zero byte, so a
+  * receiver can resynchronise on any zero. tools/telem_decode.py turns a
+  * captured stream into CSV.
+  *
+  * Cost: the COBS loop alone runs over each of the 16 to 20 record bytes,
+  * and HCLK is 250kHz, so one cycle is 4us and a record takes hundreds of
+  * microseconds, not a handful. The telem_encode case in 'make bench'
+  * times it with the DWT counter.
+  ******************************************************************************
+*/
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef TELEM_H
+#define TELEM_H
+
+/* Includes ------------------------------------------------------------------*/
+#include "stdint.h"
+#include "stdbool.h"
+#include "uart.h"
+#include "crc.h"
+#include "pool.h"
+
+#define TELEM_VERSION       1u
+#define TELEM_MAX_RECORD    20u
+#define TELEM_MAX_FRAME     (TELEM_MAX_RECORD + 2u)     /* COBS + delimiter */
+#define TELEM_FRAMES        8u
+
+typedef enum {
+    telem_sample = 1,
+    telem_water,
+    telem_counter,
+    telem_fault,
+} telem_type_t;
+
+/**
+ * Enable the CRC unit.
+ */
+extern void telem_init(void);
+
+/**
+ * Build one framed record into 'out' (TELEM_MAX_FRAME bytes). 'len' must
+ * be 4 or 8. Returns the number of bytes written.
+ */
+extern uint32_t telem_encode(uint8_t *out, telem_type_t type, uint32_t time,
+                             void const *payload, uint32_t len);
+
+/**
+ * Encode a record and queue it on the UART. Returns false, and counts it,
+ * if every frame buffer is still waiting to go out.
+ */
+extern bool telem_send(telem_type_t type, uint32_t time,
+                       void const *payload, uint32_t len);
+
+extern bool telem_send_sample(uint32_t time, uint8_t zone, uint16_t value);
+extern bool telem_send_water(uint32_t time, uint8_t zone, uint16_t amount);
+extern bool telem_send_counter(uint32_t time, uint16_t id, uint32_t value);
+extern bool telem_send_fault(uint32_t time, uint16_t code, uint16_t aux,
+                             uint32_t value);
+
+/**
+ * Records not sent for lack of a frame buffer.
+ */
+extern uint32_t telem_dropped(void);
+
+/**
+ * Most frame buffers ever in use at once, out of TELEM_FRAMES.
+ */
+extern uint32_t telem_frames_high(void);
+
+#endif
@@ -2,10 +2,67 @@
 #define TIMER_H
 
 #include "stm32f4xx.h"
+#include "stdbool.h"
 #include "utl.h"
 
 extern void timer_init(void);
 extern void timer_delay(uint16_t time);
 extern void timer_reconfigure(uint16_t prescalar, uint16_t reload);
+extern bool timer_expired(void);
+
+/*
+ * Alarms: one-shot software timers on free-running 32-bit TIM5, which
+ * ticks at 1ms (prescaler 0x001e, as the stepper's 1ms tick). Only the
+ * earliest alarm is loaded into the compare register, so the timer costs
+ * an interrupt per alarm rather than per tick. Callbacks run from
+ * timer_poll(), never from the interrupt; the interrupt posts evt_alarm
+ * for that, as the TIM2 overflow posts evt_hold.
+ */
+typedef void (*timer_alarm_fn) (void *arg);
+
+typedef struct timer_alarm {
+    struct timer_alarm *next;
+    uint32_t due;
+    timer_alarm_fn fn;
+    void *arg;
+} timer_alarm_t;
+
+/**
+ * Start TIM5 and clear the alarm list.
+ */
+extern void timer_alarm_init(void);
+
+/**
+ * Milliseconds since timer_alarm_init(), wrapping at 32 bits.
+ */
+extern uint32_t timer_now(void);
+
+/**
+ * (Re)arm 'alarm' to call 'fn' 'ms' from now.
+ */
+extern void timer_alarm_start(timer_alarm_t *alarm, uint32_t ms,
+                              timer_alarm_fn fn, void *arg);
+
+/**
+ * Disarm; harmless if it is not armed.
+ */
+extern void timer_alarm_stop(timer_alarm_t *alarm);
+
+/**
+ * True if an alarm has come due and timer_poll() has not run it yet.
+ * Check with interrupts masked before sleeping.
+ */
+extern bool timer_due(void);
+
+/**
+ * Run the callbacks of every alarm that has come due.
+ */
+extern void timer_poll(void);
+
+/**
+ * Interrupt service for TIM2 and TIM5, called by the dispatcher.
+ */
+extern void timer_hold_irq(void);
+extern void timer_alarm_irq(void);
 
 #endif
\ No newline at end of file
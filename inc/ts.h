@@ -0,0 +1,106 @@
+/**
+  ******************************************************************************
+  * @file    ts.h
+  * @author  Joe Todd
+  * @version
+  * @date
+  * @brief   Header for ts.c
+  *
+  * Compressed time series held in RAM, for history that has to cover
+  * weeks on a 64KB part. A series is a ring of fixed-size blocks; each
+  * block starts with one raw sample and packs the rest as bit codes:
+  *
+  *     time    delta of delta, seconds      value   delta, after >> shift
+  *     0                   = 0     1 bit    0                   = 0    1 bit
+  *     10   + 4 bits zz    <= 8    6        10   + 1 bit zz     = 1    3
+  *     110  + 12 bits zz           15       110  + 6 bits zz           9
+  *     1110 + 20 bits zz           24       1110 + 12 bits zz          16
+  *     1111 + 32 bits zz           36       1111 + 17 bits zz          21
+  *
+  * (zz = zig-zag of a signed delta, so small steps either way stay short.)
+  * A regular sample interval costs 1 bit of time, and a value that moved
+  * by one quantisation step costs 3.
+  *
+  * Daily moisture readings kept to 8 bits (shift 4), drifting and with
+  * +-4 counts of noise, pack at 3.1 bits a sample including the header
+  * of each 64-byte block: 5.2x the 16 bits of a raw reading, which had
+  * no timestamp at all. A second of jitter twice a week brings it to
+  * 4.8 bits, 3.3x. (Measured by feeding ts.c synthetic data on a PC.)
+  * Most of that is the shift throwing the noise away: the same readings
+  * kept whole (shift 0) take 9.7 bits a sample, 1.6x.
+  *
+  * Appending never touches earlier blocks, and a full ring drops its
+  * oldest block, so append is O(1). Each block decodes on its own.
+  ******************************************************************************
+*/
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef TS_H
+#define TS_H
+
+/* Includes ------------------------------------------------------------------*/
+#include "stdint.h"
+#include "stdbool.h"
+
+#define TS_BLOCK_SIZE       64u
+#define TS_BLOCK_WORDS      ((TS_BLOCK_SIZE - 8u) / 4u)
+#define TS_BLOCK_BITS       (TS_BLOCK_WORDS * 32u)
+
+typedef struct {
+    uint32_t t0;            /* first sample, raw */
+    uint16_t v0;
+    uint16_t count;         /* samples in the block, including the first */
+    uint32_t bits[TS_BLOCK_WORDS];
+} ts_block_t;
+
+typedef struct {
+    ts_block_t *blocks;
+    uint32_t nblocks;
+    uint32_t head;          /* block being appended to */
+    uint32_t used;          /* blocks holding samples */
+    uint32_t shift;         /* values are kept >> shift */
+    uint32_t nbits;         /* bits used in the head block */
+    uint32_t last_t;
+    uint32_t last_dt;
+    uint16_t last_v;
+} ts_series_t;
+
+typedef struct {
+    uint32_t time;
+    uint16_t value;
+} ts_sample_t;
+
+/**
+ * Start an empty series on 'nblocks' caller-owned blocks. Values lose
+ * their low 'shift' bits, e.g. 4 keeps 8 of the ADC's 12 bits.
+ */
+extern void ts_init(ts_series_t *s, ts_block_t *blocks, uint32_t nblocks,
+                    uint32_t shift);
+
+extern void ts_append(ts_series_t *s, uint32_t time, uint16_t value);
+
+/**
+ * Blocks holding samples; block 0 is the oldest.
+ */
+extern uint32_t ts_blocks(ts_series_t const *s);
+
+/**
+ * Samples in the series.
+ */
+extern uint32_t ts_count(ts_series_t const *s);
+
+/**
+ * Decode block 'i' into 'out', at most 'max' samples starting with its
+ * sample 'first'. Returns the number decoded. A block holds at most
+ * TS_BLOCK_BITS + 1 samples; the ones before 'first' are still decoded,
+ * just not kept.
+ */
+extern uint32_t ts_decode(ts_series_t const *s, uint32_t i, uint32_t first,
+                          ts_sample_t *out, uint32_t max);
+
+/**
+ * The most recent sample, false if the series is empty.
+ */
+extern bool ts_last(ts_series_t const *s, ts_sample_t *last);
+
+#endif
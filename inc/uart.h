@@ -17,18 +17,105 @@
 #include "stm32f4xx.h"
 #include "iox.h"
 #include "utl.h"
+#include "dma.h"
+#include "ring.h"
 
 /* Definitions ---------------------------------------------------------------*/
-#define PCLK2		16000000
+#define PCLK2		250000u     /* HCLK, see rcc.c */
 #define RX_BUFFER_SIZE 4096
+#define RX_MAX_FRAMES   8u      /* power of two, see ring.h */
 
-#define UART_DMA	DMA2_Stream2
+#define UART_DMA	DMA_STREAM(2, 2)
+
+#define UART_TX_DMA	DMA_STREAM(2, 7)
+#define UART_TX_SLOTS   8u
 
 typedef void (*uart_recv_callback_fn) (uint8_t bytes);
 
+/**
+ * Transmit completion, called from the DMA interrupt once the buffer is
+ * no longer needed.
+ */
+typedef void (*uart_tx_done_fn) (void *arg);
+
+/**
+ * One caller-owned buffer to transmit. The descriptor and the buffer both
+ * belong to the driver from uart_tx_submit() until 'done' is called.
+ */
+typedef struct uart_tx_desc uart_tx_desc_t;
+
+struct uart_tx_desc {
+    uint8_t const *buf;
+    uint32_t len;
+    uart_tx_done_fn done;
+    void *arg;
+    uart_tx_desc_t *next;
+};
+
+/**
+ * A received frame, in place in the receive ring. It wraps into a second
+ * segment when it crosses the end of the ring (len[1] is 0 otherwise).
+ */
+typedef struct {
+    uint8_t const *seg[2];
+    uint32_t len[2];
+    uint32_t total;
+} uart_frame_t;
+
+/**
+ * Start USART1 (TX PA9, RX PA10) with reception running on DMA.
+ */
 extern void uart_init(uint32_t baudrate);
+
+/**
+ * Queue 'len' bytes without copying them; 'buf' must stay untouched until
+ * uart_tx_idle(). Waits only if all UART_TX_SLOTS are in flight.
+ */
 extern void uart_send_data(unsigned char *buf, uint32_t len);
+
+/**
+ * Queue a descriptor. Buffers go out back to back in submission order.
+ * An empty buffer is not sent; 'done' is called at once.
+ */
+extern void uart_tx_submit(uart_tx_desc_t *desc);
+
+/**
+ * True when nothing is queued or being sent.
+ */
+extern bool uart_tx_idle(void);
 extern uint8_t uart_get_byte(uint32_t i);
+
+/**
+ * Oldest received frame, false if there is none. The frame stays valid
+ * until uart_frame_release().
+ */
+extern bool uart_frame_get(uart_frame_t *frame);
+
+/**
+ * Give the oldest frame's bytes back to the ring. Returns false if the
+ * DMA lapped the frame before it was released, i.e. it was corrupted.
+ */
+extern bool uart_frame_release(void);
+
+/**
+ * Frames lost because the frame queue was full.
+ */
+extern uint32_t uart_rx_dropped(void);
+
+/**
+ * Transmit buffers dropped because the DMA reported a transfer error.
+ */
+extern uint32_t uart_tx_errors(void);
+
+/**
+ * USART1 interrupt service, called by the dispatcher.
+ */
+extern void uart_irq(void);
+
+/**
+ * Called from the receive interrupt with the number of frames waiting.
+ * The default does nothing; define it to be woken on reception.
+ */
 extern void data_recv_callback(uint8_t bytes);
 
 #endif
\ No newline at end of file
@@ -3,8 +3,16 @@
 #define UTL_H
 
 /* Includes ------------------------------------------------------------------*/
+#include "stdint.h"
 #include "stm32f4xx.h"
 
+/*
+ * DWT cycle counter, not described by this version of core_cm4.h.
+ */
+#define UTL_DWT_CTRL        (*(volatile uint32_t *) 0xE0001000u)
+#define UTL_DWT_CYCCNT      (*(volatile uint32_t *) 0xE0001004u)
+#define UTL_DWT_CYCCNTENA   0x00000001u
+
 /**
  * Enable an interrupt.
  */
@@ -15,4 +23,18 @@ extern void utl_enable_irq(IRQn_Type irq);
  */
 extern void utl_disable_irq(IRQn_Type irq);
 
+/**
+ * Start the DWT cycle counter.
+ */
+extern void utl_cycles_init(void);
+
+/**
+ * Core clock cycles, wrapping at 32 bits. Subtract two readings.
+ */
+static inline uint32_t
+utl_cycles(void)
+{
+    return UTL_DWT_CYCCNT;
+}
+
 #endif /* __UTL_H */
\ No newline at end of file
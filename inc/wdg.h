@@ -0,0 +1,89 @@
+/**
+  ******************************************************************************
+  * @file    wdg.h
+  * @author  Joe Todd
+  * @version
+  * @date
+  * @brief   Header for wdg.c
+  *
+  * Independent watchdog with a task supervisor. The IWDG runs from LSI and
+  * resets the part if it goes WDG_TIMEOUT_MS without a reload. Only the
+  * supervisor reloads it, from a timer alarm every WDG_CHECK_MS, and only
+  * while every armed task is inside its deadline:
+  *
+  *     loop        implicit: the supervisor's alarm only runs if the event
+  *                 loop does, so a handler stuck in a busy-wait stops the
+  *                 reloads by itself
+  *     sample      probes powered, waiting to settle
+  *     valve       valve open, for the pulse plus a margin
+  *     hold        hold timer running, for the hold plus a margin
+  *
+  * A task is armed with wdg_start() and disarmed with wdg_stop(). Every
+  * task here is one stretch of waiting with a known length, so none
+  * needs to check in part way.
+  *
+  * The timeout is the longest the IWDG has, reload 4000 at LSI / 256, so
+  * the supervisor only wakes the part every WDG_CHECK_MS. LSI is only
+  * good to 17-47kHz: at the top of that the timeout is 22s, still clear
+  * of the check. A late task is seen up to WDG_CHECK_MS after its
+  * deadline, and the reset follows within WDG_TIMEOUT_MS.
+  *
+  * Each pass names the task to blame if the next reload never comes, in
+  * RTC backup register 19: the loop normally, or the overdue task. After
+  * the reset wdg_init() reads it back with the RCC reset flags.
+  ******************************************************************************
+*/
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef WDG_H
+#define WDG_H
+
+/* Includes ------------------------------------------------------------------*/
+#include "stdint.h"
+#include "stdbool.h"
+#include "stm32f4xx.h"
+#include "stm32f4xx_conf.h"
+#include "timer.h"
+
+#define WDG_TIMEOUT_MS      32000u      /* at LSI 32kHz */
+#define WDG_CHECK_MS        16000u
+
+typedef enum {
+    wdg_task_loop,
+    wdg_task_sample,
+    wdg_task_valve,
+    wdg_task_hold,
+    WDG_TASKS,
+    wdg_task_none = 0xFF,
+} wdg_task_t;
+
+/**
+ * Why the last reset happened.
+ */
+typedef struct {
+    uint32_t flags;         /* RCC_CSR reset flags, bits 25..31 */
+    wdg_task_t task;        /* to blame, if the IWDG did it */
+} wdg_reset_t;
+
+/**
+ * Latch and clear the reset cause, start the IWDG and the supervisor.
+ * The backup domain must be open (rtc_init) and TIM5 running
+ * (timer_alarm_init). The IWDG cannot be stopped again.
+ */
+extern void wdg_init(void);
+
+/**
+ * Arm a task: it must check in or stop within 'ms'.
+ */
+extern void wdg_start(wdg_task_t task, uint32_t ms);
+
+extern void wdg_stop(wdg_task_t task);
+
+extern void wdg_last_reset(wdg_reset_t *reset);
+
+/**
+ * True if the last reset was the IWDG.
+ */
+extern bool wdg_was_reset(void);
+
+#endif
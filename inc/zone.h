@@ -0,0 +1,104 @@
+/**
+  ******************************************************************************
+  * @file    zone.h
+  * @author  Joe Todd
+  * @version
+  * @date
+  * @brief   Header for zone.c
+  *
+  * Watering zones: one soil probe and one valve each, up to ZONE_MAX.
+  * Each zone is a table entry with its ADC channel, probe excitation pin,
+  * valve pin and setpoint, plus its own controller and history.
+  *
+  * A cycle powers every probe at once, waits one shared settle time, and
+  * reads them all in a single ADC scan, so sampling costs the same 2s
+  * however many zones there are. The wait is the caller's, on a timer
+  * alarm, between zone_sample_start() and zone_sample_end(); probes are
+  * counted on and off, so a zone being re-read on its own meanwhile keeps
+  * its probe powered. The controllers then run once per zone,
+  * and the valves open one at a time in zone order to keep the supply
+  * pressure up. Nothing in a cycle is more than O(zones).
+  ******************************************************************************
+*/
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef ZONE_H
+#define ZONE_H
+
+/* Includes ------------------------------------------------------------------*/
+#include "stdint.h"
+#include "stdbool.h"
+#include "iox.h"
+#include "adc.h"
+#include "ctl.h"
+#include "ts.h"
+
+#define ZONE_MAX            ADC_SCAN_MAX
+#define ZONE_HISTORY_BLOCKS 4u      /* 500+ daily readings per zone */
+#define ZONE_FLOW_BLOCKS    2u
+#define ZONE_SETTLE_MS      2000u   /* probe on to reading */
+
+typedef struct {
+    uint8_t chan;           /* ADC1 channel of the probe */
+    uint8_t en_port;        /* iox_port_t powering the probe */
+    uint8_t en_pin;
+    uint8_t valve_port;     /* iox_port_t driving the valve */
+    uint8_t valve_pin;
+    uint16_t setpoint;      /* ADC reading the controller holds */
+} zone_cfg_t;
+
+typedef struct {
+    zone_cfg_t cfg;
+    uint16_t level;         /* last reading */
+    uint32_t dose;          /* valve seconds wanted this cycle */
+    ctl_t ctl;
+    ts_series_t history;    /* readings */
+    ts_series_t flow;       /* valve open time per watering */
+} zone_t;
+
+/**
+ * Load the table, set up the pins and clear the controllers and history.
+ * Returns the number of zones taken, at most ZONE_MAX; an entry whose
+ * channel has no pin stops the table there.
+ */
+extern uint32_t zone_init(zone_cfg_t const *table, uint32_t n);
+
+extern uint32_t zone_count(void);
+extern zone_t *zone_get(uint32_t i);
+
+/**
+ * Power every probe for a scan; ZONE_SETTLE_MS later, zone_sample_end().
+ */
+extern void zone_sample_start(void);
+
+/**
+ * Read every zone in one scan, append the readings to the histories and
+ * power the probes back down. False if the scan could not run, leaving
+ * the last readings in place.
+ */
+extern bool zone_sample_end(uint32_t time);
+
+/**
+ * Run each zone's controller on its reading and set its dose.
+ */
+extern void zone_control(uint16_t kp, uint16_t ki, uint16_t kd,
+                         uint32_t dose_max);
+
+/**
+ * Power one zone's probe, for a reading on its own with zone_read(). Each
+ * 'on' needs an 'off'.
+ */
+extern void zone_probe(uint32_t i, bool on);
+
+/**
+ * Read one zone now; its probe must have been on for ZONE_SETTLE_MS. The
+ * reading goes into the zone and its history. False if it could not run.
+ */
+extern bool zone_read(uint32_t i, uint32_t time);
+
+/**
+ * Open or shut a zone's valve.
+ */
+extern void zone_valve(uint32_t i, bool open);
+
+#endif
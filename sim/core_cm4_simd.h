@@ -0,0 +1,197 @@
+/**
+  ******************************************************************************
+  * @file    core_cm4_simd.h
+  * @author  Joe Todd
+  * @version
+  * @date
+  * @brief   Host build shadow of the CMSIS Cortex-M4 SIMD intrinsics
+  *
+  * Plain C for the subset that arm_math.h refers to, so that its inline
+  * functions, arm_pid_q15() among them, compile and behave as on target.
+  ******************************************************************************
+*/
+
+#ifndef __CORE_CM4_SIMD_H
+#define __CORE_CM4_SIMD_H
+
+#include <stdint.h>
+
+#define __SIM_LO(x)         ((int32_t) (int16_t) (x))
+#define __SIM_HI(x)         ((int32_t) (int16_t) ((uint32_t) (x) >> 16))
+#define __SIM_PACK(lo, hi)  \
+    ((uint32_t) (((uint32_t) (lo) & 0xFFFFu) | ((uint32_t) (hi) << 16)))
+
+static inline int32_t
+__sim_sat8(int32_t v)
+{
+    return (v > 127) ? 127 : (v < -128) ? -128 : v;
+}
+
+static inline int32_t
+__sim_sat16(int32_t v)
+{
+    return (v > 32767) ? 32767 : (v < -32768) ? -32768 : v;
+}
+
+static inline uint32_t
+__sim_bytes(uint32_t x, uint32_t y, int sub)
+{
+    uint32_t r = 0;
+    uint32_t i;
+    int32_t a;
+    int32_t b;
+
+    for (i = 0; i < 32u; i += 8u) {
+        a = (int8_t) (x >> i);
+        b = (int8_t) (y >> i);
+        r |= ((uint32_t) __sim_sat8(sub ? a - b : a + b) & 0xFFu) << i;
+    }
+
+    return r;
+}
+
+static inline uint32_t
+__QADD8(uint32_t x, uint32_t y)
+{
+    return __sim_bytes(x, y, 0);
+}
+
+static inline uint32_t
+__QSUB8(uint32_t x, uint32_t y)
+{
+    return __sim_bytes(x, y, 1);
+}
+
+static inline uint32_t
+__QADD16(uint32_t x, uint32_t y)
+{
+    return __SIM_PACK(__sim_sat16(__SIM_LO(x) + __SIM_LO(y)),
+                      __sim_sat16(__SIM_HI(x) + __SIM_HI(y)));
+}
+
+static inline uint32_t
+__QSUB16(uint32_t x, uint32_t y)
+{
+    return __SIM_PACK(__sim_sat16(__SIM_LO(x) - __SIM_LO(y)),
+                      __sim_sat16(__SIM_HI(x) - __SIM_HI(y)));
+}
+
+static inline uint32_t
+__SHADD16(uint32_t x, uint32_t y)
+{
+    return __SIM_PACK((__SIM_LO(x) + __SIM_LO(y)) >> 1,
+                      (__SIM_HI(x) + __SIM_HI(y)) >> 1);
+}
+
+static inline uint32_t
+__SHSUB16(uint32_t x, uint32_t y)
+{
+    return __SIM_PACK((__SIM_LO(x) - __SIM_LO(y)) >> 1,
+                      (__SIM_HI(x) - __SIM_HI(y)) >> 1);
+}
+
+static inline uint32_t
+__QASX(uint32_t x, uint32_t y)
+{
+    return __SIM_PACK(__sim_sat16(__SIM_LO(x) - __SIM_HI(y)),
+                      __sim_sat16(__SIM_HI(x) + __SIM_LO(y)));
+}
+
+static inline uint32_t
+__SHASX(uint32_t x, uint32_t y)
+{
+    return __SIM_PACK((__SIM_LO(x) - __SIM_HI(y)) >> 1,
+                      (__SIM_HI(x) + __SIM_LO(y)) >> 1);
+}
+
+static inline uint32_t
+__QSAX(uint32_t x, uint32_t y)
+{
+    return __SIM_PACK(__sim_sat16(__SIM_LO(x) + __SIM_HI(y)),
+                      __sim_sat16(__SIM_HI(x) - __SIM_LO(y)));
+}
+
+static inline uint32_t
+__SHSAX(uint32_t x, uint32_t y)
+{
+    return __SIM_PACK((__SIM_LO(x) + __SIM_HI(y)) >> 1,
+                      (__SIM_HI(x) - __SIM_LO(y)) >> 1);
+}
+
+static inline uint32_t
+__SMUAD(uint32_t x, uint32_t y)
+{
+    return (uint32_t) (__SIM_LO(x) * __SIM_LO(y) + __SIM_HI(x) * __SIM_HI(y));
+}
+
+static inline uint32_t
+__SMUADX(uint32_t x, uint32_t y)
+{
+    return (uint32_t) (__SIM_LO(x) * __SIM_HI(y) + __SIM_HI(x) * __SIM_LO(y));
+}
+
+static inline uint32_t
+__SMUSD(uint32_t x, uint32_t y)
+{
+    return (uint32_t) (__SIM_LO(x) * __SIM_LO(y) - __SIM_HI(x) * __SIM_HI(y));
+}
+
+static inline uint32_t
+__SMUSDX(uint32_t x, uint32_t y)
+{
+    return (uint32_t) (__SIM_LO(x) * __SIM_HI(y) - __SIM_HI(x) * __SIM_LO(y));
+}
+
+static inline uint32_t
+__SMLAD(uint32_t x, uint32_t y, uint32_t acc)
+{
+    return __SMUAD(x, y) + acc;
+}
+
+static inline uint32_t
+__SMLADX(uint32_t x, uint32_t y, uint32_t acc)
+{
+    return __SMUADX(x, y) + acc;
+}
+
+static inline uint32_t
+__SMLSDX(uint32_t x, uint32_t y, uint32_t acc)
+{
+    return __SMUSDX(x, y) + acc;
+}
+
+static inline uint64_t
+__SMLALD(uint32_t x, uint32_t y, uint64_t acc)
+{
+    return acc + (uint64_t) ((int64_t) __SIM_LO(x) * __SIM_LO(y)
+                             + (int64_t) __SIM_HI(x) * __SIM_HI(y));
+}
+
+static inline uint64_t
+__SMLALDX(uint32_t x, uint32_t y, uint64_t acc)
+{
+    return acc + (uint64_t) ((int64_t) __SIM_LO(x) * __SIM_HI(y)
+                             + (int64_t) __SIM_HI(x) * __SIM_LO(y));
+}
+
+static inline int32_t
+__QADD(int32_t x, int32_t y)
+{
+    return __sim_ssat((int64_t) x + y, 32u);
+}
+
+static inline int32_t
+__QSUB(int32_t x, int32_t y)
+{
+    return __sim_ssat((int64_t) x - y, 32u);
+}
+
+#define __PKHBT(ARG1, ARG2, ARG3) \
+    ((((uint32_t) (ARG1)) & 0x0000FFFFu) | \
+     ((((uint32_t) (ARG2)) << (ARG3)) & 0xFFFF0000u))
+
+#define __PKHTB(ARG1, ARG2, ARG3) \
+    ((((uint32_t) (ARG1)) & 0xFFFF0000u) | \
+     ((((uint32_t) (ARG2)) >> (ARG3)) & 0x0000FFFFu))
+
+#endif
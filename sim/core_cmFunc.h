@@ -0,0 +1,47 @@
+/**
+  ******************************************************************************
+  * @file    core_cmFunc.h
+  * @author  Joe Todd
+  * @version
+  * @date
+  * @brief   Host build shadow of the CMSIS core register intrinsics
+  *
+  * PRIMASK is the simulator's interrupt mask: unmasking delivers anything
+  * that came due while it was set. The rest read as zero and ignore
+  * writes, which is what the firmware expects of them in thread mode on
+  * the main stack.
+  ******************************************************************************
+*/
+
+#ifndef __CORE_CMFUNC_H
+#define __CORE_CMFUNC_H
+
+#include <stdint.h>
+
+extern uint32_t sim_get_primask(void);
+extern void sim_set_primask(uint32_t primask);
+
+static inline void __enable_irq(void) { sim_set_primask(0); }
+static inline void __disable_irq(void) { sim_set_primask(1); }
+static inline uint32_t __get_PRIMASK(void) { return sim_get_primask(); }
+static inline void __set_PRIMASK(uint32_t primask) { sim_set_primask(primask); }
+
+static inline void __enable_fault_irq(void) {}
+static inline void __disable_fault_irq(void) {}
+static inline uint32_t __get_CONTROL(void) { return 0; }
+static inline void __set_CONTROL(uint32_t control) { (void) control; }
+static inline uint32_t __get_IPSR(void) { return 0; }
+static inline uint32_t __get_APSR(void) { return 0; }
+static inline uint32_t __get_xPSR(void) { return 0; }
+static inline uint32_t __get_PSP(void) { return 0; }
+static inline void __set_PSP(uint32_t stack) { (void) stack; }
+static inline uint32_t __get_MSP(void) { return 0; }
+static inline void __set_MSP(uint32_t stack) { (void) stack; }
+static inline uint32_t __get_BASEPRI(void) { return 0; }
+static inline void __set_BASEPRI(uint32_t value) { (void) value; }
+static inline uint32_t __get_FAULTMASK(void) { return 0; }
+static inline void __set_FAULTMASK(uint32_t mask) { (void) mask; }
+static inline uint32_t __get_FPSCR(void) { return 0; }
+static inline void __set_FPSCR(uint32_t fpscr) { (void) fpscr; }
+
+#endif
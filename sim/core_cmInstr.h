@@ -0,0 +1,116 @@
+/**
+  ******************************************************************************
+  * @file    core_cmInstr.h
+  * @author  Joe Todd
+  * @version
+  * @date
+  * @brief   Host build shadow of the CMSIS core instruction intrinsics
+  *
+  * Plain C for the arithmetic ones. The barriers bring the simulation up
+  * to date, which is where a software reset request is seen, and __WFI
+  * sleeps on the virtual clock. Exclusive access always succeeds: the
+  * firmware runs on one host thread.
+  ******************************************************************************
+*/
+
+#ifndef __CORE_CMINSTR_H
+#define __CORE_CMINSTR_H
+
+#include <stdint.h>
+
+extern void sim_wfi(void);
+extern void sim_barrier(void);
+
+static inline void __NOP(void) {}
+static inline void __WFI(void) { sim_wfi(); }
+static inline void __WFE(void) { sim_wfi(); }
+static inline void __SEV(void) {}
+static inline void __ISB(void) { sim_barrier(); }
+static inline void __DSB(void) { sim_barrier(); }
+static inline void __DMB(void) { __atomic_thread_fence(__ATOMIC_SEQ_CST); }
+
+static inline uint32_t
+__REV(uint32_t value)
+{
+    return __builtin_bswap32(value);
+}
+
+static inline uint32_t
+__REV16(uint32_t value)
+{
+    return ((value & 0x00FF00FFu) << 8) | ((value >> 8) & 0x00FF00FFu);
+}
+
+static inline int32_t
+__REVSH(int32_t value)
+{
+    return (int16_t) __builtin_bswap16((uint16_t) value);
+}
+
+static inline uint32_t
+__RBIT(uint32_t value)
+{
+    uint32_t result = 0;
+    uint32_t i;
+
+    for (i = 0; i < 32u; i++) {
+        result = (result << 1) | ((value >> i) & 1u);
+    }
+
+    return result;
+}
+
+static inline uint8_t
+__CLZ(uint32_t value)
+{
+    return (value == 0) ? 32u : (uint8_t) __builtin_clz(value);
+}
+
+static inline uint8_t __LDREXB(volatile uint8_t *addr) { return *addr; }
+static inline uint16_t __LDREXH(volatile uint16_t *addr) { return *addr; }
+static inline uint32_t __LDREXW(volatile uint32_t *addr) { return *addr; }
+
+static inline uint32_t
+__STREXB(uint8_t value, volatile uint8_t *addr)
+{
+    *addr = value;
+    return 0;
+}
+
+static inline uint32_t
+__STREXH(uint16_t value, volatile uint16_t *addr)
+{
+    *addr = value;
+    return 0;
+}
+
+static inline uint32_t
+__STREXW(uint32_t value, volatile uint32_t *addr)
+{
+    *addr = value;
+    return 0;
+}
+
+static inline void __CLREX(void) {}
+
+static inline int32_t
+__sim_ssat(int64_t value, uint32_t sat)
+{
+    int64_t max = ((int64_t) 1 << (sat - 1u)) - 1;
+    int64_t min = -max - 1;
+
+    return (int32_t) ((value > max) ? max : (value < min) ? min : value);
+}
+
+static inline uint32_t
+__sim_usat(int64_t value, uint32_t sat)
+{
+    int64_t max = ((int64_t) 1 << sat) - 1;
+
+    return (uint32_t) ((value > max) ? max : (value < 0) ? 0 : value);
+}
+
+#define __SSAT(ARG1, ARG2)  __sim_ssat((int32_t) (ARG1), (ARG2))
+#define __USAT(ARG1, ARG2)  __sim_usat((int32_t) (ARG1), (ARG2))
+
+#endif
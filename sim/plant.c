@@ -0,0 +1,247 @@
+/**
+  ******************************************************************************
+  * @file    plant.c
+  * @author  Joe Todd
+  * @version
+  * @date    October 2026
+  * @brief   Autogrow
+  *          Host simulator: soil water in each pot.
+  *
+  * Each step is solved exactly, so it does not matter how finely the
+  * firmware's accesses cut up the time: standing water soaks in with a
+  * time constant, and evaporation takes a fixed fraction of the soil
+  * water per second, which at half full is PLANT_ET_ML a day. Water past
+  * capacity drains away. The probe is linear between PLANT_DRY and
+  * PLANT_WET with a little repeatable noise.
+ *
+ * A trace replaces the probe. Time only runs forward, so the row in use
+ * is found by walking on from the last one.
+  ******************************************************************************
+*/
+
+#include "plant.h"
+#include "sim.h"
+#include <math.h>
+#include <stdlib.h>
+
+#define PLANT_CAPACITY_ML   2000.0
+#define PLANT_START_ML      1000.0
+#define PLANT_FLOW_ML_S     20.0        /* valve open */
+#define PLANT_SOAK_S        600.0       /* standing water time constant */
+#define PLANT_ET_ML         400.0       /* a day, at half full */
+#define PLANT_DRY           3500.0      /* reading with no water */
+#define PLANT_WET           1200.0      /* reading at capacity */
+#define PLANT_NOISE         8u          /* +/- counts */
+#define PLANT_LINE          256u
+
+typedef struct {
+    uint64_t ns;
+    uint16_t reading[PLANT_ZONES];
+} plant_row_t;
+
+static plant_zone_t zones[PLANT_ZONES];
+static uint64_t last;
+static uint32_t noise = 1u;
+static plant_row_t *trace;
+static uint32_t trace_rows;
+static uint32_t trace_at;
+
+static uint32_t plant_noise(void);
+static bool plant_row(char const *line, plant_row_t *row);
+
+extern void
+plant_init(void)
+{
+    uint32_t i;
+
+    for (i = 0; i < PLANT_ZONES; i++) {
+        zones[i].chan = 11u;
+        zones[i].en_port = 2u;          /* PC2 */
+        zones[i].en_pin = 2u;
+        zones[i].valve_port = 1u;       /* PB2 */
+        zones[i].valve_pin = 2u;
+        zones[i].soil_ml = PLANT_START_ML;
+        zones[i].surface_ml = 0.0;
+        zones[i].water_ml = 0.0;
+        zones[i].open_ns = 0;
+    }
+    last = sim_now;
+}
+
+extern void
+plant_sync(void)
+{
+    double dt = (double) (sim_now - last) / SIM_NS;
+    double et = PLANT_ET_ML / (PLANT_CAPACITY_ML / 2.0) / 86400.0;
+    double soak;
+    plant_zone_t *z;
+    uint32_t i;
+
+    if (sim_now == last) {
+        return;
+    }
+
+    for (i = 0; i < PLANT_ZONES; i++) {
+        z = &zones[i];
+
+        if (sim_gpio_out(z->valve_port, z->valve_pin)) {
+            z->surface_ml += PLANT_FLOW_ML_S * dt;
+            z->water_ml += PLANT_FLOW_ML_S * dt;
+            z->open_ns += sim_now - last;
+        }
+
+        soak = z->surface_ml * (1.0 - exp(-dt / PLANT_SOAK_S));
+        z->surface_ml -= soak;
+        z->soil_ml = z->soil_ml * exp(-et * dt) + soak;
+        if (z->soil_ml > PLANT_CAPACITY_ML) {
+            z->soil_ml = PLANT_CAPACITY_ML;
+        }
+    }
+    last = sim_now;
+}
+
+extern uint32_t
+plant_adc(uint32_t ch)
+{
+    uint32_t i;
+
+    for (i = 0; i < PLANT_ZONES; i++) {
+        if (zones[i].chan == ch &&
+            sim_gpio_out(zones[i].en_port, zones[i].en_pin)) {
+            return plant_reading(i);
+        }
+    }
+
+    return 0;
+}
+
+extern uint32_t
+plant_reading(uint32_t i)
+{
+    double v;
+
+    if (trace != NULL) {
+        while (trace_at + 1u < trace_rows &&
+               trace[trace_at + 1u].ns <= sim_now) {
+            trace_at++;
+        }
+        return trace[trace_at].reading[i];
+    }
+
+    v = PLANT_DRY - (PLANT_DRY - PLANT_WET) * zones[i].soil_ml
+        / PLANT_CAPACITY_ML;
+
+    v += (double) (plant_noise() % (2u * PLANT_NOISE + 1u)) - PLANT_NOISE;
+
+    return (v < 0.0) ? 0u : (v > 4095.0) ? 4095u : (uint32_t) v;
+}
+
+extern bool
+plant_trace(FILE *f)
+{
+    char line[PLANT_LINE];
+    plant_row_t row;
+    plant_row_t *p;
+    uint32_t size = 0;
+    uint32_t n = 0;
+    uint32_t lineno = 0;
+
+    while (fgets(line, sizeof(line), f) != NULL) {
+        lineno++;
+        if (!plant_row(line, &row)) {
+            continue;
+        }
+        if (n != 0 && row.ns < trace[n - 1u].ns) {
+            fprintf(stderr, "sim: trace line %u goes back in time\n", lineno);
+            return false;
+        }
+        if (n == size) {
+            size = (size != 0) ? size * 2u : 1024u;
+            p = realloc(trace, size * sizeof(*trace));
+            if (p == NULL) {
+                fprintf(stderr, "sim: trace too long\n");
+                return false;
+            }
+            trace = p;
+        }
+        trace[n++] = row;
+    }
+    if (n == 0) {
+        fprintf(stderr, "sim: trace has no readings\n");
+        return false;
+    }
+
+    trace_rows = n;
+    trace_at = 0;
+    return true;
+}
+
+extern uint64_t
+plant_trace_end(void)
+{
+    return (trace != NULL) ? trace[trace_rows - 1u].ns : 0;
+}
+
+extern uint32_t
+plant_zones(void)
+{
+    return PLANT_ZONES;
+}
+
+extern plant_zone_t const *
+plant_zone(uint32_t i)
+{
+    return (i < PLANT_ZONES) ? &zones[i] : NULL;
+}
+
+/*
+ * Same sequence every run.
+ */
+static uint32_t
+plant_noise(void)
+{
+    noise = noise * 1103515245u + 12345u;
+
+    return noise >> 16;
+}
+
+/*
+ * One "<seconds>,<reading>[,<reading>...]" row, or false for anything
+ * else: a header, a comment or a blank line.
+ */
+static bool
+plant_row(char const *line, plant_row_t *row)
+{
+    char *end;
+    double t;
+    long v;
+    uint32_t i;
+
+    t = strtod(line, &end);
+    if (end == line || t < 0.0) {
+        return false;
+    }
+    row->ns = (uint64_t) (t * SIM_NS);
+
+    for (i = 0; i < PLANT_ZONES; i++) {
+        line = end;
+        while (*line == ' ' || *line == '\t') {
+            line++;
+        }
+        if (*line == ',') {
+            v = strtol(line + 1, &end, 10);
+            if (end == line + 1) {
+                return false;
+            }
+        }
+        else if (i == 0) {
+            return false;
+        }
+        else {
+            v = row->reading[i - 1u];
+        }
+        row->reading[i] = (v < 0) ? 0u : (v > 4095) ? 4095u : (uint16_t) v;
+    }
+
+    return true;
+}
@@ -0,0 +1,77 @@
+/**
+  ******************************************************************************
+  * @file    plant.h
+  * @author  Joe Todd
+  * @version
+  * @date    October 2026
+  * @brief   Header for plant.c
+  *
+  * The pots the firmware looks after, one per zone. An open valve runs
+  * water onto the surface, which soaks into the soil over some minutes;
+  * the soil dries by evaporation at a rate that falls as it dries. The
+  * probe reads high when dry and low when wet, and only while it is
+  * powered.
+  ******************************************************************************
+*/
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef PLANT_H
+#define PLANT_H
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+#define PLANT_ZONES         1u
+
+typedef struct {
+    uint32_t chan;          /* ADC channel the probe is on */
+    uint32_t en_port;       /* probe power, iox_port_t */
+    uint32_t en_pin;
+    uint32_t valve_port;
+    uint32_t valve_pin;
+    double soil_ml;         /* water held in the soil */
+    double surface_ml;      /* standing, not yet soaked in */
+    double water_ml;        /* through the valve since power up */
+    uint64_t open_ns;       /* valve open time since power up */
+} plant_zone_t;
+
+/**
+ * Pots as on the bench: one, on the default pins, half wet.
+ */
+extern void plant_init(void);
+
+/**
+ * Run the pots up to sim_now.
+ */
+extern void plant_sync(void);
+
+/**
+ * What ADC channel 'ch' reads now.
+ */
+extern uint32_t plant_adc(uint32_t ch);
+
+/**
+ * What zone 'i''s probe would read now, powered or not.
+ */
+extern uint32_t plant_reading(uint32_t i);
+
+/**
+ * Read the probes from 'f' from now on, a CSV of "<seconds>,<reading>"
+ * with a reading per zone; a short row repeats its last reading, and
+ * lines that do not start with a number are skipped. Each reading holds
+ * until the next row, and the last one holds to the end. Returns false,
+ * having said why, if there are no rows or they go back in time.
+ */
+extern bool plant_trace(FILE *f);
+
+/**
+ * Time of the last row of the trace, or 0 without one.
+ */
+extern uint64_t plant_trace_end(void);
+
+extern uint32_t plant_zones(void);
+extern plant_zone_t const *plant_zone(uint32_t i);
+
+#endif
@@ -0,0 +1,240 @@
+/**
+  ******************************************************************************
+  * @file    ring_stress.c
+  * @author  Joe Todd
+  * @version
+  * @date    October 2026
+  * @brief   Autogrow
+  *          Host stress test for ring.c, built by 'make ring-test'.
+  *
+  * ring.c is built for the host as the simulator builds it, where __DMB()
+  * is a full fence (core_cmInstr.h here), and driven from two threads at
+  * once: one only puts, one only gets, as on the target. On a machine
+  * with two or more cores both loops run flat out side by side, so the
+  * two sides interleave far more finely and more often than an interrupt
+  * and the main loop ever do. A side that finds the ring full or empty
+  * yields, so the test also finishes on one core.
+  *
+  *     records     ring_put against ring_get and ring_peek/ring_drop;
+  *                 each record carries its sequence number and a pattern
+  *                 worked from it, so a record read before it was
+  *                 complete, read twice or skipped is caught
+  *     bytes       ring_write against ring_read in chunks of varying
+  *                 length, so the runs split at the end of the buffer
+  *                 every way; the byte stream must come out unchanged
+  *
+  * head and tail start just short of 2^32, so both tests run across the
+  * wrap of the free-running counts. Exits non-zero on the first error.
+  ******************************************************************************
+*/
+
+#include "ring.h"
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define STRESS_RECORDS      2000000u
+#define STRESS_BYTES        32000000u
+#define STRESS_SLOTS        16u
+#define STRESS_BYTE_SLOTS   256u
+#define STRESS_CHUNK        37u         /* largest byte chunk, not 2^n */
+#define STRESS_START        0xFFFFF000u /* counts begin near the wrap */
+
+typedef struct {
+    uint32_t seq;
+    uint32_t word[5];
+} stress_rec_t;
+
+static ring_t recs;
+static stress_rec_t rec_buf[STRESS_SLOTS];
+static ring_t bytes;
+static uint8_t byte_buf[STRESS_BYTE_SLOTS];
+static volatile bool failed;    /* the consumer gave up, so stop putting */
+
+static uint32_t pattern(uint32_t seq, uint32_t i);
+static uint8_t byte_at(uint32_t n);
+static void *rec_producer(void *arg);
+static void *rec_consumer(void *arg);
+static void *byte_producer(void *arg);
+static void *byte_consumer(void *arg);
+static bool run(char const *name, void *(*put) (void *),
+                void *(*get) (void *));
+
+int main(void)
+{
+    bool ok = true;
+
+    if (!ring_init(&recs, rec_buf, STRESS_SLOTS, sizeof(stress_rec_t)) ||
+        !ring_init(&bytes, byte_buf, STRESS_BYTE_SLOTS, 1u)) {
+        fprintf(stderr, "ring_init failed\n");
+        return 1;
+    }
+    recs.head = recs.tail = STRESS_START;
+    bytes.head = bytes.tail = STRESS_START;
+
+    ok &= run("records", rec_producer, rec_consumer);
+    ok &= run("bytes", byte_producer, byte_consumer);
+
+    return ok ? 0 : 1;
+}
+
+static uint32_t
+pattern(uint32_t seq, uint32_t i)
+{
+    return (seq * 0x9E3779B1u) ^ (i * 0x85EBCA77u);
+}
+
+static uint8_t
+byte_at(uint32_t n)
+{
+    return (uint8_t) ((n * 7u) ^ (n >> 8));
+}
+
+static void *
+rec_producer(void *arg)
+{
+    stress_rec_t r;
+    uint32_t seq;
+    uint32_t i;
+
+    for (seq = 0; seq < STRESS_RECORDS; seq++) {
+        r.seq = seq;
+        for (i = 0; i < 5u; i++) {
+            r.word[i] = pattern(seq, i);
+        }
+        while (!ring_put(&recs, &r)) {
+            if (failed) {
+                return NULL;
+            }
+            sched_yield();
+        }
+    }
+
+    return NULL;
+}
+
+/*
+ * Alternate between copying out and reading in place.
+ */
+static void *
+rec_consumer(void *arg)
+{
+    stress_rec_t copy;
+    stress_rec_t const *r;
+    uint32_t seq;
+    uint32_t i;
+
+    for (seq = 0; seq < STRESS_RECORDS; seq++) {
+        if (seq & 1u) {
+            while ((r = ring_peek(&recs)) == NULL) {
+                sched_yield();
+            }
+        }
+        else {
+            while (!ring_get(&recs, &copy)) {
+                sched_yield();
+            }
+            r = &copy;
+        }
+        if (r->seq != seq) {
+            fprintf(stderr, "record %u came as %u\n", seq, r->seq);
+            failed = true;
+            return (void *) 1;
+        }
+        for (i = 0; i < 5u; i++) {
+            if (r->word[i] != pattern(seq, i)) {
+                fprintf(stderr, "record %u word %u torn\n", seq, i);
+                failed = true;
+                return (void *) 1;
+            }
+        }
+        if (seq & 1u) {
+            ring_drop(&recs);
+        }
+    }
+
+    return NULL;
+}
+
+static void *
+byte_producer(void *arg)
+{
+    uint8_t chunk[STRESS_CHUNK];
+    uint32_t n = 0;
+    uint32_t len = 1;
+    uint32_t done;
+    uint32_t put;
+    uint32_t i;
+
+    while (n < STRESS_BYTES) {
+        len = len % STRESS_CHUNK + 1u;
+        if (len > STRESS_BYTES - n) {
+            len = STRESS_BYTES - n;
+        }
+        for (i = 0; i < len; i++) {
+            chunk[i] = byte_at(n + i);
+        }
+        for (done = 0; done < len; done += put) {
+            put = ring_write(&bytes, &chunk[done], len - done);
+            if (put == 0) {
+                if (failed) {
+                    return NULL;
+                }
+                sched_yield();
+            }
+        }
+        n += len;
+    }
+
+    return NULL;
+}
+
+static void *
+byte_consumer(void *arg)
+{
+    uint8_t chunk[STRESS_CHUNK];
+    uint32_t n = 0;
+    uint32_t len = 5;
+    uint32_t got;
+    uint32_t i;
+
+    while (n < STRESS_BYTES) {
+        len = (len * 3u) % STRESS_CHUNK + 1u;
+        got = ring_read(&bytes, chunk, len);
+        if (got == 0) {
+            sched_yield();
+        }
+        for (i = 0; i < got; i++) {
+            if (chunk[i] != byte_at(n + i)) {
+                fprintf(stderr, "byte %u is %02x, expected %02x\n", n + i,
+                        chunk[i], byte_at(n + i));
+                failed = true;
+                return (void *) 1;
+            }
+        }
+        n += got;
+    }
+
+    return NULL;
+}
+
+static bool
+run(char const *name, void *(*put) (void *), void *(*get) (void *))
+{
+    pthread_t producer;
+    pthread_t consumer;
+    void *err;
+
+    if (pthread_create(&producer, NULL, put, NULL) != 0 ||
+        pthread_create(&consumer, NULL, get, NULL) != 0) {
+        fprintf(stderr, "%s: no threads\n", name);
+        exit(1);
+    }
+    (void) pthread_join(producer, NULL);
+    (void) pthread_join(consumer, &err);
+
+    printf("%-8s %s\n", name, err == NULL ? "ok" : "FAIL");
+
+    return err == NULL;
+}
@@ -0,0 +1,658 @@
+/**
+  ******************************************************************************
+  * @file    sim.c
+  * @author  Joe Todd
+  * @version
+  * @date    October 2026
+  * @brief   Autogrow
+  *          Host simulator: virtual clock, interrupt delivery and the run.
+  *
+  * The firmware's main() is built as fw_main() and runs on its own stack
+  * below 4GB, so that the pointer to integer casts it makes for the DMA
+  * address registers survive. Everything else runs on the host's stack
+  * between register accesses.
+ *
+ * With -r, a row of totals is written for each simulated day as it ends,
+ * and for the part day the run ends in, so that a control or power change
+ * can be held up against the last one. WFI stops at midnight to close
+ * the day, so that sleep is counted against the day it was in.
+  ******************************************************************************
+*/
+
+#define _GNU_SOURCE
+#include "sim.h"
+#include "plant.h"
+#include "fault.h"
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <ucontext.h>
+#include <sys/mman.h>
+
+#define SIM_STACK_SIZE      (1u << 20)
+#define SIM_IRQ_STORM       1000u   /* back to back deliveries */
+#define SIM_VECTORS         (sizeof(vectors) / sizeof(vectors[0]))
+#define SIM_DAY_NS          (86400ull * SIM_NS)
+
+typedef struct {
+    uint32_t base;
+    uint32_t size;
+    uint8_t fill;
+} sim_region_t;
+
+typedef struct {
+    uint64_t ns;
+    sim_stats_t stats;
+    double open_s;
+    double water_ml;
+} sim_day_t;
+
+typedef struct {
+    IRQn_Type irq;
+    void (*handler)(void);
+} sim_vector_t;
+
+extern int fw_main(void);
+
+extern void TIM2_IRQHandler(void);
+extern void TIM5_IRQHandler(void);
+extern void USART1_IRQHandler(void);
+extern void SDIO_IRQHandler(void);
+extern void DMA1_Stream0_IRQHandler(void);
+extern void DMA1_Stream1_IRQHandler(void);
+extern void DMA1_Stream2_IRQHandler(void);
+extern void DMA1_Stream3_IRQHandler(void);
+extern void DMA1_Stream4_IRQHandler(void);
+extern void DMA1_Stream5_IRQHandler(void);
+extern void DMA1_Stream6_IRQHandler(void);
+extern void DMA1_Stream7_IRQHandler(void);
+extern void DMA2_Stream0_IRQHandler(void);
+extern void DMA2_Stream1_IRQHandler(void);
+extern void DMA2_Stream2_IRQHandler(void);
+extern void DMA2_Stream3_IRQHandler(void);
+extern void DMA2_Stream4_IRQHandler(void);
+extern void DMA2_Stream5_IRQHandler(void);
+extern void DMA2_Stream6_IRQHandler(void);
+extern void DMA2_Stream7_IRQHandler(void);
+
+static sim_region_t const regions[] = {
+    {0x08000000u, 0x00080000u, 0xFFu},      /* flash */
+    {0x40000000u, 0x00080000u, 0x00u},      /* APB1, APB2, AHB1 */
+    {0x50000000u, 0x00061000u, 0x00u},      /* AHB2 */
+    {0xE0000000u, 0x00100000u, 0x00u},      /* core */
+};
+
+/*
+ * The handlers stm32f4xx_it.c defines, lowest IRQn first, which is the
+ * order the NVIC takes them in at equal priority.
+ */
+static sim_vector_t const vectors[] = {
+    {DMA1_Stream0_IRQn, DMA1_Stream0_IRQHandler},
+    {DMA1_Stream1_IRQn, DMA1_Stream1_IRQHandler},
+    {DMA1_Stream2_IRQn, DMA1_Stream2_IRQHandler},
+    {DMA1_Stream3_IRQn, DMA1_Stream3_IRQHandler},
+    {DMA1_Stream4_IRQn, DMA1_Stream4_IRQHandler},
+    {DMA1_Stream5_IRQn, DMA1_Stream5_IRQHandler},
+    {DMA1_Stream6_IRQn, DMA1_Stream6_IRQHandler},
+    {TIM2_IRQn, TIM2_IRQHandler},
+    {USART1_IRQn, USART1_IRQHandler},
+    {DMA1_Stream7_IRQn, DMA1_Stream7_IRQHandler},
+    {SDIO_IRQn, SDIO_IRQHandler},
+    {TIM5_IRQn, TIM5_IRQHandler},
+    {DMA2_Stream0_IRQn, DMA2_Stream0_IRQHandler},
+    {DMA2_Stream1_IRQn, DMA2_Stream1_IRQHandler},
+    {DMA2_Stream2_IRQn, DMA2_Stream2_IRQHandler},
+    {DMA2_Stream3_IRQn, DMA2_Stream3_IRQHandler},
+    {DMA2_Stream4_IRQn, DMA2_Stream4_IRQHandler},
+    {DMA2_Stream5_IRQn, DMA2_Stream5_IRQHandler},
+    {DMA2_Stream6_IRQn, DMA2_Stream6_IRQHandler},
+    {DMA2_Stream7_IRQn, DMA2_Stream7_IRQHandler},
+};
+
+uint64_t sim_now;
+sim_stats_t sim_stats;
+
+static uint64_t end_ns;
+static uint32_t primask;
+static bool in_irq;
+static bool syncing;
+static bool quiet;
+static uint32_t lines[3];           /* interrupt levels, by IRQn */
+static ucontext_t host_ctx;
+static ucontext_t fw_ctx;
+static FILE *days_out;
+static sim_day_t day;               /* totals when the day started */
+static uint64_t day_end;
+static uint32_t day_num;
+
+static void sim_deliver(void);
+static void sim_map(void);
+static void sim_run(void);
+static void sim_report(void);
+static void sim_day(void);
+static void sim_day_row(void);
+static void sim_day_totals(sim_day_t *d);
+static void sim_usage(char const *prog);
+
+extern void *
+sim_reg(uint32_t base)
+{
+    sim_stats.accesses++;
+    sim_now += sim_cycles_ns(SIM_ACCESS_CYCLES);
+    sim_sync();
+    sim_deliver();
+    if (sim_now >= end_ns) {
+        sim_finish();
+    }
+    if (sim_now >= day_end) {
+        sim_day();
+    }
+
+    return (void *) (uintptr_t) base;
+}
+
+extern void
+sim_advance(uint64_t ns)
+{
+    sim_now += ns;
+}
+
+extern uint64_t
+sim_cycles_ns(uint64_t cycles)
+{
+    return cycles * SIM_NS / sim_rcc_hclk();
+}
+
+extern void
+sim_sync(void)
+{
+    /*
+     * A model that calls back into the firmware's view of time must not
+     * start another pass over the models.
+     */
+    if (syncing) {
+        return;
+    }
+    syncing = true;
+
+    sim_rcc_sync();
+    sim_core_sync();
+    plant_sync();
+    sim_tim_sync();
+    sim_adc_sync();
+    sim_dma_sync();
+    sim_usart_sync();
+    sim_rtc_sync();
+    sim_spi_sync();
+    sim_sdio_sync();
+    sim_flash_sync();
+    sim_iwdg_sync();
+    sim_core_sync();        /* pending bits for what the models raised */
+
+    syncing = false;
+}
+
+extern void
+sim_irq_set(IRQn_Type irq, bool level)
+{
+    uint32_t w = (uint32_t) irq / 32u;
+    uint32_t bit = 1u << ((uint32_t) irq % 32u);
+
+    if (level) {
+        lines[w] |= bit;
+    }
+    else {
+        lines[w] &= ~bit;
+    }
+}
+
+extern uint32_t
+sim_irq_lines(uint32_t w)
+{
+    return lines[w];
+}
+
+extern uint32_t
+sim_get_primask(void)
+{
+    return primask;
+}
+
+extern void
+sim_set_primask(uint32_t mask)
+{
+    primask = mask & 1u;
+    if (primask == 0) {
+        sim_deliver();
+    }
+}
+
+extern void
+sim_barrier(void)
+{
+    sim_sync();
+}
+
+/*
+ * Sleep until an enabled interrupt is pending. As on the core, one that
+ * is masked by PRIMASK still wakes it; it is taken once unmasked.
+ */
+extern void
+sim_wfi(void)
+{
+    uint64_t next;
+    uint64_t t;
+
+    sim_sync();
+    if (sim_core_pending() != 0) {
+        return;
+    }
+
+    while (sim_core_pending() == 0) {
+        next = sim_tim_next();
+        t = sim_adc_next();
+        next = (t < next) ? t : next;
+        t = sim_dma_next();
+        next = (t < next) ? t : next;
+        t = sim_usart_next();
+        next = (t < next) ? t : next;
+        t = sim_flash_next();
+        next = (t < next) ? t : next;
+        t = sim_iwdg_next();
+        next = (t < next) ? t : next;
+
+        if (next == SIM_NEVER) {
+            fprintf(stderr, "sim: WFI with nothing to wake it at %.3f s\n",
+                    (double) sim_now / SIM_NS);
+            exit(2);
+        }
+        if (next > day_end && day_end < end_ns) {
+            sim_stats.sleep_ns += day_end - sim_now;
+            sim_now = day_end;
+            sim_sync();
+            sim_day();
+            continue;
+        }
+        if (next >= end_ns) {
+            sim_stats.sleep_ns += end_ns - sim_now;
+            sim_now = end_ns;
+            sim_finish();
+        }
+        if (next > sim_now) {
+            sim_stats.sleep_ns += next - sim_now;
+            sim_now = next;
+        }
+        sim_sync();
+    }
+    sim_stats.wakes++;
+    sim_deliver();
+}
+
+extern void
+sim_finish(void)
+{
+    plant_sync();
+    sim_day_row();
+    sim_report();
+    exit(0);
+}
+
+extern void
+sim_reset(char const *why)
+{
+    plant_sync();
+    sim_day_row();
+    sim_report();
+    fprintf(stderr, "sim: %s reset at %.3f s, run ends here\n", why,
+            (double) sim_now / SIM_NS);
+    exit(1);
+}
+
+/*
+ * fault.c takes the exception frame apart in assembly; on the host there
+ * is no frame to take, and a crash ends the run anyway.
+ */
+extern bool
+fault_init(void)
+{
+    return false;
+}
+
+extern fault_rec_t const *
+fault_last(void)
+{
+    return NULL;
+}
+
+/*
+ * adc_scan() polls the stream enable through dma_stream(), which hands
+ * out a plain pointer, and the shell waits on dma_mem_busy(): give both
+ * a register access so that the wait moves the clock on.
+ */
+extern DMA_Stream_TypeDef *__real_dma_stream(uint32_t id);
+extern bool __real_dma_mem_busy(void);
+
+extern DMA_Stream_TypeDef *
+__wrap_dma_stream(uint32_t id)
+{
+    (void) sim_reg(DMA2_BASE);
+    return __real_dma_stream(id);
+}
+
+extern bool
+__wrap_dma_mem_busy(void)
+{
+    (void) sim_reg(DMA2_BASE);
+    return __real_dma_mem_busy();
+}
+
+int
+main(int argc, char **argv)
+{
+    FILE *out = NULL;
+    FILE *in = NULL;
+    FILE *tr = NULL;
+    double seconds = 0.0;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "d:s:o:i:t:r:q")) != -1) {
+        switch (opt) {
+        case 'd':
+            seconds = atof(optarg) * 86400.0;
+            break;
+
+        case 's':
+            seconds = atof(optarg);
+            break;
+
+        case 'o':
+            out = fopen(optarg, "wb");
+            if (out == NULL) {
+                perror(optarg);
+                return 2;
+            }
+            break;
+
+        case 'i':
+            in = fopen(optarg, "r");
+            if (in == NULL) {
+                perror(optarg);
+                return 2;
+            }
+            break;
+
+        case 't':
+            tr = fopen(optarg, "r");
+            if (tr == NULL) {
+                perror(optarg);
+                return 2;
+            }
+            break;
+
+        case 'r':
+            days_out = (strcmp(optarg, "-") == 0) ? stdout
+                : fopen(optarg, "w");
+            if (days_out == NULL) {
+                perror(optarg);
+                return 2;
+            }
+            break;
+
+        case 'q':
+            quiet = true;
+            break;
+
+        default:
+            sim_usage(argv[0]);
+            return 2;
+        }
+    }
+    if (optind != argc || seconds < 0.0) {
+        sim_usage(argv[0]);
+        return 2;
+    }
+    if (tr != NULL) {
+        if (!plant_trace(tr)) {
+            return 2;
+        }
+        fclose(tr);
+    }
+
+    /*
+     * A trace runs to its last row unless told otherwise.
+     */
+    if (seconds == 0.0) {
+        seconds = (tr != NULL) ? (double) plant_trace_end() / SIM_NS : 0.0;
+        seconds = (seconds > 0.0) ? seconds : 86400.0;
+    }
+    end_ns = (uint64_t) (seconds * SIM_NS);
+    day_end = SIM_DAY_NS;
+    if (days_out != NULL) {
+        fprintf(days_out, "day,days,wakes,irqs,busy_s,valve_s,water_ml\n");
+    }
+
+    sim_map();
+    sim_rcc_init();
+    sim_core_init();
+    sim_tim_init();
+    sim_adc_init();
+    sim_dma_init();
+    sim_usart_init(out, in);
+    sim_rtc_init();
+    sim_flash_init();
+    sim_iwdg_init();
+    plant_init();
+
+    sim_run();
+
+    fprintf(stderr, "sim: firmware returned from main\n");
+    return 2;
+}
+
+/*
+ * Deliver pending interrupts, lowest IRQn first, until none is left.
+ */
+static void
+sim_deliver(void)
+{
+    uint32_t storm = 0;
+    uint32_t pending;
+    uint32_t i;
+
+    if (primask != 0 || in_irq) {
+        return;
+    }
+
+    while ((pending = sim_core_pending()) != 0) {
+        for (i = 0; i < SIM_VECTORS; i++) {
+            if (pending & (1u << i)) {
+                break;
+            }
+        }
+        if (++storm > SIM_IRQ_STORM) {
+            fprintf(stderr, "sim: IRQ %d never clears at %.3f s\n",
+                    (int) vectors[i].irq, (double) sim_now / SIM_NS);
+            exit(2);
+        }
+
+        NVIC->ISPR[vectors[i].irq / 32] &= ~(1u << (vectors[i].irq % 32));
+
+        in_irq = true;
+        sim_stats.irqs++;
+        sim_now += sim_cycles_ns(SIM_IRQ_CYCLES);
+        vectors[i].handler();
+        if (vectors[i].irq == USART1_IRQn) {
+            sim_usart_irq_done();
+        }
+        in_irq = false;
+        sim_sync();
+    }
+}
+
+/*
+ * Bit i of the result is set for vectors[i]: see sim_core_pending().
+ */
+extern uint32_t
+sim_vector_pending(uint32_t const *pending)
+{
+    uint32_t r = 0;
+    uint32_t i;
+    uint32_t irq;
+
+    for (i = 0; i < SIM_VECTORS; i++) {
+        irq = (uint32_t) vectors[i].irq;
+        if (pending[irq / 32u] & (1u << (irq % 32u))) {
+            r |= 1u << i;
+        }
+    }
+
+    return r;
+}
+
+static void
+sim_map(void)
+{
+    uint32_t i;
+    void *p;
+
+    for (i = 0; i < sizeof(regions) / sizeof(regions[0]); i++) {
+        p = mmap((void *) (uintptr_t) regions[i].base, regions[i].size,
+                 PROT_READ | PROT_WRITE,
+                 MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE, -1, 0);
+        if (p != (void *) (uintptr_t) regions[i].base) {
+            fprintf(stderr, "sim: cannot map 0x%08x\n", regions[i].base);
+            exit(2);
+        }
+        memset(p, regions[i].fill, regions[i].size);
+    }
+}
+
+/*
+ * Switch to the firmware on a stack it can take the address of.
+ */
+static void
+sim_run(void)
+{
+    void *stack;
+
+    stack = mmap(NULL, SIM_STACK_SIZE, PROT_READ | PROT_WRITE,
+                 MAP_PRIVATE | MAP_ANONYMOUS | MAP_32BIT, -1, 0);
+    if (stack == MAP_FAILED) {
+        perror("sim: stack");
+        exit(2);
+    }
+
+    getcontext(&fw_ctx);
+    fw_ctx.uc_stack.ss_sp = stack;
+    fw_ctx.uc_stack.ss_size = SIM_STACK_SIZE;
+    fw_ctx.uc_link = &host_ctx;
+    makecontext(&fw_ctx, (void (*)(void)) fw_main, 0);
+    swapcontext(&host_ctx, &fw_ctx);
+}
+
+static void
+sim_report(void)
+{
+    plant_zone_t const *z;
+    double days = (double) sim_now / SIM_NS / 86400.0;
+    double busy = (double) (sim_now - sim_stats.sleep_ns) / SIM_NS;
+    uint32_t i;
+
+    if (quiet) {
+        return;
+    }
+
+    printf("simulated    %.3f days\n", days);
+    printf("wakes        %llu\n", (unsigned long long) sim_stats.wakes);
+    printf("interrupts   %llu\n", (unsigned long long) sim_stats.irqs);
+    printf("accesses     %llu\n", (unsigned long long) sim_stats.accesses);
+    printf("busy         %.3f s (%.4f%%)\n", busy,
+           (sim_now != 0) ? 100.0 * busy * SIM_NS / (double) sim_now : 0.0);
+    for (i = 0; i < plant_zones(); i++) {
+        z = plant_zone(i);
+        printf("zone %u       valve %.1f s, %.0f ml, soil %.0f ml, "
+               "reading %u\n", i, (double) z->open_ns / SIM_NS, z->water_ml,
+               z->soil_ml, plant_reading(i));
+    }
+    printf("uart tx      %llu bytes\n",
+           (unsigned long long) sim_usart_tx_bytes());
+    fflush(stdout);
+}
+
+/*
+ * Close every day that has ended.
+ */
+static void
+sim_day(void)
+{
+    while (sim_now >= day_end) {
+        plant_sync();
+        sim_day_row();
+        day_end += SIM_DAY_NS;
+    }
+}
+
+/*
+ * Write what happened since the day began, and begin the next.
+ */
+static void
+sim_day_row(void)
+{
+    sim_day_t now;
+    uint64_t end = (sim_now < day_end) ? sim_now : day_end;
+    uint64_t len = end - day.ns;
+    uint64_t sleep;
+
+    sim_day_totals(&now);
+    if (len == 0) {
+        return;
+    }
+
+    if (days_out != NULL) {
+        sleep = now.stats.sleep_ns - day.stats.sleep_ns;
+        fprintf(days_out, "%u,%.4f,%llu,%llu,%.3f,%.1f,%.1f\n", day_num,
+                (double) len / SIM_DAY_NS,
+                (unsigned long long) (now.stats.wakes - day.stats.wakes),
+                (unsigned long long) (now.stats.irqs - day.stats.irqs),
+                (double) (len - sleep) / SIM_NS, now.open_s - day.open_s,
+                now.water_ml - day.water_ml);
+        fflush(days_out);
+    }
+
+    now.ns = end;
+    day = now;
+    day_num++;
+}
+
+static void
+sim_day_totals(sim_day_t *d)
+{
+    plant_zone_t const *z;
+    uint32_t i;
+
+    d->ns = sim_now;
+    d->stats = sim_stats;
+    d->open_s = 0.0;
+    d->water_ml = 0.0;
+    for (i = 0; i < plant_zones(); i++) {
+        z = plant_zone(i);
+        d->open_s += (double) z->open_ns / SIM_NS;
+        d->water_ml += z->water_ml;
+    }
+}
+
+static void
+sim_usage(char const *prog)
+{
+    fprintf(stderr,
+            "usage: %s [-d days | -s seconds] [-o uart_out] [-i uart_in]\n"
+            "          [-t trace] [-r days_out] [-q]\n"
+            "  -d, -s   how long to run, default one day or to the end of the "
+            "trace\n"
+            "  -o       file for everything the firmware sends on USART1\n"
+            "  -i       script for USART1: lines of \"<seconds> <text>\"\n"
+            "  -t       CSV of \"<seconds>,<reading>...\" the probes read "
+            "instead\n"
+            "  -r       CSV of totals for each simulated day, - for stdout\n"
+            "  -q       no report\n", prog);
+}
@@ -0,0 +1,161 @@
+/**
+  ******************************************************************************
+  * @file    sim.h
+  * @author  Joe Todd
+  * @version
+  * @date
+  * @brief   Header for sim.c
+  *
+  * Host simulator. The firmware is compiled for Linux against the real
+  * device headers, with the peripheral regions mapped as ordinary memory
+  * at their real addresses, and runs on a virtual clock:
+  *
+  *     0x08000000  flash, 512KB, erased at start
+  *     0x40000000  APB1, APB2, AHB1 peripherals
+  *     0x50000000  AHB2 peripherals
+  *     0xE0000000  core peripherals: NVIC, SCB, DWT, CoreDebug
+  *
+  * The shadow stm32f4xx.h in this directory routes every access to a
+  * peripheral that the firmware polls or reads back through sim_reg().
+  * That charges the access against the virtual clock, brings each model
+  * up to date (folding in what the firmware wrote since the last access)
+  * and delivers any interrupt that has come due. GPIO and the DMA streams
+  * are left as plain memory, since the firmware puts their addresses in
+  * constant tables; the models pick up their writes at the next access.
+  * __WFI jumps the clock to the next event instead of spinning.
+  *
+  * Time only advances for register accesses, interrupt entry, conversions
+  * the firmware waits on and flash programming, not for instructions, so
+  * busy time is an estimate of the peripheral-bound part of each wake.
+  ******************************************************************************
+*/
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef SIM_H
+#define SIM_H
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include "stm32f4xx.h"
+
+#define SIM_NS              1000000000ull
+#define SIM_NEVER           UINT64_MAX
+#define SIM_ACCESS_CYCLES   4u          /* per register access */
+#define SIM_IRQ_CYCLES      24u         /* exception entry and return */
+#define SIM_LSI_HZ          32000u
+
+typedef struct {
+    uint64_t accesses;      /* register accesses */
+    uint64_t irqs;          /* interrupts taken */
+    uint64_t wakes;         /* WFI that slept and woke */
+    uint64_t sleep_ns;      /* time in WFI */
+} sim_stats_t;
+
+/**
+ * Virtual time since power up, in ns.
+ */
+extern uint64_t sim_now;
+
+extern sim_stats_t sim_stats;
+
+/**
+ * Charge 'ns' of CPU time, for a stall the firmware cannot see past.
+ */
+extern void sim_advance(uint64_t ns);
+
+/**
+ * Core clock cycles to ns at the current HCLK.
+ */
+extern uint64_t sim_cycles_ns(uint64_t cycles);
+
+/**
+ * Bring every model up to sim_now.
+ */
+extern void sim_sync(void);
+
+/**
+ * Raise or drop an interrupt line. Lines are levels: one that is still
+ * high when its handler returns is taken again.
+ */
+extern void sim_irq_set(IRQn_Type irq, bool level);
+
+/**
+ * Interrupt levels for IRQn 32 x w to 32 x w + 31.
+ */
+extern uint32_t sim_irq_lines(uint32_t w);
+
+/**
+ * Map pending bits by IRQn to bits by handler, lowest IRQn first.
+ */
+extern uint32_t sim_vector_pending(uint32_t const *pending);
+
+/*
+ * Behind the shadow core_cmFunc.h and core_cmInstr.h.
+ */
+extern uint32_t sim_get_primask(void);
+extern void sim_set_primask(uint32_t mask);
+extern void sim_wfi(void);
+extern void sim_barrier(void);
+
+/**
+ * Stop the run and report; does not return. A reset ends the run too,
+ * since the firmware's RAM cannot be put back to its power up state.
+ */
+extern void sim_finish(void) __attribute__((noreturn));
+extern void sim_reset(char const *why) __attribute__((noreturn));
+
+/*
+ * Models. Each sync folds in the firmware's writes and advances to
+ * sim_now; each next returns when it will next raise an interrupt or
+ * change state the firmware waits on, or SIM_NEVER.
+ */
+extern void sim_core_init(void);
+extern void sim_core_sync(void);
+extern uint32_t sim_core_pending(void);
+
+extern void sim_rcc_init(void);
+extern void sim_rcc_sync(void);
+extern uint32_t sim_rcc_hclk(void);
+extern uint32_t sim_rcc_pclk1(void);
+extern uint32_t sim_rcc_pclk2(void);
+extern uint32_t sim_rcc_timclk1(void);
+
+extern bool sim_gpio_out(uint32_t port, uint32_t pin);
+extern void sim_spi_sync(void);
+extern void sim_sdio_sync(void);
+
+extern void sim_tim_init(void);
+extern void sim_tim_sync(void);
+extern uint64_t sim_tim_next(void);
+
+extern void sim_adc_init(void);
+extern void sim_adc_sync(void);
+extern uint64_t sim_adc_next(void);
+
+extern void sim_dma_init(void);
+extern void sim_dma_sync(void);
+extern uint64_t sim_dma_next(void);
+extern bool sim_dma_push(uint32_t periph, uint32_t value);
+
+extern void sim_usart_init(FILE *out, FILE *in);
+extern void sim_usart_sync(void);
+extern uint64_t sim_usart_next(void);
+extern uint32_t sim_usart_baud(void);
+extern void sim_usart_tx(uint8_t const *buf, uint32_t len);
+extern void sim_usart_irq_done(void);
+extern uint64_t sim_usart_tx_bytes(void);
+
+extern void sim_rtc_init(void);
+extern void sim_rtc_sync(void);
+
+extern void sim_flash_init(void);
+extern void sim_flash_sync(void);
+extern uint64_t sim_flash_next(void);
+
+extern void sim_iwdg_init(void);
+extern void sim_iwdg_sync(void);
+extern uint64_t sim_iwdg_next(void);
+
+#endif
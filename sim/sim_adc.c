@@ -0,0 +1,128 @@
+/**
+  ******************************************************************************
+  * @file    sim_adc.c
+  * @author  Joe Todd
+  * @version
+  * @date    October 2026
+  * @brief   Autogrow
+  *          Host simulator: ADC1 regular conversions, by software start.
+  *
+  * SWSTART runs the regular sequence, one channel at a time, each taking
+  * its sample time plus 12 ADC clocks. The value comes from the plant.
+  * Each conversion sets EOC and, with CR2.DMA, goes out on DMA; CONT
+  * starts the sequence again.
+  ******************************************************************************
+*/
+
+#include "sim.h"
+#include "plant.h"
+
+static uint16_t const smp_cycles[8] = {3, 15, 28, 56, 84, 112, 144, 480};
+
+static bool running;
+static uint32_t rank;               /* in the sequence */
+static uint64_t done_at;            /* current conversion */
+static uint32_t sr;
+
+static uint32_t adc_channel(uint32_t r);
+static uint64_t adc_conv_ns(uint32_t ch);
+
+extern void
+sim_adc_init(void)
+{
+    running = false;
+    rank = 0;
+    done_at = SIM_NEVER;
+    sr = 0;
+}
+
+extern void
+sim_adc_sync(void)
+{
+    uint32_t len;
+    uint32_t ch;
+    uint32_t v;
+
+    sr &= ADC1->SR;             /* flags are cleared by writing zero */
+
+    if ((ADC1->CR2 & ADC_CR2_ADON) == 0) {
+        running = false;
+    }
+    if ((ADC1->CR2 & ADC_CR2_SWSTART) && (ADC1->CR2 & ADC_CR2_ADON)) {
+        ADC1->CR2 &= ~ADC_CR2_SWSTART;
+        sr &= ~ADC_SR_EOC;
+        sr |= ADC_SR_STRT;
+        running = true;
+        rank = 0;
+        done_at = sim_now + adc_conv_ns(adc_channel(0));
+    }
+
+    while (running && sim_now >= done_at) {
+        ch = adc_channel(rank);
+        v = plant_adc(ch);
+        ADC1->DR = v;
+        sr |= ADC_SR_EOC;
+        if (ADC1->CR2 & ADC_CR2_DMA) {
+            (void) sim_dma_push((uint32_t) (uintptr_t) &ADC1->DR, v);
+        }
+
+        len = (ADC1->CR1 & ADC_CR1_SCAN) ?
+              ((ADC1->SQR1 >> 20) & 0xFu) + 1u : 1u;
+        if (++rank >= len) {
+            rank = 0;
+            if ((ADC1->CR2 & ADC_CR2_CONT) == 0) {
+                running = false;
+                break;
+            }
+        }
+        done_at += adc_conv_ns(adc_channel(rank));
+    }
+
+    ADC1->SR = sr;
+}
+
+extern uint64_t
+sim_adc_next(void)
+{
+    /*
+     * No interrupt, but a sleep must not step over a conversion.
+     */
+    return running ? done_at : SIM_NEVER;
+}
+
+/*
+ * Channel at rank 'r' of the regular sequence.
+ */
+static uint32_t
+adc_channel(uint32_t r)
+{
+    uint32_t sqr;
+
+    if (r < 6u) {
+        sqr = ADC1->SQR3;
+    }
+    else if (r < 12u) {
+        sqr = ADC1->SQR2;
+    }
+    else {
+        sqr = ADC1->SQR1;
+    }
+
+    return (sqr >> ((r % 6u) * 5u)) & 0x1Fu;
+}
+
+static uint64_t
+adc_conv_ns(uint32_t ch)
+{
+    uint32_t adcclk = sim_rcc_pclk2() / (2u * (((ADC->CCR >> 16) & 3u) + 1u));
+    uint32_t smp;
+
+    if (ch > 9u) {
+        smp = (ADC1->SMPR1 >> ((ch - 10u) * 3u)) & 7u;
+    }
+    else {
+        smp = (ADC1->SMPR2 >> (ch * 3u)) & 7u;
+    }
+
+    return ((uint64_t) smp_cycles[smp] + 12u) * SIM_NS / adcclk;
+}
@@ -0,0 +1,75 @@
+/**
+  ******************************************************************************
+  * @file    sim_core.c
+  * @author  Joe Todd
+  * @version
+  * @date    October 2026
+  * @brief   Autogrow
+  *          Host simulator: NVIC, SCB reset request and the DWT cycle counter.
+  *
+  * ISER and ICER read as zero, so that each write is a fresh set of bits
+  * to enable or disable; the firmware never reads them back. ISPR shows
+  * what is pending, for the dispatcher's latency stamps. CYCCNT counts
+  * core clocks while awake: the core clock stops in WFI.
+  ******************************************************************************
+*/
+
+#include "sim.h"
+#include "utl.h"
+
+#define CORE_IRQ_WORDS      3u
+
+static uint32_t enabled[CORE_IRQ_WORDS];
+static uint32_t pending[CORE_IRQ_WORDS];
+static uint64_t last_busy;
+static uint64_t cyc_frac;           /* ns x HCLK not yet a whole cycle */
+
+extern void
+sim_core_init(void)
+{
+    uint32_t i;
+
+    for (i = 0; i < CORE_IRQ_WORDS; i++) {
+        enabled[i] = 0;
+        pending[i] = 0;
+    }
+    last_busy = 0;
+    cyc_frac = 0;
+}
+
+extern void
+sim_core_sync(void)
+{
+    uint64_t busy = sim_now - sim_stats.sleep_ns;
+    uint64_t num;
+    uint32_t i;
+
+    for (i = 0; i < CORE_IRQ_WORDS; i++) {
+        enabled[i] |= NVIC->ISER[i];
+        enabled[i] &= ~NVIC->ICER[i];
+        NVIC->ISER[i] = 0;
+        NVIC->ICER[i] = 0;
+        pending[i] = sim_irq_lines(i) & enabled[i];
+        NVIC->ISPR[i] = pending[i];
+    }
+
+    if ((SCB->AIRCR >> 16) == 0x05FAu &&
+        (SCB->AIRCR & SCB_AIRCR_SYSRESETREQ_Msk) != 0) {
+        sim_reset("software");
+    }
+    SCB->AIRCR = 0xFA050000u | (SCB->AIRCR & SCB_AIRCR_PRIGROUP_Msk);
+
+    if ((CoreDebug->DEMCR & CoreDebug_DEMCR_TRCENA_Msk) &&
+        (UTL_DWT_CTRL & UTL_DWT_CYCCNTENA)) {
+        num = cyc_frac + (busy - last_busy) * sim_rcc_hclk();
+        UTL_DWT_CYCCNT += (uint32_t) (num / SIM_NS);
+        cyc_frac = num % SIM_NS;
+    }
+    last_busy = busy;
+}
+
+extern uint32_t
+sim_core_pending(void)
+{
+    return sim_vector_pending(pending);
+}
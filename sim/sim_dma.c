@@ -0,0 +1,264 @@
+/**
+  ******************************************************************************
+  * @file    sim_dma.c
+  * @author  Joe Todd
+  * @version
+  * @date    October 2026
+  * @brief   Autogrow
+  *          Host simulator: DMA1 and DMA2 streams.
+  *
+  * A stream starts when its EN bit is seen set and stops when it is seen
+  * clear. Memory to memory copies are done at once. Memory to peripheral
+  * is only wired to USART1, and finishes once the bytes would have gone
+  * out at the line rate. Peripheral to memory streams are fed by the
+  * models through sim_dma_push(), with half and full transfer flags,
+  * circular reload and the enable cleared at the end of a normal one.
+  ******************************************************************************
+*/
+
+#include "sim.h"
+#include <string.h>
+
+#define DMA_NUM_STREAMS     16u
+#define DMA_DIR_P2M         0u
+#define DMA_DIR_M2P         1u
+#define DMA_DIR_M2M         2u
+#define DMA_FLAG_FE         0x01u
+#define DMA_FLAG_DME        0x04u
+#define DMA_FLAG_TE         0x08u
+#define DMA_FLAG_HT         0x10u
+#define DMA_FLAG_TC         0x20u
+#define DMA_USART1_DR       ((uint32_t) (uintptr_t) &USART1->DR)
+
+typedef struct {
+    bool active;
+    uint32_t items;         /* NDTR at the start */
+    uint64_t done_at;       /* memory to peripheral */
+} dma_stream_t;
+
+static DMA_Stream_TypeDef *const streams[DMA_NUM_STREAMS] = {
+    DMA1_Stream0, DMA1_Stream1, DMA1_Stream2, DMA1_Stream3,
+    DMA1_Stream4, DMA1_Stream5, DMA1_Stream6, DMA1_Stream7,
+    DMA2_Stream0, DMA2_Stream1, DMA2_Stream2, DMA2_Stream3,
+    DMA2_Stream4, DMA2_Stream5, DMA2_Stream6, DMA2_Stream7,
+};
+
+static IRQn_Type const irqs[DMA_NUM_STREAMS] = {
+    DMA1_Stream0_IRQn, DMA1_Stream1_IRQn, DMA1_Stream2_IRQn,
+    DMA1_Stream3_IRQn, DMA1_Stream4_IRQn, DMA1_Stream5_IRQn,
+    DMA1_Stream6_IRQn, DMA1_Stream7_IRQn, DMA2_Stream0_IRQn,
+    DMA2_Stream1_IRQn, DMA2_Stream2_IRQn, DMA2_Stream3_IRQn,
+    DMA2_Stream4_IRQn, DMA2_Stream5_IRQn, DMA2_Stream6_IRQn,
+    DMA2_Stream7_IRQn,
+};
+
+static uint8_t const flag_shift[4] = {0, 6, 16, 22};
+
+static dma_stream_t state[DMA_NUM_STREAMS];
+
+static void dma_start(uint32_t id);
+static void dma_copy(uint32_t id);
+static void dma_flag(uint32_t id, uint32_t flags);
+static uint32_t dma_flags(uint32_t id);
+static uint32_t dma_dir(uint32_t id);
+
+extern void
+sim_dma_init(void)
+{
+    memset(state, 0, sizeof(state));
+}
+
+extern void
+sim_dma_sync(void)
+{
+    DMA_Stream_TypeDef *s;
+    uint32_t enables;
+    uint32_t id;
+
+    DMA1->LISR &= ~DMA1->LIFCR;
+    DMA1->HISR &= ~DMA1->HIFCR;
+    DMA2->LISR &= ~DMA2->LIFCR;
+    DMA2->HISR &= ~DMA2->HIFCR;
+    DMA1->LIFCR = 0;
+    DMA1->HIFCR = 0;
+    DMA2->LIFCR = 0;
+    DMA2->HIFCR = 0;
+
+    for (id = 0; id < DMA_NUM_STREAMS; id++) {
+        s = streams[id];
+
+        if (!state[id].active && (s->CR & DMA_SxCR_EN)) {
+            dma_start(id);
+        }
+        else if (state[id].active && (s->CR & DMA_SxCR_EN) == 0) {
+            state[id].active = false;       /* stopped by the firmware */
+        }
+
+        if (state[id].active && dma_dir(id) == DMA_DIR_M2P &&
+            sim_now >= state[id].done_at) {
+            sim_usart_tx((uint8_t const *) (uintptr_t) s->M0AR, s->NDTR);
+            s->NDTR = 0;
+            s->CR &= ~DMA_SxCR_EN;
+            state[id].active = false;
+            dma_flag(id, DMA_FLAG_HT | DMA_FLAG_TC);
+        }
+
+        enables = 0;
+        enables |= (s->CR & DMA_SxCR_TCIE) ? DMA_FLAG_TC : 0;
+        enables |= (s->CR & DMA_SxCR_HTIE) ? DMA_FLAG_HT : 0;
+        enables |= (s->CR & DMA_SxCR_TEIE) ? DMA_FLAG_TE : 0;
+        enables |= (s->CR & DMA_SxCR_DMEIE) ? DMA_FLAG_DME : 0;
+        enables |= (s->FCR & DMA_SxFCR_FEIE) ? DMA_FLAG_FE : 0;
+        sim_irq_set(irqs[id], (dma_flags(id) & enables) != 0);
+    }
+}
+
+extern uint64_t
+sim_dma_next(void)
+{
+    uint64_t next = SIM_NEVER;
+    uint32_t id;
+
+    for (id = 0; id < DMA_NUM_STREAMS; id++) {
+        if (state[id].active && dma_dir(id) == DMA_DIR_M2P &&
+            state[id].done_at < next) {
+            next = state[id].done_at;
+        }
+    }
+
+    return next;
+}
+
+/**
+ * Hand 'value' from the peripheral register at 'periph' to the stream
+ * reading it, if there is one.
+ */
+extern bool
+sim_dma_push(uint32_t periph, uint32_t value)
+{
+    DMA_Stream_TypeDef *s;
+    uint32_t msize;
+    uint32_t done;
+    uint32_t id;
+    uintptr_t dst;
+
+    for (id = 0; id < DMA_NUM_STREAMS; id++) {
+        s = streams[id];
+        if (state[id].active && dma_dir(id) == DMA_DIR_P2M &&
+            s->PAR == periph && s->NDTR != 0) {
+            break;
+        }
+    }
+    if (id == DMA_NUM_STREAMS) {
+        return false;
+    }
+
+    msize = 1u << ((s->CR & DMA_SxCR_MSIZE) >> 13);
+    done = state[id].items - s->NDTR;
+    dst = s->M0AR + ((s->CR & DMA_SxCR_MINC) ? done * msize : 0);
+    memcpy((void *) dst, &value, msize);
+
+    s->NDTR--;
+    if (s->NDTR == state[id].items / 2u) {
+        dma_flag(id, DMA_FLAG_HT);
+    }
+    if (s->NDTR == 0) {
+        dma_flag(id, DMA_FLAG_TC);
+        if (s->CR & DMA_SxCR_CIRC) {
+            s->NDTR = state[id].items;
+        }
+        else {
+            s->CR &= ~DMA_SxCR_EN;
+            state[id].active = false;
+        }
+    }
+
+    return true;
+}
+
+static void
+dma_start(uint32_t id)
+{
+    DMA_Stream_TypeDef *s = streams[id];
+    uint32_t baud;
+
+    state[id].active = true;
+    state[id].items = s->NDTR;
+
+    switch (dma_dir(id)) {
+    case DMA_DIR_M2M:
+        dma_copy(id);
+        break;
+
+    case DMA_DIR_M2P:
+        baud = sim_usart_baud();
+        if (s->PAR != DMA_USART1_DR || baud == 0) {
+            dma_flag(id, DMA_FLAG_TE);
+            s->CR &= ~DMA_SxCR_EN;
+            state[id].active = false;
+            break;
+        }
+        state[id].done_at = sim_now + (uint64_t) s->NDTR * 10u * SIM_NS / baud;
+        break;
+
+    default:
+        break;
+    }
+}
+
+/*
+ * Memory to memory, all at once. The source is the peripheral port.
+ */
+static void
+dma_copy(uint32_t id)
+{
+    DMA_Stream_TypeDef *s = streams[id];
+    uint32_t psize = 1u << ((s->CR & DMA_SxCR_PSIZE) >> 11);
+    uint32_t msize = 1u << ((s->CR & DMA_SxCR_MSIZE) >> 13);
+    uint32_t size = (psize < msize) ? psize : msize;
+    uint32_t n = s->NDTR;
+    uint32_t i;
+    uintptr_t src = s->PAR;
+    uintptr_t dst = s->M0AR;
+
+    for (i = 0; i < n; i++) {
+        memcpy((void *) dst, (void const *) src, size);
+        src += (s->CR & DMA_SxCR_PINC) ? psize : 0;
+        dst += (s->CR & DMA_SxCR_MINC) ? msize : 0;
+    }
+
+    sim_advance(sim_cycles_ns((uint64_t) n * 2u));
+    s->NDTR = 0;
+    s->CR &= ~DMA_SxCR_EN;
+    state[id].active = false;
+    dma_flag(id, DMA_FLAG_HT | DMA_FLAG_TC);
+}
+
+static void
+dma_flag(uint32_t id, uint32_t flags)
+{
+    DMA_TypeDef *dma = (id < 8u) ? DMA1 : DMA2;
+    uint32_t shift = flag_shift[id & 3u];
+
+    if ((id & 4u) == 0) {
+        dma->LISR |= flags << shift;
+    }
+    else {
+        dma->HISR |= flags << shift;
+    }
+}
+
+static uint32_t
+dma_flags(uint32_t id)
+{
+    DMA_TypeDef *dma = (id < 8u) ? DMA1 : DMA2;
+    uint32_t shift = flag_shift[id & 3u];
+
+    return ((((id & 4u) == 0) ? dma->LISR : dma->HISR) >> shift) & 0x3Du;
+}
+
+static uint32_t
+dma_dir(uint32_t id)
+{
+    return (streams[id]->CR & DMA_SxCR_DIR) >> 6;
+}
@@ -0,0 +1,150 @@
+/**
+  ******************************************************************************
+  * @file    sim_flash.c
+  * @author  Joe Todd
+  * @version
+  * @date    October 2026
+  * @brief   Autogrow
+  *          Host simulator: embedded flash controller.
+  *
+  * The flash array is ordinary memory, so a program is seen afterwards by
+  * comparing it with a copy while PG is set. The new word is ANDed into
+  * the old, as programming can only clear bits, and BSY is held for the
+  * time a word takes. Sector erase fills the sector and holds BSY for a
+  * typical erase time. The std-periph driver runs unchanged on top.
+  ******************************************************************************
+*/
+
+#include "sim.h"
+#include <string.h>
+
+#define FLASH_BASE_ADDR     0x08000000u
+#define FLASH_SIZE          0x00080000u
+#define FLASH_WORDS         (FLASH_SIZE / 4u)
+#define FLASH_SECTORS       8u
+#define FLASH_WORD_NS       16000u          /* 16us per word, x32 */
+#define FLASH_SR_ERRORS     0xF2u
+
+typedef struct {
+    uint32_t addr;
+    uint32_t size;
+    uint64_t erase_ns;
+} flash_sector_t;
+
+static flash_sector_t const sectors[FLASH_SECTORS] = {
+    {0x08000000u, 0x04000u, 400000000ull},
+    {0x08004000u, 0x04000u, 400000000ull},
+    {0x08008000u, 0x04000u, 400000000ull},
+    {0x0800C000u, 0x04000u, 400000000ull},
+    {0x08010000u, 0x10000u, 1100000000ull},
+    {0x08020000u, 0x20000u, 2000000000ull},
+    {0x08040000u, 0x20000u, 2000000000ull},
+    {0x08060000u, 0x20000u, 2000000000ull},
+};
+
+static uint32_t copy[FLASH_WORDS];
+static uint32_t sr;
+static uint32_t keys;               /* KEY1 seen */
+static uint64_t busy_until;
+
+static void flash_program(void);
+
+extern void
+sim_flash_init(void)
+{
+    memset(copy, 0xFF, sizeof(copy));
+    sr = 0;
+    keys = 0;
+    busy_until = 0;
+    FLASH->CR = FLASH_CR_LOCK;
+}
+
+extern void
+sim_flash_sync(void)
+{
+    uint32_t s;
+
+    if (FLASH->SR != sr) {
+        sr &= ~FLASH->SR;           /* flags are cleared by writing one */
+    }
+
+    if (FLASH->KEYR != 0) {
+        if (FLASH->KEYR == 0x45670123u) {
+            keys = 1;
+        }
+        else if (FLASH->KEYR == 0xCDEF89ABu && keys == 1u) {
+            FLASH->CR &= ~FLASH_CR_LOCK;
+            keys = 0;
+        }
+        else {
+            keys = 0;
+        }
+        FLASH->KEYR = 0;
+    }
+
+    if (sim_now >= busy_until) {
+        sr &= ~FLASH_SR_BSY;
+    }
+
+    if ((sr & FLASH_SR_BSY) == 0 && (FLASH->CR & FLASH_CR_STRT)) {
+        FLASH->CR &= ~FLASH_CR_STRT;
+        s = (FLASH->CR >> 3) & 0xFu;
+        if ((FLASH->CR & FLASH_CR_LOCK) || (FLASH->CR & FLASH_CR_SER) == 0 ||
+            s >= FLASH_SECTORS) {
+            sr |= FLASH_SR_PGSERR;
+        }
+        else {
+            memset((void *) (uintptr_t) sectors[s].addr, 0xFF, sectors[s].size);
+            memset(&copy[(sectors[s].addr - FLASH_BASE_ADDR) / 4u], 0xFF,
+                   sectors[s].size);
+            busy_until = sim_now + sectors[s].erase_ns;
+            sr |= FLASH_SR_BSY;
+        }
+    }
+
+    if ((sr & FLASH_SR_BSY) == 0 && (FLASH->CR & FLASH_CR_PG)) {
+        flash_program();
+    }
+
+    FLASH->SR = sr;
+}
+
+extern uint64_t
+sim_flash_next(void)
+{
+    return (sr & FLASH_SR_BSY) ? busy_until : SIM_NEVER;
+}
+
+/*
+ * Find the words written since the last look and program them.
+ */
+static void
+flash_program(void)
+{
+    uint32_t volatile *array = (uint32_t volatile *) FLASH_BASE_ADDR;
+    uint32_t words = 0;
+    uint32_t i;
+
+    if (memcmp((void const *) array, copy, sizeof(copy)) == 0) {
+        return;
+    }
+
+    for (i = 0; i < FLASH_WORDS; i++) {
+        if (array[i] == copy[i]) {
+            continue;
+        }
+        if (FLASH->CR & FLASH_CR_LOCK) {
+            array[i] = copy[i];
+            sr |= FLASH_SR_WRPERR;
+            continue;
+        }
+        copy[i] &= array[i];
+        array[i] = copy[i];
+        words++;
+    }
+
+    if (words != 0) {
+        busy_until = sim_now + (uint64_t) words * FLASH_WORD_NS;
+        sr |= FLASH_SR_BSY;
+    }
+}
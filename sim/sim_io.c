@@ -0,0 +1,63 @@
+/**
+  ******************************************************************************
+  * @file    sim_io.c
+  * @author  Joe Todd
+  * @version
+  * @date    October 2026
+  * @brief   Autogrow
+  *          Host simulator: GPIO outputs and the buses with nothing on them.
+  *
+  * No SPI flash is fitted: every transfer completes at once and reads
+  * 0xFF, so slog_init() finds no chip and the firmware runs without its
+  * history. No SD card is fitted either: every command that
+  * expects a response times out.
+  ******************************************************************************
+*/
+
+#include "sim.h"
+
+#define GPIO_PORTS          5u
+#define GPIO_MODE_OUT       1u
+#define SDIO_STA            (*(volatile uint32_t *) &SDIO->STA)
+
+static GPIO_TypeDef *const ports[GPIO_PORTS] = {
+    GPIOA, GPIOB, GPIOC, GPIOD, GPIOE,
+};
+
+/**
+ * True if 'pin' of 'port' is an output driven high.
+ */
+extern bool
+sim_gpio_out(uint32_t port, uint32_t pin)
+{
+    GPIO_TypeDef *gpio;
+
+    if (port >= GPIO_PORTS || pin > 15u) {
+        return false;
+    }
+    gpio = ports[port];
+
+    return ((gpio->MODER >> (pin * 2u)) & 3u) == GPIO_MODE_OUT &&
+           (gpio->ODR & (1u << pin)) != 0;
+}
+
+extern void
+sim_spi_sync(void)
+{
+    SPI1->SR = SPI_SR_TXE | SPI_SR_RXNE;
+    SPI1->DR = 0xFFu;
+}
+
+extern void
+sim_sdio_sync(void)
+{
+    if (SDIO->ICR != 0) {
+        SDIO_STA &= ~SDIO->ICR;
+        SDIO->ICR = 0;
+    }
+    if (SDIO->CMD & SDIO_CMD_CPSMEN) {
+        SDIO_STA |= (SDIO->CMD & SDIO_CMD_WAITRESP) ?
+                     SDIO_STA_CTIMEOUT : SDIO_STA_CMDSENT;
+        SDIO->CMD &= ~SDIO_CMD_CPSMEN;
+    }
+}
@@ -0,0 +1,71 @@
+/**
+  ******************************************************************************
+  * @file    sim_iwdg.c
+  * @author  Joe Todd
+  * @version
+  * @date    October 2026
+  * @brief   Autogrow
+  *          Host simulator: independent watchdog.
+  *
+  * Started by 0xCCCC and reloaded by 0xAAAA in KR; once started, a
+  * reload that comes later than (RLR + 1) x 4 x 2^PR LSI periods resets
+  * the part, which ends the run. KR reads as zero, so every key written
+  * is seen.
+  ******************************************************************************
+*/
+
+#include "sim.h"
+
+#define IWDG_KEY_RELOAD     0xAAAAu
+#define IWDG_KEY_ENABLE     0xCCCCu
+
+static bool running;
+static uint64_t expires;
+
+static uint64_t iwdg_timeout_ns(void);
+
+extern void
+sim_iwdg_init(void)
+{
+    running = false;
+    expires = SIM_NEVER;
+    IWDG->RLR = 0xFFFu;
+}
+
+extern void
+sim_iwdg_sync(void)
+{
+    uint32_t key = IWDG->KR & 0xFFFFu;
+
+    if (running && sim_now >= expires) {
+        sim_reset("watchdog");
+    }
+
+    if (key == IWDG_KEY_ENABLE) {
+        running = true;
+    }
+    if (key == IWDG_KEY_ENABLE || key == IWDG_KEY_RELOAD) {
+        expires = sim_now + iwdg_timeout_ns();
+    }
+    IWDG->KR = 0;
+    IWDG->SR = 0;
+}
+
+extern uint64_t
+sim_iwdg_next(void)
+{
+    return running ? expires : SIM_NEVER;
+}
+
+static uint64_t
+iwdg_timeout_ns(void)
+{
+    uint32_t pr = IWDG->PR & 7u;
+
+    if (pr > 6u) {
+        pr = 6u;
+    }
+
+    return ((uint64_t) (IWDG->RLR & 0xFFFu) + 1u) * (4u << pr) * SIM_NS
+        / SIM_LSI_HZ;
+}
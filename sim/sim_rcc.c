@@ -0,0 +1,126 @@
+/**
+  ******************************************************************************
+  * @file    sim_rcc.c
+  * @author  Joe Todd
+  * @version
+  * @date    October 2026
+  * @brief   Autogrow
+  *          Host simulator: RCC clock tree and reset flags.
+  *
+  * Oscillators and the PLL are ready as soon as they are turned on, and
+  * SWS follows SW. The bus clocks come from SW and the AHB and APB
+  * prescalers; the timers on APB1 run at twice PCLK1 whenever it is
+  * divided down.
+  ******************************************************************************
+*/
+
+#include "sim.h"
+
+#define RCC_HSI_HZ          16000000u
+#define RCC_HSE_HZ          HSE_VALUE
+#define RCC_CSR_POR_PIN     (RCC_CSR_PORRSTF | RCC_CSR_PADRSTF)
+
+static uint32_t hclk;
+static uint32_t pclk1;
+static uint32_t pclk2;
+
+static uint32_t sim_rcc_apb_div(uint32_t ppre);
+
+extern void
+sim_rcc_init(void)
+{
+    RCC->CR = RCC_CR_HSION | RCC_CR_HSIRDY | (16u << 3);
+    RCC->CFGR = 0;
+    RCC->PLLCFGR = 0x24003010u;
+    RCC->CSR = RCC_CSR_POR_PIN;
+    sim_rcc_sync();
+}
+
+extern void
+sim_rcc_sync(void)
+{
+    static uint16_t const ahb_div[8] = {2, 4, 8, 16, 64, 128, 256, 512};
+    uint32_t cr = RCC->CR;
+    uint32_t cfgr = RCC->CFGR;
+    uint32_t pll = RCC->PLLCFGR;
+    uint32_t sw = cfgr & RCC_CFGR_SW;
+    uint32_t sysclk;
+    uint32_t src;
+    uint32_t m;
+
+    /*
+     * The HSI cannot be stopped while it clocks the system.
+     */
+    if (sw == RCC_CFGR_SW_HSI) {
+        cr |= RCC_CR_HSION;
+    }
+    cr &= ~(RCC_CR_HSIRDY | RCC_CR_HSERDY | RCC_CR_PLLRDY);
+    cr |= (cr & RCC_CR_HSION) ? RCC_CR_HSIRDY : 0;
+    cr |= (cr & RCC_CR_HSEON) ? RCC_CR_HSERDY : 0;
+    cr |= (cr & RCC_CR_PLLON) ? RCC_CR_PLLRDY : 0;
+    RCC->CR = cr;
+    RCC->CFGR = (cfgr & ~RCC_CFGR_SWS) | (sw << 2);
+
+    if (RCC->CSR & RCC_CSR_RMVF) {
+        RCC->CSR &= ~(RCC_CSR_RMVF | 0xFE000000u);
+    }
+    if (RCC->CSR & RCC_CSR_LSION) {
+        RCC->CSR |= RCC_CSR_LSIRDY;
+    }
+    else {
+        RCC->CSR &= ~RCC_CSR_LSIRDY;
+    }
+
+    switch (sw) {
+    case RCC_CFGR_SW_HSE:
+        sysclk = RCC_HSE_HZ;
+        break;
+
+    case RCC_CFGR_SW_PLL:
+        src = (pll & RCC_PLLCFGR_PLLSRC) ? RCC_HSE_HZ : RCC_HSI_HZ;
+        m = pll & RCC_PLLCFGR_PLLM;
+        sysclk = (uint32_t) ((uint64_t) src / (m ? m : 2u)
+                             * ((pll & RCC_PLLCFGR_PLLN) >> 6)
+                             / ((((pll & RCC_PLLCFGR_PLLP) >> 16) + 1u) * 2u));
+        break;
+
+    default:
+        sysclk = RCC_HSI_HZ;
+        break;
+    }
+
+    m = (cfgr & RCC_CFGR_HPRE) >> 4;
+    hclk = (m & 8u) ? sysclk / ahb_div[m & 7u] : sysclk;
+    pclk1 = hclk / sim_rcc_apb_div((cfgr & RCC_CFGR_PPRE1) >> 10);
+    pclk2 = hclk / sim_rcc_apb_div((cfgr & RCC_CFGR_PPRE2) >> 13);
+}
+
+extern uint32_t
+sim_rcc_hclk(void)
+{
+    return hclk;
+}
+
+extern uint32_t
+sim_rcc_pclk1(void)
+{
+    return pclk1;
+}
+
+extern uint32_t
+sim_rcc_pclk2(void)
+{
+    return pclk2;
+}
+
+extern uint32_t
+sim_rcc_timclk1(void)
+{
+    return (pclk1 == hclk) ? pclk1 : pclk1 * 2u;
+}
+
+static uint32_t
+sim_rcc_apb_div(uint32_t ppre)
+{
+    return (ppre & 4u) ? 2u << (ppre & 3u) : 1u;
+}
@@ -0,0 +1,124 @@
+/**
+  ******************************************************************************
+  * @file    sim_rtc.c
+  * @author  Joe Todd
+  * @version
+  * @date    October 2026
+  * @brief   Autogrow
+  *          Host simulator: RTC calendar.
+  *
+  * INITF follows INIT. Leaving init mode takes the time and date the
+  * firmware wrote as the start; from then on, while RTCEN is set, TR and
+  * DR show that plus the time since, in BCD, on the 2000-2099 calendar
+  * rtc.c reads. The backup registers are plain memory.
+  ******************************************************************************
+*/
+
+#include "sim.h"
+
+static bool counting;
+static bool in_init;
+static uint64_t start_s;            /* calendar seconds at start_ns */
+static uint64_t start_ns;
+
+static uint32_t rtc_bcd(uint32_t v);
+static uint32_t rtc_from_bcd(uint32_t reg, uint32_t shift, uint32_t mask);
+static bool rtc_leap(uint32_t year);
+
+extern void
+sim_rtc_init(void)
+{
+    counting = false;
+    in_init = false;
+    start_s = 0;
+    start_ns = 0;
+    RTC->DR = 0x00002101u;
+    RTC->PRER = 0x007F00FFu;
+}
+
+extern void
+sim_rtc_sync(void)
+{
+    static uint8_t const mdays[12] = {
+        31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31,
+    };
+    uint32_t year;
+    uint32_t month;
+    uint32_t days;
+    uint32_t dim;
+    uint64_t s;
+
+    if (RTC->ISR & RTC_ISR_INIT) {
+        RTC->ISR |= RTC_ISR_INITF;
+        in_init = true;
+        return;
+    }
+    RTC->ISR &= ~RTC_ISR_INITF;
+
+    if (in_init) {
+        /*
+         * Leaving init: count on from what was written.
+         */
+        in_init = false;
+        year = rtc_from_bcd(RTC->DR, 16, 0xFF);
+        month = rtc_from_bcd(RTC->DR, 8, 0x1F);
+        days = rtc_from_bcd(RTC->DR, 0, 0x3F) - 1u;
+        while (year-- > 0) {
+            days += rtc_leap(year) ? 366u : 365u;
+        }
+        year = rtc_from_bcd(RTC->DR, 16, 0xFF);
+        while (--month > 0) {
+            days += mdays[month - 1u];
+            days += (month == 2u && rtc_leap(year)) ? 1u : 0u;
+        }
+        start_s = (uint64_t) days * 86400u
+            + rtc_from_bcd(RTC->TR, 16, 0x3F) * 3600u
+            + rtc_from_bcd(RTC->TR, 8, 0x7F) * 60u
+            + rtc_from_bcd(RTC->TR, 0, 0x7F);
+        start_ns = sim_now;
+        counting = true;
+    }
+
+    if (!counting || (RCC->BDCR & RCC_BDCR_RTCEN) == 0) {
+        return;
+    }
+
+    s = start_s + (sim_now - start_ns) / SIM_NS;
+    RTC->TR = (rtc_bcd((uint32_t) (s / 3600u % 24u)) << 16)
+        | (rtc_bcd((uint32_t) (s / 60u % 60u)) << 8)
+        | rtc_bcd((uint32_t) (s % 60u));
+
+    days = (uint32_t) (s / 86400u);
+    for (year = 0; days >= (rtc_leap(year) ? 366u : 365u); year++) {
+        days -= rtc_leap(year) ? 366u : 365u;
+    }
+    for (month = 1; month < 12u; month++) {
+        dim = mdays[month - 1u] + ((month == 2u && rtc_leap(year)) ? 1u : 0u);
+        if (days < dim) {
+            break;
+        }
+        days -= dim;
+    }
+    RTC->DR = (rtc_bcd(year % 100u) << 16) | (rtc_bcd(month) << 8)
+        | rtc_bcd(days + 1u);
+}
+
+static uint32_t
+rtc_bcd(uint32_t v)
+{
+    return ((v / 10u) << 4) | (v % 10u);
+}
+
+static uint32_t
+rtc_from_bcd(uint32_t reg, uint32_t shift, uint32_t mask)
+{
+    uint32_t v = (reg >> shift) & mask;
+
+    return (v >> 4) * 10u + (v & 0xFu);
+}
+
+static bool
+rtc_leap(uint32_t year)
+{
+    return (year % 4u) == 0;
+}
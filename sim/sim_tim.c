@@ -0,0 +1,221 @@
+/**
+  ******************************************************************************
+  * @file    sim_tim.c
+  * @author  Joe Todd
+  * @version
+  * @date    October 2026
+  * @brief   Autogrow
+  *          Host simulator: TIM2 and TIM5, up counting with compare 1.
+  *
+  * Enough of a general purpose timer for timer.c: the prescaler and, with
+  * ARPE, the reload take effect at an update event; UG resets the count
+  * and raises UIF unless URS is set; CC1IF is raised as the count reaches
+  * CCR1. Time not yet a whole tick is carried in units of ns x Hz, so the
+  * counters keep step with the clock over any length of run.
+  ******************************************************************************
+*/
+
+#include "sim.h"
+
+#define TIM_NUM             2u
+#define TIM_SR_MASK         0x5Fu
+
+typedef unsigned __int128 u128;
+
+typedef struct {
+    TIM_TypeDef *regs;
+    IRQn_Type irq;
+    uint32_t rcc_en;        /* in APB1ENR */
+    bool cen;
+    uint32_t cnt;
+    uint32_t psc;           /* in effect */
+    uint32_t arr;           /* in effect */
+    uint32_t sr;
+    u128 acc;               /* ns x Hz towards the next tick */
+    uint64_t last;
+} tim_t;
+
+static tim_t tims[TIM_NUM] = {
+    {TIM2, TIM2_IRQn, RCC_APB1ENR_TIM2EN},
+    {TIM5, TIM5_IRQn, RCC_APB1ENR_TIM5EN},
+};
+
+static void tim_advance(tim_t *t, uint64_t ticks);
+static uint64_t tim_to_compare(tim_t const *t);
+static uint64_t tim_to_update(tim_t const *t);
+
+extern void
+sim_tim_init(void)
+{
+    uint32_t i;
+    tim_t *t;
+
+    for (i = 0; i < TIM_NUM; i++) {
+        t = &tims[i];
+        t->cen = false;
+        t->cnt = 0;
+        t->psc = 0;
+        t->arr = 0xFFFFFFFFu;
+        t->sr = 0;
+        t->acc = 0;
+        t->last = sim_now;
+        t->regs->ARR = 0xFFFFFFFFu;
+    }
+}
+
+extern void
+sim_tim_sync(void)
+{
+    TIM_TypeDef *r;
+    uint64_t clk = sim_rcc_timclk1();
+    u128 den;
+    u128 num;
+    uint32_t i;
+    tim_t *t;
+    bool cnt_written;
+
+    for (i = 0; i < TIM_NUM; i++) {
+        t = &tims[i];
+        r = t->regs;
+        cnt_written = r->CNT != t->cnt;
+
+        /*
+         * Flags are cleared by writing zero to them.
+         */
+        t->sr &= r->SR;
+
+        if (t->cen) {
+            den = (u128) (t->psc + 1u) * SIM_NS;
+            num = t->acc + (u128) (sim_now - t->last) * clk;
+            t->acc = num % den;
+            tim_advance(t, (uint64_t) (num / den));
+        }
+        t->last = sim_now;
+
+        if (cnt_written) {
+            t->cnt = r->CNT;
+            t->acc = 0;
+        }
+        if (r->EGR & TIM_EGR_UG) {
+            r->EGR = 0;
+            t->cnt = 0;
+            t->acc = 0;
+            t->psc = r->PSC & 0xFFFFu;
+            t->arr = r->ARR;
+            if ((r->CR1 & TIM_CR1_URS) == 0) {
+                t->sr |= TIM_SR_UIF;
+            }
+        }
+        if ((r->CR1 & TIM_CR1_ARPE) == 0) {
+            t->arr = r->ARR;
+        }
+        t->cen = (r->CR1 & TIM_CR1_CEN) && (RCC->APB1ENR & t->rcc_en);
+
+        r->CNT = t->cnt;
+        r->SR = t->sr;
+        sim_irq_set(t->irq, (t->sr & r->DIER & TIM_SR_MASK) != 0);
+    }
+}
+
+extern uint64_t
+sim_tim_next(void)
+{
+    uint64_t next = SIM_NEVER;
+    uint64_t clk = sim_rcc_timclk1();
+    uint64_t ticks;
+    uint64_t t_ns;
+    u128 den;
+    uint32_t i;
+    tim_t *t;
+
+    for (i = 0; i < TIM_NUM; i++) {
+        t = &tims[i];
+        if (!t->cen) {
+            continue;
+        }
+
+        ticks = SIM_NEVER;
+        if (t->regs->DIER & TIM_DIER_UIE) {
+            ticks = tim_to_update(t);
+        }
+        if ((t->regs->DIER & TIM_DIER_CC1IE) && tim_to_compare(t) < ticks) {
+            ticks = tim_to_compare(t);
+        }
+        if (ticks == SIM_NEVER) {
+            continue;
+        }
+
+        den = (u128) (t->psc + 1u) * SIM_NS;
+        t_ns = (uint64_t) ((ticks * den - t->acc + clk - 1u) / clk);
+        if (t->last + t_ns < next) {
+            next = t->last + t_ns;
+        }
+    }
+
+    return next;
+}
+
+/*
+ * Count 'ticks', raising CC1IF and UIF on the way.
+ */
+static void
+tim_advance(tim_t *t, uint64_t ticks)
+{
+    uint64_t to_update;
+    uint64_t period;
+
+    if (ticks == 0) {
+        return;
+    }
+
+    if (ticks >= tim_to_compare(t)) {
+        t->sr |= TIM_SR_CC1IF;
+    }
+
+    to_update = tim_to_update(t);
+    if (ticks < to_update) {
+        t->cnt += (uint32_t) ticks;
+        return;
+    }
+
+    /*
+     * Update event: the preloaded prescaler and reload take effect.
+     */
+    t->sr |= TIM_SR_UIF;
+    t->psc = t->regs->PSC & 0xFFFFu;
+    t->arr = t->regs->ARR;
+    period = (uint64_t) t->arr + 1u;
+    t->cnt = (uint32_t) ((ticks - to_update) % period);
+}
+
+/*
+ * Ticks until the count next reaches CCR1.
+ */
+static uint64_t
+tim_to_compare(tim_t const *t)
+{
+    uint64_t period = (uint64_t) t->arr + 1u;
+    uint64_t ccr = t->regs->CCR1;
+
+    if (ccr > t->arr) {
+        return SIM_NEVER;
+    }
+    if (ccr > t->cnt) {
+        return ccr - t->cnt;
+    }
+
+    return period - t->cnt + ccr;
+}
+
+/*
+ * Ticks until the count passes ARR.
+ */
+static uint64_t
+tim_to_update(tim_t const *t)
+{
+    if (t->cnt > t->arr) {
+        return 0x100000000ull - t->cnt;
+    }
+
+    return (uint64_t) t->arr - t->cnt + 1u;
+}
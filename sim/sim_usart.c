@@ -0,0 +1,137 @@
+/**
+  ******************************************************************************
+  * @file    sim_usart.c
+  * @author  Joe Todd
+  * @version
+  * @date    October 2026
+  * @brief   Autogrow
+  *          Host simulator: USART1.
+  *
+  * What the firmware sends goes to a file, so telemetry can be decoded
+  * with tools/telem_decode.py. What it receives comes from a script of
+  * lines "<seconds> <text>": at that time the text and a newline arrive
+  * all at once, on DMA if a stream is reading DR, and the line then goes
+  * idle.
+  ******************************************************************************
+*/
+
+#include "sim.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define USART_LINE          256u
+
+static FILE *tx_file;
+static FILE *rx_file;
+static uint64_t tx_bytes;
+static uint64_t rx_at;
+static char rx_line[USART_LINE];
+static uint32_t sr;
+
+static void usart_rx_load(void);
+
+extern void
+sim_usart_init(FILE *out, FILE *in)
+{
+    tx_file = out;
+    rx_file = in;
+    tx_bytes = 0;
+    sr = USART_SR_TXE | USART_SR_TC;
+    usart_rx_load();
+}
+
+extern void
+sim_usart_sync(void)
+{
+    bool on = (USART1->CR1 & USART_CR1_UE) != 0;
+    uint32_t cr1 = USART1->CR1;
+    uint32_t i;
+
+    if (on && (cr1 & USART_CR1_RE) && sim_now >= rx_at) {
+        for (i = 0; rx_line[i] != '\0'; i++) {
+            if (!sim_dma_push((uint32_t) (uintptr_t) &USART1->DR,
+                              (uint8_t) rx_line[i])) {
+                USART1->DR = (uint8_t) rx_line[i];
+                sr |= USART_SR_RXNE;
+            }
+        }
+        sr |= USART_SR_IDLE;
+        usart_rx_load();
+    }
+
+    USART1->SR = sr;
+    sim_irq_set(USART1_IRQn,
+                ((cr1 & USART_CR1_IDLEIE) && (sr & USART_SR_IDLE)) ||
+                ((cr1 & USART_CR1_RXNEIE) && (sr & USART_SR_RXNE)));
+}
+
+extern uint64_t
+sim_usart_next(void)
+{
+    return ((USART1->CR1 & USART_CR1_UE) && (USART1->CR1 & USART_CR1_RE)) ?
+           rx_at : SIM_NEVER;
+}
+
+extern uint32_t
+sim_usart_baud(void)
+{
+    if ((USART1->CR1 & USART_CR1_UE) == 0 || USART1->BRR == 0) {
+        return 0;
+    }
+
+    return sim_rcc_pclk2() / USART1->BRR;
+}
+
+extern void
+sim_usart_tx(uint8_t const *buf, uint32_t len)
+{
+    tx_bytes += len;
+    if (tx_file != NULL) {
+        (void) fwrite(buf, 1, len, tx_file);
+    }
+}
+
+/**
+ * The handler has read SR then DR, which clears IDLE and RXNE.
+ */
+extern void
+sim_usart_irq_done(void)
+{
+    sr &= ~(USART_SR_IDLE | USART_SR_RXNE);
+    USART1->SR = sr;
+}
+
+extern uint64_t
+sim_usart_tx_bytes(void)
+{
+    return tx_bytes;
+}
+
+/*
+ * Read the next line of the script, or never.
+ */
+static void
+usart_rx_load(void)
+{
+    char buf[USART_LINE];
+    char *text;
+    double at;
+
+    rx_at = SIM_NEVER;
+    rx_line[0] = '\0';
+    if (rx_file == NULL) {
+        return;
+    }
+
+    while (fgets(buf, sizeof(buf), rx_file) != NULL) {
+        at = strtod(buf, &text);
+        if (text == buf || buf[0] == '#') {
+            continue;
+        }
+        text += strspn(text, " \t");
+        text[strcspn(text, "\r\n")] = '\0';
+        (void) snprintf(rx_line, sizeof(rx_line), "%s\n", text);
+        rx_at = (at <= 0.0) ? 0 : (uint64_t) (at * SIM_NS);
+        return;
+    }
+}
@@ -0,0 +1,67 @@
+/**
+  ******************************************************************************
+  * @file    stm32f4xx.h
+  * @author  Joe Todd
+  * @version
+  * @date
+  * @brief   Host build shadow of lib/inc/stm32f4xx.h
+  *
+  * Takes the real device header, whose core intrinsics come from the
+  * host versions in this directory, then points each peripheral the
+  * firmware polls or reads back at sim_reg(), so that every access first
+  * brings the simulation up to date. See sim.h.
+  *
+  * GPIO and the DMA streams keep their constant addresses: the firmware
+  * builds tables of them, and neither is polled.
+  ******************************************************************************
+*/
+
+#ifndef SIM_STM32F4XX_H
+#define SIM_STM32F4XX_H
+
+#include "../lib/inc/stm32f4xx.h"
+
+/**
+ * Account for one register access and return 'base'.
+ */
+extern void *sim_reg(uint32_t base);
+
+#ifndef SIM_MODEL
+
+#undef ADC
+#undef ADC1
+#undef TIM2
+#undef TIM5
+#undef RCC
+#undef RTC
+#undef PWR
+#undef IWDG
+#undef USART1
+#undef SPI1
+#undef SDIO
+#undef CRC
+#undef FLASH
+#undef DMA1
+#undef DMA2
+#undef NVIC
+
+#define ADC         ((ADC_Common_TypeDef *) sim_reg(ADC_BASE))
+#define ADC1        ((ADC_TypeDef *) sim_reg(ADC1_BASE))
+#define TIM2        ((TIM_TypeDef *) sim_reg(TIM2_BASE))
+#define TIM5        ((TIM_TypeDef *) sim_reg(TIM5_BASE))
+#define RCC         ((RCC_TypeDef *) sim_reg(RCC_BASE))
+#define RTC         ((RTC_TypeDef *) sim_reg(RTC_BASE))
+#define PWR         ((PWR_TypeDef *) sim_reg(PWR_BASE))
+#define IWDG        ((IWDG_TypeDef *) sim_reg(IWDG_BASE))
+#define USART1      ((USART_TypeDef *) sim_reg(USART1_BASE))
+#define SPI1        ((SPI_TypeDef *) sim_reg(SPI1_BASE))
+#define SDIO        ((SDIO_TypeDef *) sim_reg(SDIO_BASE))
+#define CRC         ((CRC_TypeDef *) sim_reg(CRC_BASE))
+#define FLASH       ((FLASH_TypeDef *) sim_reg(FLASH_R_BASE))
+#define DMA1        ((DMA_TypeDef *) sim_reg(DMA1_BASE))
+#define DMA2        ((DMA_TypeDef *) sim_reg(DMA2_BASE))
+#define NVIC        ((NVIC_Type *) sim_reg(NVIC_BASE))
+
+#endif
+
+#endif
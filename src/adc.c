@@ -8,14 +8,21 @@
  *
  ******************************************************************************/
 #include "adc.h"
+#include "string.h"
 
 #define ADC_CHAN	11u
+#define ADC_SAMPLE_3_CYCLES     0u
 #define ADC_SAMPLE_144_CYCLES	6u
 
+#define ADC_DMA                 DMA_STREAM(2, 0)
+#define ADC_DMA_CHAN            0u
+
 static uint16_t adc_reading;
 static uint32_t adc_conv_cnt;
+static adc_half_callback_fn adc_half_cb;
 
 static void adc_configure_sample_time(uint32_t ch, uint32_t smp);
+static void adc_dma_event(uint32_t flags, void *arg);
 
 /*
  * Initialise the ADC.
@@ -66,6 +73,178 @@ adc_get_measurement(void)
 	return ADC1->DR;
 }
 
+/*
+ * One DMA transfer per sequence: SCAN only raises EOC at the end, so
+ * without DMA every result but the last would be overwritten. Each
+ * channel gets the same 144 cycles (1.2ms at ADCCLK 125kHz) as a single
+ * reading, since the probes are high impedance.
+ */
+extern bool
+adc_scan(uint8_t const *chans, uint32_t n, uint16_t *out)
+{
+    DMA_Stream_TypeDef cfg;
+    __IO uint32_t *sqr;
+    uint32_t i;
+
+    if (n == 0 || n > ADC_SCAN_MAX) {
+        return false;
+    }
+    for (i = 0; i < n; i++) {
+        if (chans[i] >= ADC_CHANNELS) {
+            return false;
+        }
+    }
+    if (dma_claim(ADC_DMA, ADC_DMA_CHAN, NULL, NULL) != dma_ok) {
+        return false;
+    }
+
+    /*
+     * SQ1..SQ6 in SQR3, SQ7..SQ12 in SQR2, SQ13..SQ16 and the length in
+     * SQR1.
+     */
+    ADC1->SQR1 = (n - 1u) << 20;
+    ADC1->SQR2 = 0;
+    ADC1->SQR3 = 0;
+    for (i = 0; i < n; i++) {
+        sqr = (i < 6u) ? &ADC1->SQR3 : (i < 12u) ? &ADC1->SQR2 : &ADC1->SQR1;
+        *sqr |= (uint32_t) chans[i] << ((i % 6u) * 5u);
+        adc_configure_sample_time(chans[i], ADC_SAMPLE_144_CYCLES);
+    }
+
+    cfg.PAR = (uint32_t) &ADC1->DR;
+    cfg.M0AR = (uint32_t) out;
+    cfg.M1AR = 0;
+    cfg.NDTR = n;
+    cfg.FCR = 0;
+    cfg.CR = (2u << DMA_CR_PL_Pos)
+        | (1u << DMA_CR_MSIZE_Pos)
+        | (1u << DMA_CR_PSIZE_Pos)
+        | (1u << DMA_CR_MINC_Pos);
+    dma_configure(ADC_DMA, &cfg);
+    dma_start(ADC_DMA);
+
+    ADC1->CR1 = ADC_CR1_SCAN;
+    ADC1->CR2 = ADC_CR2_ADON | ADC_CR2_DMA;
+    ADC1->CR2 |= ADC_CR2_SWSTART;
+
+    /*
+     * The stream turns itself off after the last item.
+     */
+    while ((dma_stream(ADC_DMA)->CR & DMA_SxCR_EN) != 0);
+    (void) dma_ack(ADC_DMA);
+    dma_release(ADC_DMA);
+
+    /*
+     * Back to single conversions of the default channel.
+     */
+    ADC1->CR1 = 0;
+    ADC1->CR2 = ADC_CR2_ADON | ADC_CR2_EOCS;
+    ADC1->SQR1 = 0;
+    ADC1->SQR2 = 0;
+    ADC1->SQR3 = ADC_CHAN << 0u;
+
+    return true;
+}
+
+extern bool
+adc_channel_pin(uint32_t ch, iox_port_t *port, uint32_t *pin)
+{
+    if (ch < 8u) {
+        *port = iox_port_a;
+        *pin = ch;
+    }
+    else if (ch < 10u) {
+        *port = iox_port_b;
+        *pin = ch - 8u;
+    }
+    else if (ch < ADC_CHANNELS) {
+        *port = iox_port_c;
+        *pin = ch - 10u;
+    }
+    else {
+        return false;
+    }
+
+    return true;
+}
+
+/*
+ * Convert continuously into a circular buffer. 'cb' is called from the
+ * DMA interrupt with 0 when the first half of 'buf' is full and 1 when
+ * the second half is.
+ *
+ * ADCCLK = PCLK2 / 2 = 125kHz, 3 + 12 cycles per conversion: 8.3ksps.
+ * Returns false if the DMA stream is in use.
+ */
+extern bool
+adc_capture_start(uint16_t *buf, uint32_t len, adc_half_callback_fn cb)
+{
+    DMA_Stream_TypeDef cfg;
+
+    if (dma_claim(ADC_DMA, ADC_DMA_CHAN, adc_dma_event, NULL) != dma_ok) {
+        return false;
+    }
+    adc_half_cb = cb;
+
+    cfg.PAR = (uint32_t) &ADC1->DR;
+    cfg.M0AR = (uint32_t) buf;
+    cfg.M1AR = 0;
+    cfg.NDTR = len;
+    cfg.FCR = 0;
+    cfg.CR = (2u << DMA_CR_PL_Pos)
+        | (1u << DMA_CR_MSIZE_Pos)
+        | (1u << DMA_CR_PSIZE_Pos)
+        | (1u << DMA_CR_MINC_Pos)
+        | (1u << DMA_CR_CIRC_Pos)
+        | (1u << DMA_CR_TCIE_Pos)
+        | (1u << DMA_CR_HTIE_Pos)
+        | (1u << DMA_CR_TEIE_Pos);
+    dma_configure(ADC_DMA, &cfg);
+    dma_start(ADC_DMA);
+
+    adc_configure_sample_time(ADC_CHAN, ADC_SAMPLE_3_CYCLES);
+    ADC1->CR2 = ADC_CR2_ADON | ADC_CR2_CONT | ADC_CR2_DMA | ADC_CR2_DDS;
+    ADC1->CR2 |= ADC_CR2_SWSTART;
+
+    return true;
+}
+
+/*
+ * Stop a capture and go back to single conversions.
+ */
+extern void
+adc_capture_stop(void)
+{
+    ADC1->CR2 &= ~(ADC_CR2_CONT | ADC_CR2_DMA | ADC_CR2_DDS);
+    dma_release(ADC_DMA);
+
+    adc_configure_sample_time(ADC_CHAN, ADC_SAMPLE_144_CYCLES);
+    ADC1->CR2 = ADC_CR2_ADON | ADC_CR2_EOCS;
+}
+
+/*
+ * Samples written so far in the current lap of the capture buffer.
+ */
+extern uint32_t
+adc_capture_pos(uint32_t len)
+{
+    return len - dma_stream(ADC_DMA)->NDTR;
+}
+
+/*
+ * DMA interrupt: a half of the capture buffer has filled.
+ */
+static void
+adc_dma_event(uint32_t flags, void *arg)
+{
+    if ((flags & DMA_FLAG_HT) && adc_half_cb) {
+        adc_half_cb(0);
+    }
+    if ((flags & DMA_FLAG_TC) && adc_half_cb) {
+        adc_half_cb(1);
+    }
+}
+
 /*
  * Configure the sample time for a channel.
  */
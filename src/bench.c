@@ -0,0 +1,317 @@
+/*******************************************************************************
+ * @file    bench.c
+ * @author  Joe Todd
+ * @version
+ * @date    October 2026
+ * @brief   Autogrow
+ *          Cycle counts for the hot paths, built as its own image by
+ *          'make bench'.
+ *
+ * Each case runs BENCH_RUNS times with interrupts masked, timing every
+ * run on its own, and the cost of the empty call is taken off. The
+ * results go out as CSV after a '#' line naming the counter:
+ *
+ *      # autogrow bench, counter dwt, overhead 9
+ *      name,runs,min,mean,max
+ *      gpio_toggle,1000,4,4,6
+ *      ...
+ *      # end
+ *
+ * on USART1, or on the semihosting console when built with SEMIHOST=1 or
+ * QEMU=1. The counter is the DWT cycle counter where it runs; QEMU has no
+ * DWT, so there it is SysTick on the core clock, 24 bits wide, which is
+ * plenty for one run. QEMU's SysTick follows host time unless it runs
+ * with -icount, as 'make bench-qemu' does, and then it counts
+ * instructions rather than cycles. The ADC case is left out, with a
+ * comment line, if a conversion never finishes.
+ ******************************************************************************/
+
+
+/* Includes -------------------------------------------------------------------*/
+#include "rcc.h"
+#include "iox.h"
+#include "adc.h"
+#include "stepper.h"
+#include "uart.h"
+#include "dma.h"
+#include "semi.h"
+#include "telem.h"
+#include "stm32f4xx_it.h"
+
+#define BENCH_RUNS      1000u
+#define BENCH_BAUD      9600u
+#define BENCH_LINE      80u
+#define BENCH_ADC_WAIT  100000u     /* polls before giving up on the ADC */
+#define BENCH_LED_PORT  iox_port_d
+#define BENCH_LED_PIN   PIN12
+
+typedef struct {
+    char const *name;
+    void (*run)(void);
+} bench_case_t;
+
+static void bench_call(void);
+static void bench_gpio_toggle(void);
+static void bench_iox_configure_pin(void);
+static void bench_stepper_step(void);
+static void bench_adc(void);
+static void bench_telem_encode(void);
+
+static bench_case_t const cases[] = {
+    {"gpio_toggle",         bench_gpio_toggle},
+    {"iox_configure_pin",   bench_iox_configure_pin},
+    {"stepper_step",        bench_stepper_step},
+    {"adc_get_measurement", bench_adc},
+    {"telem_encode",        bench_telem_encode},
+};
+
+#define BENCH_CASES     (sizeof(cases) / sizeof(cases[0]))
+
+static bool dwt;
+static uint32_t mask;
+static uint32_t overhead;
+static uint32_t step;
+static uint8_t frame[TELEM_MAX_FRAME];
+static char line[BENCH_LINE];
+static uint32_t len;
+
+static void counter_init(void);
+static uint32_t counter(void);
+static void measure(void (*run)(void), uint32_t *min, uint32_t *mean,
+                    uint32_t *max);
+static bool adc_ready(void);
+static void put(char const *s);
+static void putu(uint32_t v);
+static void emit(void);
+
+/* Main -----------------------------------------------------------------------*/
+int main(void)
+{
+    uint32_t min;
+    uint32_t mean;
+    uint32_t max;
+    uint32_t i;
+
+#ifndef QEMU
+    clk_init();     /* QEMU has no RCC model, so the oscillator never comes up */
+#endif
+    it_init();
+    dma_init();
+    iox_led_init();
+    stepper_init();
+    adc_init();
+    telem_init();
+#ifndef SEMIHOST
+    uart_init(BENCH_BAUD);
+#endif
+    counter_init();
+
+    measure(bench_call, &min, &mean, &max);
+    overhead = min;
+
+    put("# autogrow bench, counter ");
+    put(dwt ? "dwt" : "systick");
+    put(", overhead ");
+    putu(overhead);
+    emit();
+    put("name,runs,min,mean,max");
+    emit();
+
+    for (i = 0; i < BENCH_CASES; i++) {
+        if (cases[i].run == bench_adc && !adc_ready()) {
+            put("# ");
+            put(cases[i].name);
+            put(" skipped, no conversion");
+            emit();
+            continue;
+        }
+        measure(cases[i].run, &min, &mean, &max);
+        put(cases[i].name);
+        put(",");
+        putu(BENCH_RUNS);
+        put(",");
+        putu(min);
+        put(",");
+        putu(mean);
+        put(",");
+        putu(max);
+        emit();
+    }
+
+    put("# end");
+    emit();
+
+#ifdef SEMIHOST
+    semi_exit(true);
+#endif
+    for (;;) {
+        __WFI();
+    }
+}
+
+static void
+bench_call(void)
+{
+}
+
+static void
+bench_gpio_toggle(void)
+{
+    iox_set_pin_state(BENCH_LED_PORT, BENCH_LED_PIN,
+                      (iox_gpios[BENCH_LED_PORT]->ODR &
+                       (1u << BENCH_LED_PIN)) == 0);
+}
+
+static void
+bench_iox_configure_pin(void)
+{
+    iox_configure_pin(BENCH_LED_PORT, BENCH_LED_PIN, iox_mode_out,
+                      iox_type_pp, iox_speed_low, iox_pupd_none);
+}
+
+static void
+bench_stepper_step(void)
+{
+    stepper_step(step++);
+}
+
+static void
+bench_adc(void)
+{
+    (void) adc_get_measurement();
+}
+
+/*
+ * A sample record, as telem_send_sample() builds it, short of queueing
+ * it: with interrupts masked the frames would never come back.
+ */
+static void
+bench_telem_encode(void)
+{
+    uint32_t payload = 0x08000000u;     /* zone 0, reading 2048 */
+
+    (void) telem_encode(frame, telem_sample, step++, &payload,
+                        sizeof(payload));
+}
+
+/*
+ * DWT if it counts, else SysTick counting down from 2^24 on the core
+ * clock; counter() turns the latter round so both count up.
+ */
+static void
+counter_init(void)
+{
+    uint32_t start;
+    uint32_t volatile i;
+
+    utl_cycles_init();
+    start = utl_cycles();
+    for (i = 0; i < 16u; i++) {
+    }
+    dwt = utl_cycles() != start;
+    mask = 0xFFFFFFFFu;
+
+    if (!dwt) {
+        SysTick->LOAD = SysTick_LOAD_RELOAD_Msk;
+        SysTick->VAL = 0;
+        SysTick->CTRL = SysTick_CTRL_CLKSOURCE_Msk | SysTick_CTRL_ENABLE_Msk;
+        mask = SysTick_LOAD_RELOAD_Msk;
+    }
+}
+
+static uint32_t
+counter(void)
+{
+    return dwt ? utl_cycles() : 0u - SysTick->VAL;
+}
+
+/*
+ * Time each of BENCH_RUNS runs, less the overhead, with interrupts off.
+ */
+static void
+measure(void (*run)(void), uint32_t *min, uint32_t *mean, uint32_t *max)
+{
+    uint64_t sum = 0;
+    uint32_t primask = __get_PRIMASK();
+    uint32_t start;
+    uint32_t t;
+    uint32_t i;
+
+    *min = 0xFFFFFFFFu;
+    *max = 0;
+
+    __disable_irq();
+    for (i = 0; i < BENCH_RUNS; i++) {
+        start = counter();
+        run();
+        t = (counter() - start) & mask;
+        t = (t > overhead) ? t - overhead : 0;
+        sum += t;
+        *min = (t < *min) ? t : *min;
+        *max = (t > *max) ? t : *max;
+    }
+    __set_PRIMASK(primask);
+
+    *mean = (uint32_t) ((sum + BENCH_RUNS / 2u) / BENCH_RUNS);
+}
+
+/*
+ * One conversion with a bounded wait, so that a missing ADC shows up as
+ * a skipped case rather than a hang in adc_get_measurement().
+ */
+static bool
+adc_ready(void)
+{
+    uint32_t i;
+
+    ADC1->CR2 |= ADC_CR2_SWSTART;
+    for (i = 0; i < BENCH_ADC_WAIT; i++) {
+        if (ADC1->SR & ADC_SR_EOC) {
+            (void) ADC1->DR;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static void
+put(char const *s)
+{
+    while (*s != '\0' && len < BENCH_LINE - 2u) {
+        line[len++] = *s++;
+    }
+}
+
+static void
+putu(uint32_t v)
+{
+    char buf[11];
+    char *p = &buf[sizeof(buf) - 1u];
+
+    *p = '\0';
+    do {
+        *--p = (char) ('0' + v % 10u);
+        v /= 10u;
+    } while (v != 0);
+    put(p);
+}
+
+/*
+ * Send the line and start the next. The UART sends from the buffer in
+ * place, so wait for it before reuse.
+ */
+static void
+emit(void)
+{
+    line[len++] = '\n';
+    line[len] = '\0';
+#ifdef SEMIHOST
+    semi_puts(line);
+#else
+    uart_send_data((unsigned char *) line, len);
+    while (!uart_tx_idle()) {
+    }
+#endif
+    len = 0;
+}
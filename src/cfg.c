@@ -0,0 +1,182 @@
+/**
+ ******************************************************************************
+ * @file    cfg.c
+ * @author  Joe Todd
+ * @version
+ * @date    October 2026
+ * @brief   Autogrow
+ *          Double-buffered configuration record in internal flash.
+ *
+ * Loading reads the two headers, picks the newer by sequence number and
+ * checks that one record's CRC, so boot costs a few dozen words of flash
+ * reads. Nothing is erased or written unless asked to save.
+ ******************************************************************************/
+#include "cfg.h"
+#include "string.h"
+
+#define CFG_MAGIC           0x47464343u     /* "CCFG" */
+#define CFG_HDR_WORDS       4u
+#define CFG_SECTORS         2u
+
+typedef struct {
+    uint32_t magic;
+    uint32_t crc;
+    uint32_t seq;
+    uint16_t version;
+    uint16_t size;
+    uint32_t payload[];
+} cfg_rec_t;
+
+typedef struct {
+    uint32_t addr;
+    uint16_t sector;        /* FLASH_Sector_x */
+} cfg_sector_t;
+
+static cfg_sector_t const sectors[CFG_SECTORS] = {
+    {0x08004000u, FLASH_Sector_1},
+    {0x08008000u, FLASH_Sector_2},
+};
+
+static bool cfg_crc_ok(cfg_rec_t const *r);
+static cfg_rec_t const *cfg_rec(uint32_t s);
+static int32_t cfg_newest(void);
+static int32_t cfg_current(void);
+
+extern cfg_rc_t
+cfg_load(void *data, uint32_t size, uint16_t *version, uint32_t *len)
+{
+    cfg_rec_t const *r;
+    int32_t s;
+
+    crc_init();
+
+    s = cfg_current();
+    if (s < 0) {
+        return cfg_empty;
+    }
+    r = cfg_rec((uint32_t) s);
+
+    *version = r->version;
+    *len = r->size;
+    memcpy(data, r->payload, (r->size < size) ? r->size : size);
+
+    return cfg_ok;
+}
+
+extern cfg_rc_t
+cfg_save(void const *data, uint32_t size, uint16_t version)
+{
+    uint32_t buf[CFG_HDR_WORDS + CFG_MAX_SIZE / 4u];
+    cfg_rec_t *r = (cfg_rec_t *) buf;
+    uint32_t words;
+    uint32_t s;
+    int32_t newest;
+    int32_t good;
+    uint32_t i;
+    cfg_rc_t rc = cfg_ok;
+
+    if (size > CFG_MAX_SIZE) {
+        return cfg_error;
+    }
+    crc_init();
+
+    /*
+     * Build the record in RAM, then write it over whichever sector does
+     * not hold the good copy, numbered above anything already there.
+     */
+    good = cfg_current();
+    s = (good < 0) ? 0 : (uint32_t) good ^ 1u;
+    newest = cfg_newest();
+    r->seq = (newest < 0) ? 1u : cfg_rec((uint32_t) newest)->seq + 1u;
+    r->magic = CFG_MAGIC;
+    r->version = version;
+    r->size = (uint16_t) size;
+    words = (size + 3u) / 4u;
+    if (words != 0) {
+        r->payload[words - 1u] = 0;
+    }
+    memcpy(r->payload, data, size);
+    r->crc = crc_block(&buf[2], 2u + words);
+
+    FLASH_Unlock();
+    FLASH_ClearFlag(FLASH_FLAG_EOP | FLASH_FLAG_OPERR | FLASH_FLAG_WRPERR |
+                    FLASH_FLAG_PGAERR | FLASH_FLAG_PGPERR | FLASH_FLAG_PGSERR);
+
+    if (FLASH_EraseSector(sectors[s].sector, VoltageRange_3) != FLASH_COMPLETE) {
+        rc = cfg_error;
+    }
+    for (i = 1; i < CFG_HDR_WORDS + words && rc == cfg_ok; i++) {
+        if (FLASH_ProgramWord(sectors[s].addr + 4u * i, buf[i]) !=
+            FLASH_COMPLETE) {
+            rc = cfg_error;
+        }
+    }
+    if (rc == cfg_ok &&
+        FLASH_ProgramWord(sectors[s].addr, buf[0]) != FLASH_COMPLETE) {
+        rc = cfg_error;
+    }
+
+    FLASH_Lock();
+
+    if (rc == cfg_ok && !cfg_crc_ok(cfg_rec(s))) {
+        rc = cfg_error;
+    }
+
+    return rc;
+}
+
+static cfg_rec_t const *
+cfg_rec(uint32_t s)
+{
+    return (cfg_rec_t const *) sectors[s].addr;
+}
+
+static bool
+cfg_crc_ok(cfg_rec_t const *r)
+{
+    return r->crc == crc_block(&r->seq, 2u + (r->size + 3u) / 4u);
+}
+
+/*
+ * Sector holding the newer record by header alone, -1 if neither has one.
+ */
+static int32_t
+cfg_newest(void)
+{
+    cfg_rec_t const *a = cfg_rec(0);
+    cfg_rec_t const *b = cfg_rec(1);
+    bool va = a->magic == CFG_MAGIC && a->size <= CFG_MAX_SIZE;
+    bool vb = b->magic == CFG_MAGIC && b->size <= CFG_MAX_SIZE;
+
+    if (va && vb) {
+        return ((int32_t) (b->seq - a->seq) > 0) ? 1 : 0;
+    }
+    if (va) {
+        return 0;
+    }
+
+    return vb ? 1 : -1;
+}
+
+/*
+ * Sector holding the record to use, -1 if there is none. Only the newer
+ * record's CRC is checked unless it turns out to be damaged.
+ */
+static int32_t
+cfg_current(void)
+{
+    int32_t s = cfg_newest();
+    cfg_rec_t const *r;
+
+    if (s < 0 || cfg_crc_ok(cfg_rec((uint32_t) s))) {
+        return s;
+    }
+
+    s ^= 1;
+    r = cfg_rec((uint32_t) s);
+    if (r->magic == CFG_MAGIC && r->size <= CFG_MAX_SIZE && cfg_crc_ok(r)) {
+        return s;
+    }
+
+    return -1;
+}
@@ -0,0 +1,24 @@
+/**
+ ******************************************************************************
+ * @file    crc.c
+ * @author  Joe Todd
+ * @version
+ * @date    October 2026
+ * @brief   Autogrow
+ *          Block CRC on the hardware CRC unit.
+ *
+ ******************************************************************************/
+#include "crc.h"
+
+extern void
+crc_init(void)
+{
+    RCC->AHB1ENR |= RCC_AHB1ENR_CRCEN;
+}
+
+extern uint32_t
+crc_block(uint32_t const *buf, uint32_t words)
+{
+    CRC_ResetDR();
+    return CRC_CalcBlockCRC((uint32_t *) buf, words);
+}
@@ -0,0 +1,93 @@
+/**
+ ******************************************************************************
+ * @file    ctl.c
+ * @author  Joe Todd
+ * @version
+ * @date    October 2026
+ * @brief   Autogrow
+ *          Fixed-point PID watering controller.
+ *
+ ******************************************************************************/
+#include "ctl.h"
+
+#define CTL_ERROR_SHIFT     3u      /* 12-bit ADC to Q15 */
+
+static q15_t ctl_sat(int32_t x);
+
+extern void
+ctl_init(ctl_t *ctl, uint16_t kp, uint16_t ki, uint16_t kd)
+{
+    ctl->pid.state[0] = 0;
+    ctl->pid.state[1] = 0;
+    ctl->pid.state[2] = 0;
+    ctl->seed = false;
+    ctl_gains(ctl, kp, ki, kd);
+}
+
+/*
+ * A0 = Kp + Ki + Kd, and A1 packs -(Kp + 2Kd) in the low half with Kd in
+ * the high half for the dual multiply, as arm_pid_init_q15() would.
+ */
+extern void
+ctl_gains(ctl_t *ctl, uint16_t kp, uint16_t ki, uint16_t kd)
+{
+    arm_pid_instance_q15 *s = &ctl->pid;
+
+    s->Kp = ctl_sat(kp);
+    s->Ki = ctl_sat(ki);
+    s->Kd = ctl_sat(kd);
+    s->A0 = ctl_sat((int32_t) s->Kp + s->Ki + s->Kd);
+    s->A1 = (q31_t) (((uint32_t) (uint16_t) s->Kd << 16) |
+                     (uint16_t) ctl_sat(-((int32_t) s->Kp + 2 * s->Kd)));
+}
+
+extern void
+ctl_resume(ctl_t *ctl, uint16_t demand)
+{
+    ctl->pid.state[2] = ctl_sat(demand);
+    ctl->seed = true;
+}
+
+extern uint32_t
+ctl_update(ctl_t *ctl, uint16_t level, uint16_t setpoint, uint32_t max)
+{
+    q15_t error;
+    q15_t out;
+
+    error = ctl_sat(((int32_t) level - setpoint) << CTL_ERROR_SHIFT);
+    if (ctl->seed) {
+        ctl->pid.state[0] = error;
+        ctl->pid.state[1] = error;
+        ctl->seed = false;
+    }
+    out = arm_pid_q15(&ctl->pid, error);
+
+    /*
+     * The valve cannot run backwards or for more than 'max', so hold the
+     * fed-back output to what was actually delivered.
+     */
+    if (out < 0) {
+        out = 0;
+    }
+    ctl->pid.state[2] = out;
+
+    return ((uint32_t) out * max + 0x4000u) >> 15;
+}
+
+extern uint16_t
+ctl_demand(ctl_t const *ctl)
+{
+    return (uint16_t) ctl->pid.state[2];
+}
+
+static q15_t
+ctl_sat(int32_t x)
+{
+    if (x > 0x7FFF) {
+        return 0x7FFF;
+    }
+    if (x < -0x8000) {
+        return -0x8000;
+    }
+    return (q15_t) x;
+}
@@ -1,8 +1,37 @@
+/**
+ ******************************************************************************
+ * @file    dma.c
+ * @author  Joe Todd
+ * @version
+ * @date    October 2026
+ * @brief   Autogrow
+ *          Stream allocator and interrupt dispatch for DMA1 and DMA2.
+ *
+ * Each controller reports Streams 0-3 in LISR and 4-7 in HISR, six bits
+ * apart with a gap in the middle; flags are shifted down to the Stream 0
+ * positions so callers see the same bits whichever stream they have.
+ *
+ * Memory to memory transfers run through the FIFO (direct mode is not
+ * allowed for them) with the source on the peripheral port. NDTR counts
+ * source items and stops at 65535, so long transfers are carried on in
+ * chunks from the transfer complete interrupt.
+ ******************************************************************************/
 #include "dma.h"
+#include "string.h"
 
+#define DMA_NO_CHAN         0xFFu
+#define DMA_MAX_ITEMS       0xFFFFu
 
-static DMA_Stream_TypeDef *const 
- dma1_streams[] = {
+typedef struct {
+    dma_callback_fn cb;
+    void *arg;
+    uint8_t chan;           /* DMA_NO_CHAN when free */
+    dma_stats_t stats;
+} dma_owner_t;
+
+static DMA_Stream_TypeDef *const
+ dma_streams[DMA_STREAMS] = {
+    DMA1_Stream0,
     DMA1_Stream1,
     DMA1_Stream2,
     DMA1_Stream3,
@@ -10,27 +39,438 @@ static DMA_Stream_TypeDef *const
     DMA1_Stream5,
     DMA1_Stream6,
     DMA1_Stream7,
+    DMA2_Stream0,
+    DMA2_Stream1,
+    DMA2_Stream2,
+    DMA2_Stream3,
+    DMA2_Stream4,
+    DMA2_Stream5,
+    DMA2_Stream6,
+    DMA2_Stream7,
+};
+
+static IRQn_Type const dma_irqs[DMA_STREAMS] = {
+    DMA1_Stream0_IRQn,
+    DMA1_Stream1_IRQn,
+    DMA1_Stream2_IRQn,
+    DMA1_Stream3_IRQn,
+    DMA1_Stream4_IRQn,
+    DMA1_Stream5_IRQn,
+    DMA1_Stream6_IRQn,
+    DMA1_Stream7_IRQn,
+    DMA2_Stream0_IRQn,
+    DMA2_Stream1_IRQn,
+    DMA2_Stream2_IRQn,
+    DMA2_Stream3_IRQn,
+    DMA2_Stream4_IRQn,
+    DMA2_Stream5_IRQn,
+    DMA2_Stream6_IRQn,
+    DMA2_Stream7_IRQn,
+};
+
+static uint8_t const dma_shift[4] = {0, 6, 16, 22};
+
+/*
+ * Peripheral requests that can be served from either of two streams on
+ * the same channel (RM0368 tables 27 and 28). Claiming one of them while
+ * the other is claimed would arm two streams on one request.
+ */
+typedef struct {
+    uint8_t a;
+    uint8_t b;
+    uint8_t chan;
+} dma_request_t;
+
+static dma_request_t const dma_requests[] = {
+    {DMA_STREAM(1, 0), DMA_STREAM(1, 2), 0},    /* SPI3_RX */
+    {DMA_STREAM(1, 5), DMA_STREAM(1, 7), 0},    /* SPI3_TX */
+    {DMA_STREAM(1, 0), DMA_STREAM(1, 5), 1},    /* I2C1_RX */
+    {DMA_STREAM(1, 6), DMA_STREAM(1, 7), 1},    /* I2C1_TX */
+    {DMA_STREAM(1, 2), DMA_STREAM(1, 3), 7},    /* I2C2_RX */
+    {DMA_STREAM(2, 0), DMA_STREAM(2, 4), 0},    /* ADC1 */
+    {DMA_STREAM(2, 0), DMA_STREAM(2, 2), 3},    /* SPI1_RX */
+    {DMA_STREAM(2, 3), DMA_STREAM(2, 5), 3},    /* SPI1_TX */
+    {DMA_STREAM(2, 2), DMA_STREAM(2, 5), 4},    /* USART1_RX */
+    {DMA_STREAM(2, 3), DMA_STREAM(2, 6), 4},    /* SDIO */
+    {DMA_STREAM(2, 1), DMA_STREAM(2, 2), 5},    /* USART6_RX */
+    {DMA_STREAM(2, 6), DMA_STREAM(2, 7), 5},    /* USART6_TX */
 };
 
+#define DMA_REQUESTS    (sizeof(dma_requests) / sizeof(dma_requests[0]))
+
+typedef struct {
+    uint32_t dst;
+    uint32_t src;
+    uint32_t items;         /* still to go, in 1 << shift byte units */
+    uint32_t shift;
+    uint32_t cr;
+    dma_mem_done_fn done;
+    void *arg;
+    volatile bool busy;
+} dma_mem_t;
+
+static dma_owner_t owners[DMA_STREAMS];
+static uint32_t conflicts;
+
+static dma_mem_t mem;
+static uint32_t mem_fill;
+static uint32_t mem_crossover = DMA_MEM_CROSSOVER;
+
+static bool dma_request_taken(uint32_t id, uint32_t chan);
+static dma_rc_t dma_mem_start(void *dst, void const *src, uint32_t len,
+                              bool fill, dma_mem_done_fn done, void *arg);
+static void dma_mem_next(void);
+static void dma_mem_event(uint32_t flags, void *arg);
+
 extern void
 dma_init(void)
 {
-    RCC->AHB1ENR |= RCC_AHB1ENR_DMA1EN;
+    uint32_t i;
+
+    RCC->AHB1ENR |= RCC_AHB1ENR_DMA1EN | RCC_AHB1ENR_DMA2EN;
+
+    for (i = 0; i < DMA_STREAMS; i++) {
+        owners[i].chan = DMA_NO_CHAN;
+    }
+}
+
+extern dma_rc_t
+dma_claim(uint32_t id, uint32_t chan, dma_callback_fn cb, void *arg)
+{
+    dma_owner_t *o;
+    uint32_t primask;
+
+    if (id >= DMA_STREAMS || chan > 7u) {
+        return dma_invalid;
+    }
+    o = &owners[id];
+
+    primask = __get_PRIMASK();
+    __disable_irq();
+    if (o->chan != DMA_NO_CHAN || dma_request_taken(id, chan)) {
+        conflicts++;
+        __set_PRIMASK(primask);
+        return dma_conflict;
+    }
+    o->chan = (uint8_t) chan;
+    __set_PRIMASK(primask);
+
+    dma_stop(id);
+    (void) dma_ack(id);
+
+    o->cb = cb;
+    o->arg = arg;
+    memset(&o->stats, 0, sizeof(o->stats));
+    if (cb != NULL) {
+        utl_enable_irq(dma_irqs[id]);
+    }
+
+    return dma_ok;
 }
 
 extern void
-dma_init_dma1_chx(uint32_t str, DMA_Stream_TypeDef const *cfg)
+dma_release(uint32_t id)
+{
+    if (id >= DMA_STREAMS || owners[id].chan == DMA_NO_CHAN) {
+        return;
+    }
+
+    dma_stop(id);
+    utl_disable_irq(dma_irqs[id]);
+    (void) dma_ack(id);
+    owners[id].cb = NULL;
+    owners[id].chan = DMA_NO_CHAN;
+}
+
+extern DMA_Stream_TypeDef *
+dma_stream(uint32_t id)
 {
-    DMA_Stream_TypeDef *rstr;
+    return dma_streams[id];
+}
 
-    rstr = dma1_streams[str - 1];
+extern void
+dma_configure(uint32_t id, DMA_Stream_TypeDef const *cfg)
+{
+    DMA_Stream_TypeDef *rstr = dma_streams[id];
 
-    /**
-     * The channel must be disabled before we can write the CNDTR register
+    /*
+     * The stream must be disabled before we can write the NDTR register
      */
-    rstr->CR = 0;
-    rstr->M0AR = cfg->M0AR;
+    dma_stop(id);
+    (void) dma_ack(id);
+
     rstr->PAR = cfg->PAR;
+    rstr->M0AR = cfg->M0AR;
+    rstr->M1AR = cfg->M1AR;
     rstr->NDTR = cfg->NDTR;
-    rstr->CR = cfg->CR;
-}
\ No newline at end of file
+    rstr->FCR = cfg->FCR;
+    rstr->CR = (cfg->CR & ~(DMA_SxCR_CHSEL | DMA_SxCR_EN))
+        | ((uint32_t) owners[id].chan << DMA_CR_CHSEL_Pos);
+}
+
+extern void
+dma_start(uint32_t id)
+{
+    dma_streams[id]->CR |= (1u << DMA_CR_EN_Pos);
+}
+
+extern void
+dma_stop(uint32_t id)
+{
+    DMA_Stream_TypeDef *rstr = dma_streams[id];
+
+    rstr->CR &= ~DMA_SxCR_EN;
+    while ((rstr->CR & DMA_SxCR_EN) != 0);
+}
+
+extern uint32_t
+dma_ack(uint32_t id)
+{
+    DMA_TypeDef *dma = (id < 8u) ? DMA1 : DMA2;
+    uint32_t shift = dma_shift[id & 3u];
+    dma_stats_t *st = &owners[id].stats;
+    uint32_t flags;
+
+    if ((id & 4u) == 0) {
+        flags = (dma->LISR >> shift) & DMA_FLAG_ALL;
+        dma->LIFCR = flags << shift;
+    }
+    else {
+        flags = (dma->HISR >> shift) & DMA_FLAG_ALL;
+        dma->HIFCR = flags << shift;
+    }
+
+    /*
+     * In direct mode the FIFO error flag can be set harmlessly, so it only
+     * counts if its interrupt is enabled.
+     */
+    if ((dma_streams[id]->FCR & DMA_SxFCR_FEIE) == 0) {
+        flags &= ~DMA_FLAG_FE;
+    }
+
+    if (flags & DMA_FLAG_TC) {
+        st->transfers++;
+    }
+    if (flags & DMA_FLAG_HT) {
+        st->halves++;
+    }
+    if (flags & DMA_FLAG_ERRORS) {
+        st->errors++;
+    }
+
+    return flags;
+}
+
+extern void
+dma_get_stats(uint32_t id, dma_stats_t *stats)
+{
+    *stats = owners[id].stats;
+}
+
+extern uint32_t
+dma_conflicts(void)
+{
+    return conflicts;
+}
+
+extern dma_rc_t
+dma_mem_init(void)
+{
+    mem.busy = false;
+
+    return dma_claim(DMA_MEM_STREAM, 0, dma_mem_event, NULL);
+}
+
+extern dma_rc_t
+dma_memcpy(void *dst, void const *src, uint32_t len,
+           dma_mem_done_fn done, void *arg)
+{
+    if (len < mem_crossover || len == 0) {
+        if (mem.busy) {
+            return dma_busy;
+        }
+        memcpy(dst, src, len);
+        if (done != NULL) {
+            done(true, arg);
+        }
+        return dma_ok;
+    }
+
+    return dma_mem_start(dst, src, len, false, done, arg);
+}
+
+extern dma_rc_t
+dma_memset(void *dst, uint8_t value, uint32_t len,
+           dma_mem_done_fn done, void *arg)
+{
+    if (mem.busy) {
+        return dma_busy;
+    }
+    if (len < mem_crossover || len == 0) {
+        memset(dst, value, len);
+        if (done != NULL) {
+            done(true, arg);
+        }
+        return dma_ok;
+    }
+
+    mem_fill = value * 0x01010101u;
+
+    return dma_mem_start(dst, &mem_fill, len, true, done, arg);
+}
+
+extern bool
+dma_mem_busy(void)
+{
+    return mem.busy;
+}
+
+extern uint32_t
+dma_mem_crossover(uint32_t len)
+{
+    uint32_t old = mem_crossover;
+
+    mem_crossover = len;
+
+    return old;
+}
+
+/*
+ * Pick the widest transfer the alignment allows and start the first chunk.
+ * A fill reads the same word over and over, so its source never moves.
+ * 'len' is never 0 here: NDTR=0 would never complete, so the callers do
+ * an empty transfer on the CPU whatever the crossover.
+ */
+static dma_rc_t
+dma_mem_start(void *dst, void const *src, uint32_t len, bool fill,
+              dma_mem_done_fn done, void *arg)
+{
+    uint32_t align = (uint32_t) dst | len | (fill ? 0 : (uint32_t) src);
+
+    if (mem.busy) {
+        return dma_busy;
+    }
+    if (owners[DMA_MEM_STREAM].cb != dma_mem_event) {
+        return dma_invalid;
+    }
+
+    mem.busy = true;
+    mem.dst = (uint32_t) dst;
+    mem.src = (uint32_t) src;
+    mem.done = done;
+    mem.arg = arg;
+
+    mem.cr = (2u << DMA_CR_DIR_Pos)
+        | (1u << DMA_CR_PL_Pos)
+        | (1u << DMA_CR_MINC_Pos)
+        | ((fill ? 0u : 1u) << DMA_CR_PINC_Pos)
+        | (1u << DMA_CR_TCIE_Pos)
+        | (1u << DMA_CR_TEIE_Pos);
+    if ((align & 3u) == 0) {
+        mem.shift = 2;
+        mem.cr |= (2u << DMA_CR_MSIZE_Pos) | (2u << DMA_CR_PSIZE_Pos);
+        if ((align & 15u) == 0) {
+            /*
+             * 16 byte alignment keeps each burst inside a 1KB boundary.
+             */
+            mem.cr |= (1u << DMA_CR_MBURST_Pos);
+            if (!fill) {
+                mem.cr |= (1u << DMA_CR_PBURST_Pos);
+            }
+        }
+    }
+    else {
+        mem.shift = 0;
+    }
+    mem.items = len >> mem.shift;
+
+    dma_mem_next();
+
+    return dma_ok;
+}
+
+/*
+ * Whether the request on ('id', 'chan') is already claimed on its other
+ * stream. Called with interrupts off.
+ */
+static bool
+dma_request_taken(uint32_t id, uint32_t chan)
+{
+    dma_request_t const *r;
+    uint32_t other;
+    uint32_t i;
+
+    for (i = 0; i < DMA_REQUESTS; i++) {
+        r = &dma_requests[i];
+        if (r->chan != chan || (r->a != id && r->b != id)) {
+            continue;
+        }
+        other = (r->a == id) ? r->b : r->a;
+        if (owners[other].chan == chan) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static void
+dma_mem_next(void)
+{
+    DMA_Stream_TypeDef cfg;
+    uint32_t items = (mem.items > DMA_MAX_ITEMS) ? DMA_MAX_ITEMS : mem.items;
+
+    cfg.PAR = mem.src;
+    cfg.M0AR = mem.dst;
+    cfg.M1AR = 0;
+    cfg.NDTR = items;
+    cfg.FCR = DMA_SxFCR_DMDIS | DMA_SxFCR_FTH;
+    cfg.CR = mem.cr;
+    dma_configure(DMA_MEM_STREAM, &cfg);
+
+    mem.items -= items;
+    mem.dst += items << mem.shift;
+    if (mem.cr & (1u << DMA_CR_PINC_Pos)) {
+        mem.src += items << mem.shift;
+    }
+
+    dma_start(DMA_MEM_STREAM);
+}
+
+/*
+ * DMA interrupt: carry on with the next chunk, or report back.
+ */
+static void
+dma_mem_event(uint32_t flags, void *arg)
+{
+    bool ok = (flags & DMA_FLAG_ERRORS) == 0;
+
+    if ((flags & (DMA_FLAG_TC | DMA_FLAG_ERRORS)) == 0) {
+        return;
+    }
+    if (ok && mem.items != 0) {
+        dma_mem_next();
+        return;
+    }
+
+    mem.busy = false;
+    if (mem.done != NULL) {
+        mem.done(ok, mem.arg);
+    }
+}
+
+/*
+ * Hand the flags to the owner. A flag a polling driver has already taken
+ * leaves nothing to do.
+ */
+extern void
+dma_irq(uint32_t id)
+{
+    dma_owner_t *o = &owners[id];
+    uint32_t flags;
+
+    flags = dma_ack(id);
+    if (flags != 0 && o->cb != NULL) {
+        o->cb(flags, o->arg);
+    }
+}
@@ -0,0 +1,92 @@
+/**
+ ******************************************************************************
+ * @file    evt.c
+ * @author  Joe Todd
+ * @version
+ * @date    October 2026
+ * @brief   Autogrow
+ *          Run-to-completion event loop.
+ *
+ ******************************************************************************/
+#include "evt.h"
+#include "string.h"
+
+static volatile uint32_t pending;
+static evt_handler_fn handlers[EVT_NUM];
+static evt_stats_t stats[EVT_NUM];
+
+extern void
+evt_init(void)
+{
+    pending = 0;
+    memset(handlers, 0, sizeof(handlers));
+    memset(stats, 0, sizeof(stats));
+    utl_cycles_init();
+}
+
+extern void
+evt_register(evt_id_t id, evt_handler_fn fn)
+{
+    if (id < EVT_NUM) {
+        handlers[id] = fn;
+    }
+}
+
+extern void
+evt_post(evt_id_t id)
+{
+    uint32_t primask;
+
+    if (id >= EVT_NUM) {
+        return;
+    }
+
+    primask = __get_PRIMASK();
+    __disable_irq();
+    pending |= 1u << id;
+    stats[id].posts++;
+    __set_PRIMASK(primask);
+}
+
+extern void
+evt_run(void)
+{
+    uint32_t id;
+    uint32_t start;
+    uint32_t cycles;
+
+    while (1) {
+        /*
+         * Take the lowest pending bit. With interrupts masked an interrupt
+         * still wakes WFI, so a post that lands after the check cannot be
+         * slept through.
+         */
+        __disable_irq();
+        if (pending == 0) {
+            __WFI();
+            __enable_irq();
+            continue;
+        }
+        id = __CLZ(__RBIT(pending));
+        pending &= ~(1u << id);
+        __enable_irq();
+
+        if (handlers[id] != NULL) {
+            start = utl_cycles();
+            handlers[id]();
+            cycles = utl_cycles() - start;
+            stats[id].runs++;
+            if (cycles > stats[id].max_cycles) {
+                stats[id].max_cycles = cycles;
+            }
+        }
+    }
+}
+
+extern void
+evt_get_stats(evt_id_t id, evt_stats_t *s)
+{
+    if (id < EVT_NUM) {
+        *s = stats[id];
+    }
+}
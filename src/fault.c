@@ -0,0 +1,144 @@
+/**
+ ******************************************************************************
+ * @file    fault.c
+ * @author  Joe Todd
+ * @version
+ * @date    October 2026
+ * @brief   Autogrow
+ *          Fault capture and post-mortem record.
+ *
+ * The handlers share one naked entry, which finds the exception frame on
+ * whichever stack was in use and passes it to fault_capture(). That reads
+ * only RAM and core registers and never returns, so it works with the
+ * stack in any state short of overflowing into the record.
+ *
+ * The record is cleared once it has been taken, so the fault count lives
+ * beside it with its own magic and check, and outlives any reset that
+ * keeps RAM, watchdog and pin resets included, not just the next one.
+ ******************************************************************************/
+#include "fault.h"
+#include "string.h"
+
+#define FAULT_MAGIC         0x544c4146u     /* "FALT" */
+#define FAULT_COUNT_MAGIC   0x544e4346u     /* "FCNT" */
+#define FAULT_WORDS         (sizeof(fault_rec_t) / 4u)
+#define FAULT_RAM_START     0x20000000u
+#define FAULT_RAM_END       0x20010000u
+
+typedef struct {
+    uint32_t magic;
+    uint32_t count;
+    uint32_t check;         /* ~count */
+} fault_count_t;
+
+static fault_rec_t rec __attribute__((section(".noinit")));
+static fault_count_t tally __attribute__((section(".noinit")));
+static fault_rec_t last;
+static bool have_last;
+
+static uint32_t fault_check(fault_rec_t const *r);
+static void fault_capture(uint32_t const *frame, uint32_t exc_return)
+    __attribute__((used, noreturn));
+
+extern bool
+fault_init(void)
+{
+    have_last = rec.magic == FAULT_MAGIC && rec.check == fault_check(&rec);
+    if (have_last) {
+        last = rec;
+    }
+    memset(&rec, 0, sizeof(rec));
+
+    if (tally.magic != FAULT_COUNT_MAGIC || tally.check != ~tally.count) {
+        tally.count = 0;        /* power up, or RAM lost */
+        tally.check = ~0u;
+        tally.magic = FAULT_COUNT_MAGIC;
+    }
+
+    SCB->SHCSR |= SCB_SHCSR_MEMFAULTENA_Msk | SCB_SHCSR_BUSFAULTENA_Msk |
+                  SCB_SHCSR_USGFAULTENA_Msk;
+
+    return have_last;
+}
+
+extern fault_rec_t const *
+fault_last(void)
+{
+    return have_last ? &last : NULL;
+}
+
+/*
+ * EXC_RETURN bit 2 says which stack the frame went on.
+ */
+__attribute__((naked)) void
+HardFault_Handler(void)
+{
+    __ASM volatile (
+        "tst lr, #4         \n"
+        "ite eq             \n"
+        "mrseq r0, msp      \n"
+        "mrsne r0, psp      \n"
+        "mov r1, lr         \n"
+        "b fault_capture    \n");
+}
+
+void MemManage_Handler(void) __attribute__((alias("HardFault_Handler")));
+void BusFault_Handler(void) __attribute__((alias("HardFault_Handler")));
+void UsageFault_Handler(void) __attribute__((alias("HardFault_Handler")));
+
+static void
+fault_capture(uint32_t const *frame, uint32_t exc_return)
+{
+    uint32_t addr = (uint32_t) frame;
+    uint32_t i;
+
+    rec.type = SCB->ICSR & SCB_ICSR_VECTACTIVE_Msk;
+    rec.exc_return = exc_return;
+    rec.sp = addr;
+    rec.cfsr = SCB->CFSR;
+    rec.hfsr = SCB->HFSR;
+    rec.mmfar = SCB->MMFAR;
+    rec.bfar = SCB->BFAR;
+
+    /*
+     * A bad stack pointer may be the fault, so only follow it within RAM.
+     */
+    if (addr >= FAULT_RAM_START &&
+        addr <= FAULT_RAM_END - (8u + FAULT_STACK_WORDS) * 4u) {
+        rec.r0 = frame[0];
+        rec.r1 = frame[1];
+        rec.r2 = frame[2];
+        rec.r3 = frame[3];
+        rec.r12 = frame[4];
+        rec.lr = frame[5];
+        rec.pc = frame[6];
+        rec.psr = frame[7];
+        for (i = 0; i < FAULT_STACK_WORDS; i++) {
+            rec.stack[i] = frame[8u + i];
+        }
+    }
+
+    tally.count++;
+    tally.check = ~tally.count;
+    rec.count = tally.count;
+    rec.magic = FAULT_MAGIC;
+    rec.check = fault_check(&rec);
+
+    __DSB();
+    NVIC_SystemReset();
+    while (1);
+}
+
+static uint32_t
+fault_check(fault_rec_t const *r)
+{
+    uint32_t const *w = (uint32_t const *) r;
+    uint32_t check = ~FAULT_MAGIC;
+    uint32_t i;
+
+    for (i = 0; i < FAULT_WORDS - 1u; i++) {
+        check ^= w[i];
+    }
+
+    return check;
+}
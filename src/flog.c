@@ -0,0 +1,315 @@
+/**
+ ******************************************************************************
+ * @file    flog.c
+ * @author  Joe Todd
+ * @version
+ * @date    October 2026
+ * @brief   Autogrow
+ *          Moisture and watering history in internal flash.
+ *
+ * Records are staged in RAM and programmed a word at a time in batches, so
+ * the flash is only unlocked once per FLOG_STAGE records. Slots are filled
+ * strictly in order and the first word of a record is its time, which is
+ * never 0xFFFFFFFF, so the written part of a sector is always a prefix:
+ * boot finds the end with a binary search on that word rather than reading
+ * every record. A record torn by a reset is left where it is and fails its
+ * CRC when read; one that fails to program has its time word forced to 0
+ * if need be, so it does the same. Records that could not be programmed
+ * stay staged for the next flush.
+ *
+ * Code runs from the same bank, so the CPU stalls while the flash is busy:
+ * a few tens of microseconds per word, around a second to erase sector 4.
+ ******************************************************************************/
+#include "flog.h"
+#include "string.h"
+
+#define FLOG_MAGIC          0x474f4c46u     /* "FLOG" */
+#define FLOG_HDR_SIZE       16u
+#define FLOG_REC_SIZE       sizeof(flog_rec_t)
+#define FLOG_ERASED         0xFFFFFFFFu
+
+typedef struct {
+    uint32_t addr;
+    uint32_t size;
+    uint16_t sector;        /* FLASH_Sector_x */
+} flog_sector_t;
+
+typedef struct {
+    uint32_t magic;
+    uint32_t seq;
+    uint32_t check;         /* ~(magic ^ seq) */
+    uint32_t reserved;
+} flog_hdr_t;
+
+static flog_sector_t const sectors[FLOG_SECTORS] = {
+    {0x0800C000u, 0x4000u, FLASH_Sector_3},
+    {0x08010000u, 0x10000u, FLASH_Sector_4},
+};
+
+static flog_rec_t stage[FLOG_STAGE];
+static uint32_t staged;
+static uint32_t cur;                /* sector being written */
+static uint32_t seq;                /* its sequence number */
+static uint32_t slot;               /* next free slot in it */
+static flog_stats_t stats;
+
+static bool flog_hdr_valid(uint32_t s, uint32_t *hdr_seq);
+static uint32_t flog_slots(uint32_t s);
+static uint32_t flog_slot_addr(uint32_t s, uint32_t n);
+static uint32_t flog_find_end(uint32_t s);
+static flog_rc_t flog_start_sector(uint32_t s, uint32_t new_seq);
+static void flog_walk_sector(uint32_t s, flog_walk_fn fn, void *arg,
+                             bool *more);
+
+extern flog_rc_t
+flog_init(void)
+{
+    uint32_t seqs[FLOG_SECTORS];
+    bool valid[FLOG_SECTORS];
+    uint32_t s;
+
+    crc_init();
+    staged = 0;
+    memset(&stats, 0, sizeof(stats));
+
+    for (s = 0; s < FLOG_SECTORS; s++) {
+        valid[s] = flog_hdr_valid(s, &seqs[s]);
+    }
+
+    if (!valid[0] && !valid[1]) {
+        /*
+         * Blank: pretend sector 1 is full so a failed format is retried.
+         */
+        cur = 1;
+        seq = 0;
+        slot = flog_slots(1);
+        return flog_start_sector(0, 1);
+    }
+    if (valid[0] && valid[1]) {
+        cur = ((int32_t) (seqs[1] - seqs[0]) > 0) ? 1u : 0u;
+    }
+    else {
+        cur = valid[1] ? 1u : 0u;
+    }
+    seq = seqs[cur];
+    slot = flog_find_end(cur);
+
+    return flog_ok;
+}
+
+extern flog_rc_t
+flog_append(uint32_t time, uint8_t zone, flog_type_t type, uint16_t value)
+{
+    flog_rec_t *r;
+
+    if (staged == FLOG_STAGE) {
+        /*
+         * The last flush failed: try again, and drop the record if there
+         * is still no room for it.
+         */
+        (void) flog_flush();
+        if (staged == FLOG_STAGE) {
+            stats.dropped++;
+            return flog_error;
+        }
+    }
+
+    r = &stage[staged];
+    r->time = time;
+    r->value = value;
+    r->zone = zone;
+    r->type = (uint8_t) type;
+    r->crc = crc_block((uint32_t const *) r, 2);
+    staged++;
+    stats.appended++;
+
+    if (staged == FLOG_STAGE) {
+        return flog_flush();
+    }
+
+    return flog_ok;
+}
+
+extern flog_rc_t
+flog_flush(void)
+{
+    uint32_t const *w;
+    uint32_t addr;
+    uint32_t done;
+    uint32_t j;
+    flog_rc_t rc = flog_ok;
+
+    if (staged == 0) {
+        return flog_ok;
+    }
+
+    FLASH_Unlock();
+    FLASH_ClearFlag(FLASH_FLAG_EOP | FLASH_FLAG_OPERR | FLASH_FLAG_WRPERR |
+                    FLASH_FLAG_PGAERR | FLASH_FLAG_PGPERR | FLASH_FLAG_PGSERR);
+
+    for (done = 0; done < staged; done++) {
+        if (slot == flog_slots(cur) &&
+            flog_start_sector(cur ^ 1u, seq + 1u) != flog_ok) {
+            rc = flog_error;
+            break;
+        }
+
+        addr = flog_slot_addr(cur, slot);
+        w = (uint32_t const *) &stage[done];
+        for (j = 0; j < FLOG_REC_SIZE / 4u; j++) {
+            if (FLASH_ProgramWord(addr + 4u * j, w[j]) != FLASH_COMPLETE) {
+                break;
+            }
+        }
+        if (j < FLOG_REC_SIZE / 4u) {
+            /*
+             * An erased time word here would end the prefix early and hide
+             * every record after it from flog_find_end(), so poison it.
+             * The slot is used up once its time word is not erased; the
+             * record is tried again in the next one.
+             */
+            stats.errors++;
+            rc = flog_error;
+            if (j == 0) {
+                (void) FLASH_ProgramWord(addr, 0);
+            }
+            if (*(uint32_t const *) addr != FLOG_ERASED) {
+                slot++;
+            }
+            break;
+        }
+        slot++;
+        stats.programmed++;
+    }
+
+    FLASH_Lock();
+    staged -= done;
+    memmove(stage, &stage[done], staged * sizeof(stage[0]));
+
+    return rc;
+}
+
+extern void
+flog_walk(flog_walk_fn fn, void *arg)
+{
+    uint32_t other = cur ^ 1u;
+    uint32_t other_seq;
+    bool more = true;
+
+    if (flog_hdr_valid(other, &other_seq) && other_seq == seq - 1u) {
+        flog_walk_sector(other, fn, arg, &more);
+    }
+    if (more) {
+        flog_walk_sector(cur, fn, arg, &more);
+    }
+}
+
+extern void
+flog_get_stats(flog_stats_t *s)
+{
+    *s = stats;
+}
+
+static bool
+flog_hdr_valid(uint32_t s, uint32_t *hdr_seq)
+{
+    flog_hdr_t const *h = (flog_hdr_t const *) sectors[s].addr;
+
+    *hdr_seq = h->seq;
+
+    return h->magic == FLOG_MAGIC && h->check == ~(h->magic ^ h->seq);
+}
+
+static uint32_t
+flog_slots(uint32_t s)
+{
+    return (sectors[s].size - FLOG_HDR_SIZE) / FLOG_REC_SIZE;
+}
+
+static uint32_t
+flog_slot_addr(uint32_t s, uint32_t n)
+{
+    return sectors[s].addr + FLOG_HDR_SIZE + n * FLOG_REC_SIZE;
+}
+
+/*
+ * First slot whose time word is still erased. Written slots form a prefix,
+ * so this is a binary search: 13 reads for the 64KB sector.
+ */
+static uint32_t
+flog_find_end(uint32_t s)
+{
+    uint32_t lo = 0;
+    uint32_t hi = flog_slots(s);
+    uint32_t mid;
+
+    while (lo < hi) {
+        mid = lo + (hi - lo) / 2u;
+        if (*(uint32_t const *) flog_slot_addr(s, mid) != FLOG_ERASED) {
+            lo = mid + 1u;
+        }
+        else {
+            hi = mid;
+        }
+    }
+
+    return lo;
+}
+
+/*
+ * Erase a sector and make it the one being written. Expects the flash to
+ * be unlocked if called from flog_flush(), and unlocks it itself at boot.
+ */
+static flog_rc_t
+flog_start_sector(uint32_t s, uint32_t new_seq)
+{
+    bool locked = (FLASH->CR & FLASH_CR_LOCK) != 0;
+    flog_rc_t rc = flog_error;
+
+    if (locked) {
+        FLASH_Unlock();
+    }
+
+    stats.erases++;
+    if (FLASH_EraseSector(sectors[s].sector, VoltageRange_3) == FLASH_COMPLETE &&
+        FLASH_ProgramWord(sectors[s].addr + 4u, new_seq) == FLASH_COMPLETE &&
+        FLASH_ProgramWord(sectors[s].addr + 8u,
+                          ~(FLOG_MAGIC ^ new_seq)) == FLASH_COMPLETE &&
+        FLASH_ProgramWord(sectors[s].addr, FLOG_MAGIC) == FLASH_COMPLETE) {
+        rc = flog_ok;
+    }
+    else {
+        stats.errors++;
+    }
+
+    /*
+     * A sector that fails to start is not used; the full one stays current
+     * and the next flush tries again, so history is never written over.
+     */
+    if (rc == flog_ok) {
+        cur = s;
+        seq = new_seq;
+        slot = 0;
+    }
+
+    if (locked) {
+        FLASH_Lock();
+    }
+
+    return rc;
+}
+
+static void
+flog_walk_sector(uint32_t s, flog_walk_fn fn, void *arg, bool *more)
+{
+    flog_rec_t const *r;
+    uint32_t n = (s == cur) ? slot : flog_find_end(s);
+    uint32_t i;
+
+    for (i = 0; i < n && *more; i++) {
+        r = (flog_rec_t const *) flog_slot_addr(s, i);
+        if (r->crc == crc_block((uint32_t const *) r, 2)) {
+            *more = fn(r, arg);
+        }
+    }
+}
@@ -0,0 +1,64 @@
+/**
+ ******************************************************************************
+ * @file    hot.c
+ * @author  Joe Todd
+ * @version
+ * @date    October 2026
+ * @brief   Autogrow
+ *          Hot state in the RTC backup registers.
+ *
+ *     BKP0R    HOT_MAGIC, cleared while a save is in progress
+ *     BKP1R..  hot_t, one register per word
+ *     BKPnR    CRC unit over the hot_t words
+ ******************************************************************************/
+#include "hot.h"
+
+#define HOT_MAGIC           0x544f4834u     /* "HOT4" */
+#define HOT_WORDS           (sizeof(hot_t) / 4u)
+
+extern bool
+hot_load(hot_t *hot)
+{
+    __IO uint32_t *bkp = &RTC->BKP0R;
+    uint32_t w[HOT_WORDS];
+    uint32_t i;
+
+    crc_init();
+    if (bkp[0] != HOT_MAGIC) {
+        return false;
+    }
+    for (i = 0; i < HOT_WORDS; i++) {
+        w[i] = bkp[1 + i];
+    }
+
+    if (bkp[1 + HOT_WORDS] != crc_block(w, HOT_WORDS)) {
+        return false;
+    }
+
+    for (i = 0; i < HOT_WORDS; i++) {
+        ((uint32_t *) hot)[i] = w[i];
+    }
+
+    return true;
+}
+
+extern void
+hot_save(hot_t const *hot)
+{
+    __IO uint32_t *bkp = &RTC->BKP0R;
+    uint32_t const *w = (uint32_t const *) hot;
+    uint32_t i;
+
+    bkp[0] = 0;
+    for (i = 0; i < HOT_WORDS; i++) {
+        bkp[1 + i] = w[i];
+    }
+    bkp[1 + HOT_WORDS] = crc_block(w, HOT_WORDS);
+    bkp[0] = HOT_MAGIC;
+}
+
+extern void
+hot_clear(void)
+{
+    RTC->BKP0R = 0;
+}
@@ -19,104 +19,458 @@
 #include "timer.h"
 #include "iox.h"
 #include "adc.h"
-#include "stepper.h"
+#include "slog.h"
+#include "sdlog.h"
+#include "flog.h"
+#include "ts.h"
+#include "telem.h"
+#include "param.h"
+#include "shell.h"
+#include "rtc.h"
+#include "hot.h"
+#include "ctl.h"
+#include "zone.h"
+#include "soak.h"
+#include "evt.h"
+#include "wdg.h"
+#include "fault.h"
+#include "stm32f4xx_it.h"
 
-#define BUFFERSIZE      128u
-#define MOIST_LEVEL     2048u
+#define SENSOR_IN_CHAN  11u     /* PC1 */
+#define SENSOR_EN_PORT  ((iox_port_t) param.sensor_en_port)
+#define SENSOR_EN_PIN   param.sensor_en_pin
+#define VALVE_ON_PORT   ((iox_port_t) param.valve_port)
+#define VALVE_ON_PIN    param.valve_pin
+#define UART_BAUD       9600u
+#define HOLD_TICK       2u      /* seconds per TIM2 tick at prescaler 0xF000 */
+#define HOLD_SECONDS    (param.testing ? 2u : param.hold_time * HOLD_TICK)
+#define WDG_MARGIN_MS   5000u   /* on top of a sample or a valve pulse */
+#define WDG_HOLD_PER_S  1125u   /* ms allowed a second of hold, 12.5% over */
+#define WDG_HOLD_MARGIN_MS 60000u   /* and for the wake to come round */
 
-#define SENSOR_IN_PORT  iox_port_c
-#define SENSOR_IN_PIN   1u
-#define SENSOR_EN_PORT  iox_port_c
-#define SENSOR_EN_PIN   2u
-#define VALVE_ON_PORT   iox_port_b
-#define VALVE_ON_PIN    2u
+//#define CAPTURE         /* stream the probe to SD card before starting */
 
-//#define TESTING         /* not testing mode */
-#define VALVE             /* using valve */
-#define HOLD_TIME       86400u / 2u  /* one day - why are clock calculations out by 2? */
-
-/* Prototypes -----------------------------------------------------------------*/
-static uint16_t moisture[BUFFERSIZE] = {0};
+/*
+ * MOIST_LEVEL, HOLD_TIME, the valve pulse, the TESTING/VALVE switches and
+ * the sensor enable and valve pins are run-time parameters now, loaded
+ * from flash at boot; see param.h and the shell.
+ */
 
 /*
- * Turn on water flow for 'time' in ms.
- * @note: stepper not used anymores
+ * One line per zone, up to ZONE_MAX. Zone 0 takes its pins from the
+ * parameters at boot and its setpoint from param.moist_level, kept up to
+ * date from the shell, so a single-zone board needs nothing more.
  */
-static void
-water_on(uint32_t time, uint16_t turns)
-{
-    /* timer ticks at 1ms */
-    timer_reconfigure(0x001e, 0xFFFF);
-    timer_delay(time);
-    iox_led_on(false, false, false, true);
-    stepper_turn_cw(turns);
-    timer_delay(time);
-    iox_led_on(false, false, false, false);
-    stepper_turn_acw(turns);
-}
+static zone_cfg_t zone_table[] = {
+    /* chan          en port/pin   valve port/pin   setpoint */
+    {SENSOR_IN_CHAN, 0, 0,         0, 0,            0},
+};
+
+#define ZONE_TABLE_SIZE (sizeof(zone_table) / sizeof(zone_table[0]))
+
+/* Prototypes -----------------------------------------------------------------*/
+static hot_t hot;               /* survives reset, see hot.h */
+static timer_alarm_t settle;    /* probes powering up for a cycle */
+static bool sampling;
+static bool manual;             /* the reading is for the shell only */
+static bool stamped;            /* a cycle has logged at this uptime */
+main_stats_t main_stats;
+
+static void cycle(void);
+static void peek(void);
+static void settle_start(void);
+static void sampled(void *arg);
+static void command(void);
+static void flush(void);
+
+static bool sample(void);
+static void watered(uint32_t zone, soak_event_t ev, uint32_t value);
+static void resume(void);
+static void start_hold(uint32_t seconds);
 
 /* Main -----------------------------------------------------------------------*/
 int main(void)
 {
     clk_init();
+    (void) fault_init();
+    it_init();
+    evt_init();
+    dma_init();
+    (void) dma_mem_init();
     iox_led_init();
     timer_init();
+    timer_alarm_init();
     adc_init();
-    //stepper_init();
+    (void) param_init();
+    (void) rtc_init();
+    (void) slog_init();     /* history is optional: runs without the chip */
+    (void) flog_init();
+    uart_init(UART_BAUD);
+    telem_init();
 
-    uint32_t i = 0;
+    bool resumed = hot_load(&hot);
 
-    iox_configure_pin(SENSOR_IN_PORT, SENSOR_IN_PIN, iox_mode_analog,
-            iox_type_pp, iox_speed_low, iox_pupd_none);
-    iox_configure_pin(SENSOR_EN_PORT, SENSOR_EN_PIN, iox_mode_out,
-            iox_type_pp, iox_speed_low, iox_pupd_down);
-    iox_configure_pin(VALVE_ON_PORT, VALVE_ON_PIN, iox_mode_out,
-            iox_type_pp, iox_speed_low, iox_pupd_down);
+    zone_table[0].en_port = (uint8_t) SENSOR_EN_PORT;
+    zone_table[0].en_pin = (uint8_t) SENSOR_EN_PIN;
+    zone_table[0].valve_port = (uint8_t) VALVE_ON_PORT;
+    zone_table[0].valve_pin = (uint8_t) VALVE_ON_PIN;
+    zone_table[0].setpoint = (uint16_t) param.moist_level;
+    (void) zone_init(zone_table, ZONE_TABLE_SIZE);
+    soak_init(watered);
     /* Test clock frequency
     iox_configure_pin(iox_port_a, 8, iox_mode_af,
             iox_type_pp, iox_speed_high, iox_pupd_none);
     */
 
-    while (1) {
-        timer_reconfigure(0x7800, 0xFFFF);
-        iox_set_pin_state(SENSOR_EN_PORT, SENSOR_EN_PIN, true);
-        timer_delay(2);
-        moisture[i] = adc_get_measurement();
-        timer_delay(1);
-        iox_set_pin_state(SENSOR_EN_PORT, SENSOR_EN_PIN, false);
-
-        if (moisture[i] > MOIST_LEVEL) {
-            /*
-             * Soil is too dry!
-             */
-#ifdef VALVE
-            iox_set_pin_state(VALVE_ON_PORT, VALVE_ON_PIN, true);
-            timer_delay(5);
-            iox_set_pin_state(VALVE_ON_PORT, VALVE_ON_PIN, false);
-#else
-            /*
-             * Water flow on for 2.5s
-             */
-            water_on(2500, 450);
+#ifdef CAPTURE
+    /*
+     * Probe characterisation: stream the sensor to the SD card until the
+     * card is full.
+     */
+    iox_set_pin_state(SENSOR_EN_PORT, SENSOR_EN_PIN, true);
+    if (sdlog_init() == sdcard_ok && sdlog_start(0) == sdcard_ok) {
+        while (sdlog_service());
+    }
+    iox_set_pin_state(SENSOR_EN_PORT, SENSOR_EN_PIN, false);
 #endif
-        }
-        i = (i + 1) % BUFFERSIZE;
 
-#ifdef TESTING
+    wdg_init();
+    if (wdg_was_reset()) {
+        wdg_reset_t reset;
+
+        wdg_last_reset(&reset);
+        (void) flog_append(main_stats.uptime, reset.task, flog_type_reset,
+                           reset.flags >> 16);
+        (void) telem_send_fault(main_stats.uptime, 1, reset.task, reset.flags);
+    }
+    if (fault_last() != NULL) {
+        fault_rec_t const *f = fault_last();
+
+        (void) flog_append(main_stats.uptime, (uint8_t) f->type,
+                           flog_type_fault, (uint16_t) f->cfsr);
+        (void) telem_send_fault(main_stats.uptime, 2, (uint16_t) f->type,
+                                f->pc);
+    }
+
+    evt_register(evt_alarm, timer_poll);
+    evt_register(evt_shell, command);
+    evt_register(evt_hold, cycle);
+    evt_register(evt_flush, flush);
+
+    if (resumed) {
+        resume();
+    }
+    if (resumed && (int32_t) (hot.next_wake - rtc_now()) > 0) {
         /*
-         * Just wait 2secs if testing
+         * Woken by a reset rather than power up: pick up where the last
+         * cycle left off instead of sampling and watering again now.
          */
-        timer_reconfigure(0x7800, 0xFFFF);
-        timer_delay(2);
-#else
+        start_hold(hot.next_wake - rtc_now());
+    }
+    else {
+        cycle();
+    }
+
+    /*
+     * Everything from here on runs from events: the hold timer starts a
+     * cycle, alarms step the sampling and watering, and the UART brings
+     * commands.
+     */
+    evt_run();
+}
+
+/*
+ * The hold is over: power the probes and come back once they have
+ * settled.
+ */
+static void
+cycle(void)
+{
+    if (sampling && !manual) {
+        return;
+    }
+
+    /*
+     * The last cycle's soaks logged at its uptime while they ran through
+     * the hold, so only move on now that the next cycle starts.
+     */
+    if (stamped) {
+        main_stats.uptime += param.testing ? 2u : 86400u;
+    }
+    stamped = true;
+    wdg_stop(wdg_task_hold);
+
+    /*
+     * A reading for the shell is already settling: it becomes this
+     * cycle's.
+     */
+    manual = false;
+    if (!sampling) {
+        settle_start();
+    }
+}
+
+/*
+ * The shell asked for a sample: read the probes without touching the
+ * uptime, the controllers or the hold.
+ */
+static void
+peek(void)
+{
+    if (sampling) {
+        return;
+    }
+    manual = true;
+    settle_start();
+}
+
+static void
+settle_start(void)
+{
+    sampling = true;
+    wdg_start(wdg_task_sample, ZONE_SETTLE_MS + WDG_MARGIN_MS);
+    zone_sample_start();
+    timer_alarm_start(&settle, ZONE_SETTLE_MS, sampled, NULL);
+}
+
+/*
+ * Probes settled: read them, dose each zone by how far and how long its
+ * soil has been off the setpoint, then water in pulses and soaks while
+ * the next hold runs.
+ */
+static void
+sampled(void *arg)
+{
+    zone_t *z;
+    uint32_t i;
+
+    sampling = false;
+    wdg_stop(wdg_task_sample);
+    if (manual) {
         /*
-         * Else timer overflows in 24hours
+         * Report the reading, but leave the logs to the daily cycle.
          */
-        timer_reconfigure(0xF000, HOLD_TIME);
+        manual = false;
+        if (zone_sample_end(main_stats.uptime)) {
+            for (i = 0; i < zone_count(); i++) {
+                z = zone_get(i);
+                (void) telem_send_sample(main_stats.uptime, i, z->level);
+            }
+            main_stats.moisture = zone_get(0)->level;
+        }
+        return;
+    }
+    if (sample()) {
+        zone_control(param.kp, param.ki, param.kd, param.dose_max);
+        for (i = 0; i < zone_count(); i++) {
+            hot.demand[i] = ctl_demand(&zone_get(i)->ctl);
+        }
+        for (i = 0; i < zone_count(); i++) {
+            z = zone_get(i);
+            if (z->dose != 0) {
+                (void) soak_start(i, z->dose, true);
+            }
+        }
+    }
+    (void) slog_service();
+
+    if (!param.testing) {
         /*
-         * Sleep until timer overflows
+         * Sampling is done for the day, so finish any flash writes now
+         * rather than hold the records in RAM until the next wake.
          */
-        __WFI();
-#endif
+        slog_flush();
+        evt_post(evt_flush);
+    }
+
+    /*
+     * Just wait 2secs if testing, else 24hours
+     */
+    start_hold(HOLD_SECONDS);
+}
+
+/*
+ * Carry out what the shell asks for.
+ */
+static void
+command(void)
+{
+    zone_t *z;
+    uint32_t arg;
+
+    shell_poll();
+    /*
+     * 'set moist_level' takes effect now, for the next controller run
+     * and for a soak already under way.
+     */
+    z = zone_get(0);
+    if (z != NULL) {
+        z->cfg.setpoint = (uint16_t) param.moist_level;
+    }
+    switch (shell_take_request(&arg)) {
+    case shell_req_sample:
+        peek();
+        break;
+
+    case shell_req_water:
+        (void) soak_start(arg >> 8, arg & 0xFFu, false);
+        break;
+
+    default:
+        break;
+    }
+}
+
+/*
+ * One step of the log writes at a time, so commands and alarms get in
+ * between them.
+ */
+static void
+flush(void)
+{
+    if (slog_service()) {
+        evt_post(evt_flush);
+    }
+    else {
+        (void) flog_flush();
+    }
+}
+
+/*
+ * Read every zone and log the readings.
+ */
+static bool
+sample(void)
+{
+    zone_t *z;
+    uint32_t i;
+
+    if (!zone_sample_end(main_stats.uptime)) {
+        return false;
+    }
+    main_stats.samples++;
+
+    for (i = 0; i < zone_count(); i++) {
+        z = zone_get(i);
+        (void) slog_append(main_stats.uptime, i, slog_type_moisture, z->level);
+        (void) flog_append(main_stats.uptime, i, flog_type_moisture, z->level);
+        (void) telem_send_sample(main_stats.uptime, i, z->level);
+    }
+
+    z = zone_get(0);
+    main_stats.moisture = z->level;
+    hot.level = z->level;
+
+    return true;
+}
+
+/*
+ * Keep the hot state and the logs up to date as the zones are watered.
+ */
+static void
+watered(uint32_t zone, soak_event_t ev, uint32_t value)
+{
+    zone_t *z = zone_get(zone);
+
+    switch (ev) {
+    case soak_open:
+        /*
+         * Note the pulse before opening so a reset part way through can
+         * finish it rather than leave the bed short or water it twice.
+         */
+        main_stats.waterings++;
+        hot.valve_busy = 1;
+        hot.valve_open = rtc_now();
+        hot.valve_pulse = (uint16_t) value;
+        hot.valve_zone = (uint16_t) zone;
+        hot.waterings = main_stats.waterings;
+        hot_save(&hot);
+        wdg_start(wdg_task_valve, value * 1000u + WDG_MARGIN_MS);
+        break;
+
+    case soak_close:
+        wdg_stop(wdg_task_valve);
+        hot.valve_busy = 0;
+        hot_save(&hot);
+        (void) slog_append(main_stats.uptime, zone, slog_type_water, value);
+        (void) flog_append(main_stats.uptime, zone, flog_type_water, value);
+        ts_append(&z->flow, main_stats.uptime, value);
+        (void) telem_send_water(main_stats.uptime, zone, value);
+        break;
+
+    case soak_reading:
+        (void) slog_append(main_stats.uptime, zone, slog_type_moisture, value);
+        (void) flog_append(main_stats.uptime, zone, flog_type_moisture, value);
+        (void) telem_send_sample(main_stats.uptime, zone, value);
+        break;
+
+    default:
+        break;
+    }
+}
+
+/*
+ * Restore the counters and controller from the saved state and finish a
+ * valve pulse that a reset cut short. The pin itself came out of reset
+ * low, so the valve is already shut. The hold the pulse ran in goes on
+ * to its saved end.
+ */
+static void
+resume(void)
+{
+    int32_t done;
+    uint32_t i;
+
+    main_stats.uptime = hot.uptime;
+    stamped = true;
+    main_stats.samples = hot.samples;
+    main_stats.waterings = hot.waterings;
+    main_stats.moisture = hot.level;
+    for (i = 0; i < zone_count(); i++) {
+        ctl_resume(&zone_get(i)->ctl, hot.demand[i]);
+    }
+
+    if (hot.valve_busy == 0) {
+        return;
+    }
+
+    done = (int32_t) (rtc_now() - hot.valve_open);
+    if (done < 0) {
+        done = 0;                   /* the RTC was set back */
+    }
+    hot.valve_busy = 0;
+    if ((uint32_t) done < hot.valve_pulse) {
+        main_stats.waterings--;     /* counted when it was opened */
+        (void) soak_start(hot.valve_zone, hot.valve_pulse - done, false);
+    }
+    else {
+        hot_save(&hot);
+    }
+}
+
+/*
+ * Record when the next cycle is due, then start TIM2 counting towards it.
+ * The TIM2 counter is 16 bits, so the hold is capped at ~36 hours.
+ */
+static void
+start_hold(uint32_t seconds)
+{
+    hot.next_wake = rtc_now() + seconds;
+    hot.uptime = main_stats.uptime;
+    hot.samples = main_stats.samples;
+    hot.waterings = main_stats.waterings;
+    hot_save(&hot);
+
+    /*
+     * TIM2 and TIM5 prescale the same clock, to within 1%, so the slack
+     * per second is generous; 36 hours of it is still well inside 2^32.
+     */
+    wdg_start(wdg_task_hold, seconds * WDG_HOLD_PER_S + WDG_HOLD_MARGIN_MS);
+    if (seconds <= HOLD_TICK) {
+        timer_reconfigure(0x7800, 1);
+    }
+    else {
+        seconds /= HOLD_TICK;
+        timer_reconfigure(0xF000, (seconds > 0xFFFFu) ? 0xFFFFu : seconds);
     }
 }
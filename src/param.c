@@ -0,0 +1,177 @@
+/**
+ ******************************************************************************
+ * @file    param.c
+ * @author  Joe Todd
+ * @version
+ * @date    October 2026
+ * @brief   Autogrow
+ *          Named run-time parameters, saved in the flash config store.
+ *
+ * param_t is only ever extended at the end, so a record saved by older
+ * firmware loads over the defaults and the new fields keep theirs; a
+ * record from newer firmware loads the fields this one knows. Whatever
+ * is loaded is range checked, so a value this firmware would not accept
+ * from the shell falls back to its default.
+ *
+ * Fields whose meaning changed are converted from the version the record
+ * was saved with (param_migrate()) and the record saved again, once:
+ *
+ *      1, 2    valve_pulse was TIM2 ticks at prescaler 0x7800, 0.98s
+ *      3       dose_max, kp, ki, kd added
+ *      4       soak_pulse, soak_time, soak_band added
+ ******************************************************************************/
+#include "param.h"
+#include "string.h"
+
+#define PARAM_VERSION       4u
+#define PARAM_NUM           (sizeof(table) / sizeof(table[0]))
+
+#define PARAM_OLD_TICK_NUM  (0x7800u + 1u)  /* v1-2 valve_pulse tick, s */
+#define PARAM_OLD_TICK_DEN  31250u
+
+typedef struct {
+    char const *name;
+    uint32_t *value;
+    uint32_t min;
+    uint32_t max;
+    uint32_t def;
+} param_desc_t;
+
+param_t param;
+
+static param_desc_t const table[] = {
+    {"moist_level",    &param.moist_level,    0, 4095,   PARAM_MOIST_LEVEL},
+    {"hold_time",      &param.hold_time,      1, 0xFFFF, PARAM_HOLD_TIME},
+    {"valve_pulse",    &param.valve_pulse,    1, 60,     PARAM_VALVE_PULSE},
+    {"testing",        &param.testing,        0, 1,      PARAM_TESTING},
+    {"sensor_en_port", &param.sensor_en_port, 0, 4,      PARAM_SENSOR_EN_PORT},
+    {"sensor_en_pin",  &param.sensor_en_pin,  0, 15,     PARAM_SENSOR_EN_PIN},
+    {"valve_port",     &param.valve_port,     0, 4,      PARAM_VALVE_PORT},
+    {"valve_pin",      &param.valve_pin,      0, 15,     PARAM_VALVE_PIN},
+    {"dose_max",       &param.dose_max,       1, 60,     PARAM_DOSE_MAX},
+    {"kp",             &param.kp,             0, 0x7FFF, PARAM_KP},
+    {"ki",             &param.ki,             0, 0x7FFF, PARAM_KI},
+    {"kd",             &param.kd,             0, 0x7FFF, PARAM_KD},
+    {"soak_pulse",     &param.soak_pulse,     1, 60,     PARAM_SOAK_PULSE},
+    {"soak_time",      &param.soak_time,      1, 3600,   PARAM_SOAK_TIME},
+    {"soak_band",      &param.soak_band,      0, 4095,   PARAM_SOAK_BAND},
+};
+
+static param_desc_t const *param_find(char const *name);
+static void param_migrate(uint16_t version);
+
+extern bool
+param_init(void)
+{
+    uint16_t version;
+    uint32_t len;
+    uint32_t i;
+
+    param_defaults();
+
+    if (cfg_load(&param, sizeof(param), &version, &len) != cfg_ok) {
+        return false;
+    }
+
+    param_migrate(version);
+    for (i = 0; i < PARAM_NUM; i++) {
+        if (*table[i].value < table[i].min || *table[i].value > table[i].max) {
+            *table[i].value = table[i].def;
+        }
+    }
+    if (version < PARAM_VERSION) {
+        (void) param_save();
+    }
+
+    return true;
+}
+
+extern void
+param_defaults(void)
+{
+    uint32_t i;
+
+    for (i = 0; i < PARAM_NUM; i++) {
+        *table[i].value = table[i].def;
+    }
+}
+
+extern bool
+param_save(void)
+{
+    return cfg_save(&param, sizeof(param), PARAM_VERSION) == cfg_ok;
+}
+
+extern uint32_t
+param_count(void)
+{
+    return PARAM_NUM;
+}
+
+extern char const *
+param_name(uint32_t i)
+{
+    return (i < PARAM_NUM) ? table[i].name : NULL;
+}
+
+extern bool
+param_get(char const *name, uint32_t *value)
+{
+    param_desc_t const *p = param_find(name);
+
+    if (p == NULL) {
+        return false;
+    }
+    *value = *p->value;
+
+    return true;
+}
+
+extern bool
+param_set(char const *name, uint32_t value)
+{
+    param_desc_t const *p = param_find(name);
+
+    if (p == NULL || value < p->min || value > p->max) {
+        return false;
+    }
+    *p->value = value;
+
+    return true;
+}
+
+static param_desc_t const *
+param_find(char const *name)
+{
+    uint32_t i;
+
+    for (i = 0; i < PARAM_NUM; i++) {
+        if (strcmp(name, table[i].name) == 0) {
+            return &table[i];
+        }
+    }
+
+    return NULL;
+}
+
+/*
+ * Bring values saved by an older schema to this one's units. Fields that
+ * were only appended need nothing: a shorter record left their defaults.
+ * A newer record's fields are taken as they are.
+ */
+static void
+param_migrate(uint16_t version)
+{
+    switch (version) {
+    case 1:
+    case 2:
+        param.valve_pulse = (param.valve_pulse * PARAM_OLD_TICK_NUM
+                             + PARAM_OLD_TICK_DEN / 2u) / PARAM_OLD_TICK_DEN;
+        if (param.valve_pulse == 0) {
+            param.valve_pulse = 1;
+        }
+        break;
+    default:
+        break;
+    }
+}
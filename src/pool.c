@@ -0,0 +1,86 @@
+/**
+ ******************************************************************************
+ * @file    pool.c
+ * @author  Joe Todd
+ * @version
+ * @date    October 2026
+ * @brief   Autogrow
+ *          Fixed-block pool allocator.
+ *
+ ******************************************************************************/
+#include "pool.h"
+#include "string.h"
+
+extern void
+pool_init(pool_t *pool)
+{
+    uint8_t *p = pool->mem;
+    uint32_t i;
+
+    pool->free = NULL;
+    for (i = pool->blocks; i > 0; i--) {
+        *(void **) &p[(i - 1u) * pool->size] = pool->free;
+        pool->free = &p[(i - 1u) * pool->size];
+    }
+    pool->used = 0;
+    pool->high = 0;
+    pool->exhausted = 0;
+}
+
+extern void *
+pool_alloc(pool_t *pool)
+{
+    uint32_t primask;
+    void *block;
+
+    primask = __get_PRIMASK();
+    __disable_irq();
+    block = pool->free;
+    if (block != NULL) {
+        pool->free = *(void **) block;
+        if (++pool->used > pool->high) {
+            pool->high = pool->used;
+        }
+    }
+    else {
+        pool->exhausted++;
+    }
+    __set_PRIMASK(primask);
+
+    return block;
+}
+
+extern void
+pool_free(pool_t *pool, void *block)
+{
+    uint32_t primask;
+
+    if (block == NULL) {
+        return;
+    }
+
+    primask = __get_PRIMASK();
+    __disable_irq();
+    *(void **) block = pool->free;
+    pool->free = block;
+    pool->used--;
+    __set_PRIMASK(primask);
+}
+
+extern uint32_t
+pool_used(pool_t const *pool)
+{
+    return pool->used;
+}
+
+extern uint32_t
+pool_high(pool_t const *pool)
+{
+    return pool->high;
+}
+
+extern uint32_t
+pool_exhausted(pool_t const *pool)
+{
+    return pool->exhausted;
+}
@@ -0,0 +1,312 @@
+/**
+ ******************************************************************************
+ * @file    qemu.c
+ * @author  Joe Todd
+ * @version
+ * @date    October 2026
+ * @brief   Autogrow
+ *          Stand-ins for the QEMU test image, built by 'make qemu'.
+ *
+ * qemu-system-arm's STM32F4 machines model the core, the timers, the
+ * USARTs and not much else: RCC, RTC, GPIO, DMA and flash are RAZ/WI, so
+ * the clock and RTC start-ups would spin forever, and the ADC scan and
+ * UART transmit, both on DMA, would never finish. The firmware is linked
+ * unchanged with --wrap on the calls below, made across modules:
+ *
+ *      clk_init            the reset clock, HSI; measures the timer clock
+ *                          and starts the test clock
+ *      rtc_init, rtc_now   seconds from the test clock
+ *      adc_scan            readings from a pot that dries and is watered,
+ *                          "adc <zone> <reading>"
+ *      uart_tx_submit      dropped, and completed at once
+ *      evt_run             "boot", as the event loop starts
+ *      zone_sample_start   "cycle", and the end after QEMU_CYCLES of them
+ *      zone_valve          "valve <zone> open|close"
+ *
+ * Each event is a semihosting line "<ms> <event> [<zone> <value>]", the
+ * time on SysTick, independent of the timers under test; run by
+ * tools/qemu_test.py, which checks them.
+ *
+ * QEMU's timers do not run on the board's 31.25kHz APB1 timer clock but
+ * on whatever its STM32F405 model gives them, which it sets itself, so
+ * -global cannot change it. clk_init therefore counts TIM5 against
+ * SysTick, reports the rate as "timclk 0 <Hz>", and every time is given
+ * in board milliseconds: the SysTick time scaled by the timer clock over
+ * the board's. Timed waits then read as they would on the board, and the
+ * runner turns times back with timclk for what the CPU alone decides,
+ * such as how long boot took.
+ ******************************************************************************/
+#include "rcc.h"
+#include "rtc.h"
+#include "adc.h"
+#include "uart.h"
+#include "zone.h"
+#include "evt.h"
+#include "semi.h"
+
+#define QEMU_SYSCLK_HZ      168000000u  /* netduinoplus2 */
+#define QEMU_BOARD_TIMCLK   31250u      /* APB1 timer clock on the board */
+#define QEMU_TIMCLK_COUNTS  100000u     /* TIM5 counts timed, to 1 in 1e5 */
+#define QEMU_TIMCLK_GIVE_UP (1ull << 32)    /* SysTick ticks, ~25s */
+#define QEMU_CYCLES         4u          /* sample cycles before exiting */
+#define QEMU_PLANT_START    2600u       /* dry of the default setpoint */
+#define QEMU_PLANT_DRY      20u         /* counts an hour */
+#define QEMU_PLANT_WET      40u         /* counts a second of valve */
+#define QEMU_PLANT_MIN      1200u
+#define QEMU_PLANT_MAX      3500u
+
+extern void __real_evt_run(void) __attribute__((noreturn));
+extern void __real_zone_sample_start(void);
+extern void __real_zone_valve(uint32_t i, bool open);
+
+static uint32_t volatile wraps;     /* SysTick periods of 2^24 */
+static uint32_t level[ADC_CHANNELS];
+static uint32_t dried;              /* ms of drying already applied */
+static uint32_t opened[ZONE_MAX];   /* ms the valve opened, 0 if shut */
+static uint32_t cycles;
+static uint32_t tim_counts;         /* TIM5 counts in tim_ticks */
+static uint64_t tim_ticks;          /* of SysTick */
+static uint32_t timclk;             /* Hz, 0 if TIM5 never counted */
+
+static void qemu_timclk(void);
+static uint64_t qemu_ticks(void);
+static uint32_t qemu_ms(void);
+static void qemu_event(char const *what, uint32_t zone, uint32_t value,
+                       bool args);
+static void qemu_dry(void);
+
+extern void
+SysTick_Handler(void)
+{
+    wraps++;
+}
+
+extern void
+__wrap_clk_init(void)
+{
+    uint32_t i;
+
+    for (i = 0; i < ADC_CHANNELS; i++) {
+        level[i] = QEMU_PLANT_START;
+    }
+
+    SysTick->LOAD = SysTick_LOAD_RELOAD_Msk;
+    SysTick->VAL = 0;
+    SysTick->CTRL = SysTick_CTRL_CLKSOURCE_Msk | SysTick_CTRL_TICKINT_Msk
+        | SysTick_CTRL_ENABLE_Msk;
+
+    qemu_timclk();
+
+    /*
+     * Times run from here, not counting the measurement.
+     */
+    SysTick->VAL = 0;
+    SCB->ICSR = SCB_ICSR_PENDSTCLR_Msk;
+    wraps = 0;
+}
+
+extern bool
+__wrap_rtc_init(void)
+{
+    return true;
+}
+
+extern uint32_t
+__wrap_rtc_now(void)
+{
+    return qemu_ms() / 1000u;
+}
+
+extern bool
+__wrap_adc_scan(uint8_t const *chans, uint32_t n, uint16_t *out)
+{
+    uint32_t i;
+    uint32_t z;
+
+    if (n == 0 || n > ADC_SCAN_MAX) {
+        return false;
+    }
+
+    qemu_dry();
+    for (i = 0; i < n; i++) {
+        if (chans[i] >= ADC_CHANNELS) {
+            return false;
+        }
+        out[i] = (uint16_t) level[chans[i]];
+        for (z = 0; z < zone_count(); z++) {
+            if (zone_get(z)->cfg.chan == chans[i]) {
+                qemu_event("adc", z, out[i], true);
+            }
+        }
+    }
+
+    return true;
+}
+
+/*
+ * The DMA never runs, so nothing would ever be sent: hand the buffer
+ * straight back. Telemetry and shell output are not checked here.
+ */
+extern void
+__wrap_uart_tx_submit(uart_tx_desc_t *desc)
+{
+    if (desc->done != NULL) {
+        desc->done(desc->arg);
+    }
+}
+
+extern void
+__wrap_evt_run(void)
+{
+    qemu_event("boot", 0, 0, false);
+    qemu_event("timclk", 0, timclk, true);
+    __real_evt_run();
+}
+
+extern void
+__wrap_zone_sample_start(void)
+{
+    if (cycles++ == QEMU_CYCLES) {
+        qemu_event("end", 0, 0, false);
+        semi_exit(true);
+    }
+    qemu_event("cycle", 0, 0, false);
+    __real_zone_sample_start();
+}
+
+/*
+ * Wet the pot by the time the valve was open, when it shuts.
+ */
+extern void
+__wrap_zone_valve(uint32_t i, bool open)
+{
+    uint32_t chan;
+    uint32_t wet;
+
+    __real_zone_valve(i, open);
+    if (i >= zone_count()) {
+        return;
+    }
+
+    chan = zone_get(i)->cfg.chan;
+    if (open && opened[i] == 0) {
+        opened[i] = qemu_ms() | 1u;
+    }
+    else if (!open && opened[i] != 0 && chan < ADC_CHANNELS) {
+        wet = (qemu_ms() - opened[i]) * QEMU_PLANT_WET / 1000u;
+        level[chan] = (level[chan] > QEMU_PLANT_MIN + wet)
+            ? level[chan] - wet : QEMU_PLANT_MIN;
+        opened[i] = 0;
+    }
+    qemu_event("valve", i, open, true);
+}
+
+/*
+ * Count TIM5 from the top, unprescaled, against SysTick, and put it back
+ * as it came out of reset for timer_alarm_init(). If it never moves the
+ * times are left on SysTick at the board's clock.
+ */
+static void
+qemu_timclk(void)
+{
+    uint64_t start;
+    uint32_t n;
+
+    TIM5->PSC = 0;
+    TIM5->ARR = 0xFFFFFFFFu;
+    TIM5->CNT = 0;
+    TIM5->CR1 = TIM_CR1_CEN;
+
+    start = qemu_ticks();
+    do {
+        n = TIM5->CNT;
+        tim_ticks = qemu_ticks() - start;
+    } while (n < QEMU_TIMCLK_COUNTS && tim_ticks < QEMU_TIMCLK_GIVE_UP);
+
+    TIM5->CR1 = 0;
+    TIM5->CNT = 0;
+
+    if (n < QEMU_TIMCLK_COUNTS) {
+        tim_counts = QEMU_BOARD_TIMCLK;
+        tim_ticks = QEMU_SYSCLK_HZ;
+        timclk = 0;
+        return;
+    }
+    tim_counts = n;
+    timclk = (uint32_t) ((uint64_t) n * QEMU_SYSCLK_HZ / tim_ticks);
+}
+
+/*
+ * SysTick ticks since clk_init(). A wrap that is due but not yet taken is
+ * counted once the count has gone back to the top.
+ */
+static uint64_t
+qemu_ticks(void)
+{
+    uint32_t w;
+    uint32_t val;
+
+    do {
+        w = wraps;
+        val = SysTick->VAL;
+    } while (w != wraps);
+
+    if ((SCB->ICSR & SCB_ICSR_PENDSTSET_Msk) &&
+        val > SysTick_LOAD_RELOAD_Msk / 2u) {
+        w++;
+    }
+
+    return ((uint64_t) w << 24) + (SysTick_LOAD_RELOAD_Msk - val);
+}
+
+/*
+ * Board milliseconds since clk_init(), good for 2^32 ms: ticks x
+ * tim_counts / tim_ticks is the board timer count, and the board's timer
+ * clock makes 31.25 of those a millisecond. Split so as not to overflow.
+ */
+static uint32_t
+qemu_ms(void)
+{
+    uint64_t t = qemu_ticks();
+    uint64_t q = t / tim_ticks;
+    uint64_t r = t % tim_ticks;
+
+    return (uint32_t) ((q * tim_counts * 1000u
+                        + r * tim_counts * 1000u / tim_ticks)
+                       / QEMU_BOARD_TIMCLK);
+}
+
+static void
+qemu_event(char const *what, uint32_t zone, uint32_t value, bool args)
+{
+    semi_putu(qemu_ms());
+    semi_puts(" ");
+    semi_puts(what);
+    if (args) {
+        semi_puts(" ");
+        semi_putu(zone);
+        semi_puts(" ");
+        semi_putu(value);
+    }
+    semi_puts("\n");
+}
+
+/*
+ * Every pot dries by QEMU_PLANT_DRY an hour since the last look.
+ */
+static void
+qemu_dry(void)
+{
+    uint32_t now = qemu_ms();
+    uint32_t hours = (now - dried) / 3600000u;
+    uint32_t i;
+
+    if (hours == 0) {
+        return;
+    }
+    dried += hours * 3600000u;
+    for (i = 0; i < ADC_CHANNELS; i++) {
+        level[i] += hours * QEMU_PLANT_DRY;
+        level[i] = (level[i] > QEMU_PLANT_MAX) ? QEMU_PLANT_MAX : level[i];
+    }
+}
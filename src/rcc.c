@@ -23,3 +23,23 @@ clk_init(void)
     RCC->CR = RCC_CR_HSEON;
     while ((RCC->CR & RCC_CR_HSERDY) != RCC_CR_HSERDY);	
 }
+
+/*
+ * Start the main PLL for the 48MHz clock used by SDIO.
+ * HSE 8MHz / M 8 * N 192 = 192MHz VCO, / Q 4 = 48MHz.
+ * SYSCLK is left where it is, P (/4) is unused.
+ */
+extern void
+clk_pll48_enable(void)
+{
+    if ((RCC->CR & RCC_CR_PLLRDY) != 0) {
+        return;
+    }
+    RCC->PLLCFGR = (RCC_PLLCFGR_PLLSRC_HSE
+        | (8u << 0)         /* PLLM */
+        | (192u << 6)       /* PLLN */
+        | (1u << 16)        /* PLLP = 4 */
+        | (4u << 24));      /* PLLQ */
+    RCC->CR |= RCC_CR_PLLON;
+    while ((RCC->CR & RCC_CR_PLLRDY) != RCC_CR_PLLRDY);
+}
@@ -0,0 +1,160 @@
+/**
+ ******************************************************************************
+ * @file    ring.c
+ * @author  Joe Todd
+ * @version
+ * @date    October 2026
+ * @brief   Autogrow
+ *          Lock-free single-producer, single-consumer ring.
+ *
+ ******************************************************************************/
+#include "ring.h"
+#include "string.h"
+
+extern bool
+ring_init(ring_t *ring, void *buf, uint32_t slots, uint32_t size)
+{
+    ring->buf = buf;
+    ring->size = size;
+    ring->head = 0;
+    ring->tail = 0;
+
+    if (slots == 0 || (slots & (slots - 1u)) != 0 || size == 0) {
+        ring->mask = 0;
+        ring->size = 0;
+        return false;
+    }
+    ring->mask = slots - 1u;
+
+    return true;
+}
+
+extern bool
+ring_put(ring_t *ring, void const *rec)
+{
+    uint32_t head = ring->head;
+
+    if (ring->size == 0 || head - ring->tail > ring->mask) {
+        return false;
+    }
+    __DMB();
+
+    memcpy(&ring->buf[(head & ring->mask) * ring->size], rec, ring->size);
+    __DMB();
+    ring->head = head + 1u;
+
+    return true;
+}
+
+extern bool
+ring_get(ring_t *ring, void *rec)
+{
+    void const *p = ring_peek(ring);
+
+    if (p == NULL) {
+        return false;
+    }
+    memcpy(rec, p, ring->size);
+    ring_drop(ring);
+
+    return true;
+}
+
+extern void *
+ring_peek(ring_t *ring)
+{
+    uint32_t tail = ring->tail;
+
+    if (ring->head == tail) {
+        return NULL;
+    }
+    __DMB();
+
+    return &ring->buf[(tail & ring->mask) * ring->size];
+}
+
+extern void
+ring_drop(ring_t *ring)
+{
+    if (ring->head == ring->tail) {
+        return;
+    }
+    __DMB();
+    ring->tail++;
+}
+
+/*
+ * Copy in at most two runs, either side of the end of the buffer, and
+ * publish them together.
+ */
+extern uint32_t
+ring_write(ring_t *ring, void const *data, uint32_t len)
+{
+    uint8_t const *src = data;
+    uint32_t head = ring->head;
+    uint32_t space = ring->mask + 1u - (head - ring->tail);
+    uint32_t off;
+    uint32_t run;
+
+    if (ring->size != 1u) {
+        return 0;
+    }
+    __DMB();
+
+    if (len > space) {
+        len = space;
+    }
+    off = head & ring->mask;
+    run = ring->mask + 1u - off;
+    if (run > len) {
+        run = len;
+    }
+    memcpy(&ring->buf[off], src, run);
+    memcpy(ring->buf, src + run, len - run);
+    __DMB();
+    ring->head = head + len;
+
+    return len;
+}
+
+extern uint32_t
+ring_read(ring_t *ring, void *data, uint32_t len)
+{
+    uint8_t *dst = data;
+    uint32_t tail = ring->tail;
+    uint32_t count = ring->head - tail;
+    uint32_t off;
+    uint32_t run;
+
+    if (ring->size != 1u) {
+        return 0;
+    }
+    __DMB();
+
+    if (len > count) {
+        len = count;
+    }
+    off = tail & ring->mask;
+    run = ring->mask + 1u - off;
+    if (run > len) {
+        run = len;
+    }
+    memcpy(dst, &ring->buf[off], run);
+    memcpy(dst + run, ring->buf, len - run);
+    __DMB();
+    ring->tail = tail + len;
+
+    return len;
+}
+
+extern uint32_t
+ring_count(ring_t const *ring)
+{
+    return ring->head - ring->tail;
+}
+
+extern uint32_t
+ring_space(ring_t const *ring)
+{
+    return (ring->size == 0) ? 0 : ring->mask + 1u - (ring->head - ring->tail);
+}
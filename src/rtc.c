@@ -0,0 +1,95 @@
+/**
+ ******************************************************************************
+ * @file    rtc.c
+ * @author  Joe Todd
+ * @version
+ * @date    October 2026
+ * @brief   Autogrow
+ *          RTC as a seconds counter that survives reset.
+ *
+ * The board has no LSE crystal, so the RTC runs from LSI (~32kHz), which
+ * a reset turns off along with the rest of RCC_CSR; it is switched back
+ * on first thing, so the calendar only loses the time taken to boot.
+ ******************************************************************************/
+#include "rtc.h"
+
+#define RTC_PREDIV_A        127u
+#define RTC_PREDIV_S        249u    /* 32kHz / 128 / 250 = 1Hz */
+#define RTC_DR_START        0x00002101u     /* Monday 2000-01-01 */
+
+static uint32_t rtc_bcd(uint32_t reg, uint32_t shift, uint32_t mask);
+
+static uint16_t const month_days[12] = {
+    0, 31, 59, 90, 120, 151, 181, 212, 243, 273, 304, 334,
+};
+
+extern bool
+rtc_init(void)
+{
+    RCC->APB1ENR |= RCC_APB1ENR_PWREN;
+    PWR->CR |= PWR_CR_DBP;
+
+    RCC->CSR |= RCC_CSR_LSION;
+    while ((RCC->CSR & RCC_CSR_LSIRDY) == 0);
+
+    if (RCC->BDCR & RCC_BDCR_RTCEN) {
+        return true;
+    }
+
+    RCC->BDCR = (RCC->BDCR & ~RCC_BDCR_RTCSEL) | RCC_BDCR_RTCSEL_1;
+    RCC->BDCR |= RCC_BDCR_RTCEN;
+
+    RTC->WPR = 0xCA;
+    RTC->WPR = 0x53;
+    RTC->ISR |= RTC_ISR_INIT;
+    while ((RTC->ISR & RTC_ISR_INITF) == 0);
+    RTC->PRER = RTC_PREDIV_S;
+    RTC->PRER |= RTC_PREDIV_A << 16;
+    RTC->TR = 0;
+    RTC->DR = RTC_DR_START;
+    RTC->CR |= RTC_CR_BYPSHAD;      /* read the counters directly */
+    RTC->ISR &= ~RTC_ISR_INIT;
+    RTC->WPR = 0xFF;
+
+    return false;
+}
+
+/*
+ * With the shadow registers bypassed, TR and DR can tick between reads,
+ * so read until TR is the same either side of DR.
+ */
+extern uint32_t
+rtc_now(void)
+{
+    uint32_t tr;
+    uint32_t dr;
+    uint32_t year;
+    uint32_t month;
+    uint32_t days;
+
+    do {
+        tr = RTC->TR;
+        dr = RTC->DR;
+    } while (tr != RTC->TR);
+
+    year = rtc_bcd(dr, 16, 0xFF);
+    month = rtc_bcd(dr, 8, 0x1F);
+    days = year * 365u + (year + 3u) / 4u + month_days[month - 1u]
+        + rtc_bcd(dr, 0, 0x3F) - 1u;
+    if (month > 2u && (year % 4u) == 0) {
+        days++;
+    }
+
+    return days * 86400u
+        + rtc_bcd(tr, 16, 0x3F) * 3600u
+        + rtc_bcd(tr, 8, 0x7F) * 60u
+        + rtc_bcd(tr, 0, 0x7F);
+}
+
+static uint32_t
+rtc_bcd(uint32_t reg, uint32_t shift, uint32_t mask)
+{
+    uint32_t v = (reg >> shift) & mask;
+
+    return (v >> 4) * 10u + (v & 0xFu);
+}
@@ -0,0 +1,428 @@
+/**
+ ******************************************************************************
+ * @file    sdcard.c
+ * @author  Joe Todd
+ * @version
+ * @date    October 2026
+ * @brief   Autogrow
+ *          microSD card over SDIO, 4-bit bus, DMA2 Stream 3 channel 4.
+ *
+ * Connections
+ *
+ *      D0-D3 - PC8-PC11
+ *      CK    - PC12
+ *      CMD   - PD2
+ *
+ * Writes are multi-block (CMD25) with the card told the block count up
+ * front (ACMD23) so it can pre-erase. The data phase runs entirely on DMA
+ * with hardware flow control, and the SDIO interrupt sends the stop
+ * command, so the caller only has to poll sdcard_status() to find out
+ * when the card has finished programming.
+ ******************************************************************************/
+#include "sdcard.h"
+#include "string.h"
+
+#define SD_DMA              DMA_STREAM(2, 3)
+#define SD_DMA_CHAN         4u
+
+#define CMD_GO_IDLE         0u
+#define CMD_ALL_SEND_CID    2u
+#define CMD_SEND_REL_ADDR   3u
+#define CMD_SELECT          7u
+#define CMD_SEND_IF_COND    8u
+#define CMD_SEND_CSD        9u
+#define CMD_STOP            12u
+#define CMD_SEND_STATUS     13u
+#define CMD_SET_BLOCKLEN    16u
+#define CMD_READ_SINGLE     17u
+#define CMD_WRITE_MULTI     25u
+#define CMD_APP             55u
+#define ACMD_SET_BUS_WIDTH  6u
+#define ACMD_SET_WR_ERASE   23u
+#define ACMD_SEND_OP_COND   41u
+
+#define OCR_BUSY            0x80000000u
+#define OCR_CCS             0x40000000u
+#define OCR_VOLTAGE         0x00100000u     /* 3.2-3.3V */
+#define R1_ERRORS           0xFDFFE008u
+#define R1_STATE(r)         (((r) >> 9) & 0x0Fu)
+#define R1_STATE_TRAN       4u
+
+#define CMD_TIMEOUT         0x10000u
+#define OP_COND_TRIES       0x1000u
+#define DATA_TIMEOUT        400000u         /* card clocks, 1s */
+
+#define STA_CMD_DONE        (SDIO_STA_CCRCFAIL | SDIO_STA_CTIMEOUT \
+                            | SDIO_STA_CMDREND | SDIO_STA_CMDSENT)
+#define STA_DATA_ERRORS     (SDIO_STA_DCRCFAIL | SDIO_STA_DTIMEOUT \
+                            | SDIO_STA_TXUNDERR | SDIO_STA_RXOVERR \
+                            | SDIO_STA_STBITERR)
+
+typedef enum {
+    sd_idle,
+    sd_writing,
+    sd_programming,
+    sd_failed,
+} sd_state_t;
+
+static volatile sd_state_t sd_state = sd_failed;
+static uint32_t rca;
+static uint32_t nblocks;
+static bool high_capacity;
+static bool dma_claimed;
+
+static bool sdcard_cmd(uint32_t idx, uint32_t arg, uint32_t resp);
+static bool sdcard_app_cmd(uint32_t idx, uint32_t arg);
+static void sdcard_dma_start(void *buf, bool to_card);
+static void sdcard_data_start(uint32_t len, bool to_card);
+static uint32_t sdcard_csd_blocks(void);
+
+/*
+ * Identify the card and bring it to the transfer state.
+ */
+extern sdcard_rc_t
+sdcard_init(void)
+{
+    SDIO_InitTypeDef init;
+    uint32_t tries;
+    uint32_t ocr;
+    uint32_t pin;
+    bool v2;
+
+    sd_state = sd_failed;
+    rca = 0;
+
+    /*
+     * The SDIO interrupt tracks the transfer, so the stream's own
+     * interrupt is not needed.
+     */
+    if (!dma_claimed) {
+        if (dma_claim(SD_DMA, SD_DMA_CHAN, NULL, NULL) != dma_ok) {
+            return sdcard_error;
+        }
+        dma_claimed = true;
+    }
+
+    RCC->APB2ENR |= RCC_APB2ENR_SDIOEN;
+    clk_pll48_enable();
+
+    for (pin = PIN8; pin <= PIN12; pin++) {
+        iox_configure_pin(iox_port_c, pin, iox_mode_af, iox_type_pp,
+                iox_speed_high, (pin == PIN12) ? iox_pupd_none : iox_pupd_up);
+        iox_alternate_func(iox_port_c, pin, AF12);
+    }
+    iox_configure_pin(iox_port_d, PIN2, iox_mode_af, iox_type_pp,
+            iox_speed_high, iox_pupd_up);
+    iox_alternate_func(iox_port_d, PIN2, AF12);
+
+    init.SDIO_ClockEdge = SDIO_ClockEdge_Rising;
+    init.SDIO_ClockBypass = SDIO_ClockBypass_Disable;
+    init.SDIO_ClockPowerSave = SDIO_ClockPowerSave_Disable;
+    init.SDIO_BusWide = SDIO_BusWide_1b;
+    init.SDIO_HardwareFlowControl = SDIO_HardwareFlowControl_Enable;
+    init.SDIO_ClockDiv = SDCARD_CLKDIV;
+    SDIO_Init(&init);
+    SDIO_SetPowerState(SDIO_PowerState_ON);
+    SDIO_ClockCmd(ENABLE);
+
+    (void) sdcard_cmd(CMD_GO_IDLE, 0, SDIO_Response_No);
+
+    /*
+     * Only version 2.0 cards answer CMD8; those may be high capacity.
+     */
+    v2 = sdcard_cmd(CMD_SEND_IF_COND, 0x1AA, SDIO_Response_Short)
+        && (SDIO->RESP1 & 0xFFFu) == 0x1AA;
+
+    tries = OP_COND_TRIES;
+    do {
+        if (!sdcard_app_cmd(ACMD_SEND_OP_COND,
+                OCR_BUSY | OCR_VOLTAGE | (v2 ? OCR_CCS : 0))) {
+            return sdcard_error;
+        }
+        ocr = SDIO->RESP1;
+    } while ((ocr & OCR_BUSY) == 0 && --tries);
+
+    if ((ocr & OCR_BUSY) == 0) {
+        return sdcard_error;
+    }
+    high_capacity = (ocr & OCR_CCS) != 0;
+
+    if (!sdcard_cmd(CMD_ALL_SEND_CID, 0, SDIO_Response_Long) ||
+        !sdcard_cmd(CMD_SEND_REL_ADDR, 0, SDIO_Response_Short)) {
+        return sdcard_error;
+    }
+    rca = SDIO->RESP1 >> 16;
+
+    if (!sdcard_cmd(CMD_SEND_CSD, rca << 16, SDIO_Response_Long)) {
+        return sdcard_error;
+    }
+    nblocks = sdcard_csd_blocks();
+
+    if (!sdcard_cmd(CMD_SELECT, rca << 16, SDIO_Response_Short)) {
+        return sdcard_error;
+    }
+    if (!high_capacity &&
+        !sdcard_cmd(CMD_SET_BLOCKLEN, SDCARD_BLOCK_SIZE, SDIO_Response_Short)) {
+        return sdcard_error;
+    }
+
+    /*
+     * Switch card then host to the 4-bit bus.
+     */
+    if (!sdcard_app_cmd(ACMD_SET_BUS_WIDTH, 2u)) {
+        return sdcard_error;
+    }
+    SDIO->CLKCR = (SDIO->CLKCR & ~SDIO_CLKCR_WIDBUS) | SDIO_BusWide_4b;
+
+    utl_enable_irq(SDIO_IRQn);
+    sd_state = sd_idle;
+
+    return sdcard_ok;
+}
+
+extern uint32_t
+sdcard_blocks(void)
+{
+    return nblocks;
+}
+
+/*
+ * Start a multi-block write.
+ */
+extern sdcard_rc_t
+sdcard_write(uint32_t block, void const *buf, uint32_t count)
+{
+    sdcard_rc_t rc;
+
+    rc = sdcard_status();
+    if (rc != sdcard_ok) {
+        return rc;
+    }
+
+    if (!sdcard_app_cmd(ACMD_SET_WR_ERASE, count)) {
+        return sdcard_error;
+    }
+
+    SDIO->DCTRL = 0;
+    sdcard_dma_start((void *) buf, true);
+
+    if (!sdcard_cmd(CMD_WRITE_MULTI,
+            high_capacity ? block : block * SDCARD_BLOCK_SIZE,
+            SDIO_Response_Short)) {
+        dma_stop(SD_DMA);
+        return sdcard_error;
+    }
+
+    sd_state = sd_writing;
+    sdcard_data_start(count * SDCARD_BLOCK_SIZE, true);
+    SDIO->MASK = SDIO_MASK_DATAENDIE | STA_DATA_ERRORS;
+
+    return sdcard_ok;
+}
+
+/*
+ * Blocking single block read, used for the directory.
+ */
+extern sdcard_rc_t
+sdcard_read(uint32_t block, void *buf)
+{
+    sdcard_rc_t rc;
+    uint32_t sta;
+
+    rc = sdcard_status();
+    if (rc != sdcard_ok) {
+        return rc;
+    }
+
+    SDIO->DCTRL = 0;
+    sdcard_dma_start(buf, false);
+    sdcard_data_start(SDCARD_BLOCK_SIZE, false);
+
+    if (!sdcard_cmd(CMD_READ_SINGLE,
+            high_capacity ? block : block * SDCARD_BLOCK_SIZE,
+            SDIO_Response_Short)) {
+        dma_stop(SD_DMA);
+        return sdcard_error;
+    }
+
+    do {
+        sta = SDIO->STA;
+    } while ((sta & (SDIO_STA_DATAEND | STA_DATA_ERRORS)) == 0);
+    SDIO->ICR = SDIO_STA_DATAEND | STA_DATA_ERRORS | SDIO_ICR_DBCKENDC;
+
+    /*
+     * The DMA FIFO drains after the SDIO has finished.
+     */
+    while ((dma_stream(SD_DMA)->CR & DMA_SxCR_EN) != 0);
+
+    return (sta & STA_DATA_ERRORS) ? sdcard_error : sdcard_ok;
+}
+
+extern sdcard_rc_t
+sdcard_status(void)
+{
+    switch (sd_state) {
+    case sd_idle:
+        return sdcard_ok;
+
+    case sd_writing:
+        return sdcard_busy;
+
+    case sd_programming:
+        if (!sdcard_cmd(CMD_SEND_STATUS, rca << 16, SDIO_Response_Short)) {
+            sd_state = sd_failed;
+            return sdcard_error;
+        }
+        if (R1_STATE(SDIO->RESP1) != R1_STATE_TRAN) {
+            return sdcard_busy;
+        }
+        sd_state = sd_idle;
+        return sdcard_ok;
+
+    default:
+        return sdcard_error;
+    }
+}
+
+/*
+ * End of the data phase of a write: stop the card and let it program.
+ */
+extern void
+sdcard_irq(void)
+{
+    uint32_t sta;
+
+    sta = SDIO->STA;
+    SDIO->MASK = 0;
+    SDIO->ICR = SDIO_STA_DATAEND | STA_DATA_ERRORS | SDIO_ICR_DBCKENDC;
+    SDIO->DCTRL = 0;
+
+    if (!sdcard_cmd(CMD_STOP, 0, SDIO_Response_Short) ||
+        (sta & STA_DATA_ERRORS) != 0) {
+        sd_state = sd_failed;
+    }
+    else {
+        sd_state = sd_programming;
+    }
+}
+
+/*
+ * Send a command and wait for the response.
+ */
+static bool
+sdcard_cmd(uint32_t idx, uint32_t arg, uint32_t resp)
+{
+    SDIO_CmdInitTypeDef cmd;
+    uint32_t timeout = CMD_TIMEOUT;
+    uint32_t sta;
+
+    SDIO->ICR = STA_CMD_DONE;
+
+    cmd.SDIO_Argument = arg;
+    cmd.SDIO_CmdIndex = idx;
+    cmd.SDIO_Response = resp;
+    cmd.SDIO_Wait = SDIO_Wait_No;
+    cmd.SDIO_CPSM = SDIO_CPSM_Enable;
+    SDIO_SendCommand(&cmd);
+
+    do {
+        sta = SDIO->STA;
+        if (timeout-- == 0) {
+            return false;
+        }
+    } while ((sta & STA_CMD_DONE) == 0);
+
+    SDIO->ICR = STA_CMD_DONE;
+
+    if (resp == SDIO_Response_No) {
+        return (sta & SDIO_STA_CMDSENT) != 0;
+    }
+    if (sta & SDIO_STA_CTIMEOUT) {
+        return false;
+    }
+    if (sta & SDIO_STA_CCRCFAIL) {
+        /* R3 (OCR) carries no CRC */
+        return idx == ACMD_SEND_OP_COND;
+    }
+    if (resp == SDIO_Response_Short && idx != CMD_SEND_IF_COND &&
+        idx != CMD_SEND_REL_ADDR && (SDIO->RESP1 & R1_ERRORS) != 0) {
+        return false;
+    }
+
+    return true;
+}
+
+static bool
+sdcard_app_cmd(uint32_t idx, uint32_t arg)
+{
+    return sdcard_cmd(CMD_APP, rca << 16, SDIO_Response_Short)
+        && sdcard_cmd(idx, arg, SDIO_Response_Short);
+}
+
+/*
+ * Peripheral flow controlled, word wide, 4-beat bursts through the FIFO.
+ */
+static void
+sdcard_dma_start(void *buf, bool to_card)
+{
+    DMA_Stream_TypeDef cfg;
+
+    cfg.PAR = (uint32_t) &SDIO->FIFO;
+    cfg.M0AR = (uint32_t) buf;
+    cfg.M1AR = 0;
+    cfg.NDTR = 0;
+    cfg.FCR = DMA_SxFCR_DMDIS | DMA_SxFCR_FTH;
+    cfg.CR = (1u << DMA_CR_MBURST_Pos)
+        | (1u << DMA_CR_PBURST_Pos)
+        | (3u << DMA_CR_PL_Pos)
+        | (2u << DMA_CR_MSIZE_Pos)
+        | (2u << DMA_CR_PSIZE_Pos)
+        | (1u << DMA_CR_MINC_Pos)
+        | ((to_card ? 1u : 0u) << DMA_CR_DIR_Pos)
+        | (1u << DMA_CR_PFCTRL_Pos);
+    dma_configure(SD_DMA, &cfg);
+    dma_start(SD_DMA);
+}
+
+static void
+sdcard_data_start(uint32_t len, bool to_card)
+{
+    SDIO_DataInitTypeDef data;
+
+    SDIO_DMACmd(ENABLE);
+
+    data.SDIO_DataTimeOut = DATA_TIMEOUT;
+    data.SDIO_DataLength = len;
+    data.SDIO_DataBlockSize = SDIO_DataBlockSize_512b;
+    data.SDIO_TransferDir = to_card ? SDIO_TransferDir_ToCard
+                                    : SDIO_TransferDir_ToSDIO;
+    data.SDIO_TransferMode = SDIO_TransferMode_Block;
+    data.SDIO_DPSM = SDIO_DPSM_Enable;
+    SDIO_DataConfig(&data);
+}
+
+/*
+ * Card size from the CSD held in RESP1-4 (bits 127:0).
+ */
+static uint32_t
+sdcard_csd_blocks(void)
+{
+    uint32_t r1 = SDIO->RESP1;
+    uint32_t r2 = SDIO->RESP2;
+    uint32_t r3 = SDIO->RESP3;
+    uint32_t c_size;
+    uint32_t mult;
+    uint32_t bl_len;
+
+    if ((r1 >> 30) == 1u) {
+        /* CSD 2.0: C_SIZE[69:48], units of 512KB */
+        c_size = ((r2 & 0x3Fu) << 16) | (r3 >> 16);
+        return (c_size + 1u) * 1024u;
+    }
+
+    /* CSD 1.0: (C_SIZE + 1) * 2^(C_SIZE_MULT + 2) * 2^READ_BL_LEN bytes */
+    bl_len = (r2 >> 16) & 0x0Fu;
+    c_size = ((r2 & 0x3FFu) << 2) | (r3 >> 30);
+    mult = (r3 >> 15) & 0x07u;
+    return ((c_size + 1u) << (mult + 2u + bl_len)) / SDCARD_BLOCK_SIZE;
+}
@@ -0,0 +1,261 @@
+/**
+ ******************************************************************************
+ * @file    sdlog.c
+ * @author  Joe Todd
+ * @version
+ * @date    October 2026
+ * @brief   Autogrow
+ *          Stream continuous ADC capture to the microSD card.
+ *
+ * The ADC runs into a double-buffered staging area on DMA. Each time a
+ * half fills, the interrupt marks it ready and the main loop hands it to
+ * the card as one multi-block write, while the ADC carries on into the
+ * other half. See sdlog.h for the card layout and the timing budget.
+ ******************************************************************************/
+#include "sdlog.h"
+#include "string.h"
+
+#define SDLOG_MAGIC         0x474f4c44u     /* "DLOG" */
+#define SDLOG_VERSION       1u
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t count;
+    uint32_t sample_rate;
+    sdlog_session_t session[SDLOG_MAX_SESSIONS];
+} sdlog_dir_t;
+
+static sdlog_dir_t dir;
+static uint16_t staging[2][SDLOG_HALF_SAMPLES] __attribute__((aligned(4)));
+
+static sdlog_session_t *cur;
+static bool running;
+static bool writing;
+static uint32_t next;                       /* half to write next */
+static volatile uint8_t ready[2];
+
+static void sdlog_half_done(uint32_t half);
+static sdcard_rc_t sdlog_write_wait(uint32_t block, void const *buf,
+                                    uint32_t count);
+
+/*
+ * Bring up the card and load the directory.
+ */
+extern sdcard_rc_t
+sdlog_init(void)
+{
+    sdcard_rc_t rc;
+
+    running = false;
+    cur = NULL;
+
+    rc = sdcard_init();
+    if (rc != sdcard_ok) {
+        return rc;
+    }
+
+    rc = sdcard_read(0, &dir);
+    if (rc != sdcard_ok) {
+        return rc;
+    }
+
+    if (dir.magic != SDLOG_MAGIC || dir.version != SDLOG_VERSION ||
+        dir.count > SDLOG_MAX_SESSIONS) {
+        memset(&dir, 0, sizeof(dir));
+        dir.magic = SDLOG_MAGIC;
+        dir.version = SDLOG_VERSION;
+        dir.sample_rate = SDLOG_SAMPLE_RATE;
+        rc = sdlog_write_wait(0, &dir, 1);
+    }
+    if (dir.count != 0) {
+        cur = &dir.session[dir.count - 1];
+    }
+
+    return rc;
+}
+
+/*
+ * Reserve an extent after the last session and start capturing into it.
+ */
+extern sdcard_rc_t
+sdlog_start(uint32_t blocks)
+{
+    sdlog_session_t *s;
+    uint32_t start = 1;
+    sdcard_rc_t rc;
+
+    if (running || dir.count == SDLOG_MAX_SESSIONS) {
+        return sdcard_error;
+    }
+
+    if (cur != NULL) {
+        start = cur->start +
+            ((cur->blocks == SDLOG_OPEN) ? cur->reserved : cur->blocks);
+    }
+    if (start + SDLOG_HALF_BLOCKS > sdcard_blocks()) {
+        return sdcard_error;
+    }
+    if (blocks == 0 || start + blocks > sdcard_blocks()) {
+        blocks = sdcard_blocks() - start;
+    }
+
+    s = &dir.session[dir.count];
+    s->start = start;
+    s->reserved = blocks;
+    s->blocks = SDLOG_OPEN;
+    s->overruns = 0;
+    dir.count++;
+
+    rc = sdlog_write_wait(0, &dir, 1);
+    if (rc != sdcard_ok) {
+        dir.count--;
+        return rc;
+    }
+
+    cur = s;
+    cur->blocks = 0;            /* running count, written back on stop */
+    next = 0;
+    ready[0] = 0;
+    ready[1] = 0;
+    writing = false;
+    running = true;
+
+    if (!adc_capture_start(&staging[0][0], 2u * SDLOG_HALF_SAMPLES,
+                           sdlog_half_done)) {
+        /*
+         * Close the session empty.
+         */
+        running = false;
+        (void) sdlog_write_wait(0, &dir, 1);
+        return sdcard_error;
+    }
+
+    return sdcard_ok;
+}
+
+/*
+ * Keep the card busy with whichever half is ready.
+ */
+extern bool
+sdlog_service(void)
+{
+    sdcard_rc_t rc;
+
+    if (!running) {
+        return false;
+    }
+
+    rc = sdcard_status();
+    if (rc == sdcard_busy) {
+        return true;
+    }
+
+    if (writing) {
+        /*
+         * Only now may the ADC reuse this half.
+         */
+        writing = false;
+        ready[next] = 0;
+        next ^= 1u;
+        if (rc != sdcard_ok) {
+            sdlog_stop();
+            return false;
+        }
+    }
+
+    if (ready[next]) {
+        if (cur->blocks + SDLOG_HALF_BLOCKS > cur->reserved) {
+            sdlog_stop();
+            return false;
+        }
+        if (sdcard_write(cur->start + cur->blocks, staging[next],
+                         SDLOG_HALF_BLOCKS) != sdcard_ok) {
+            sdlog_stop();
+            return false;
+        }
+        cur->blocks += SDLOG_HALF_BLOCKS;
+        writing = true;
+    }
+
+    return true;
+}
+
+/*
+ * Stop capture and flush: a half that is already full, then the complete
+ * blocks of the half that was being filled.
+ */
+extern void
+sdlog_stop(void)
+{
+    uint32_t pos;
+    uint32_t count;
+
+    if (!running) {
+        return;
+    }
+    running = false;
+
+    pos = adc_capture_pos(2u * SDLOG_HALF_SAMPLES);
+    adc_capture_stop();
+
+    while (sdcard_status() == sdcard_busy);
+    if (writing) {
+        writing = false;
+        ready[next] = 0;
+        next ^= 1u;
+    }
+
+    if (ready[next] && cur->blocks + SDLOG_HALF_BLOCKS <= cur->reserved &&
+        sdlog_write_wait(cur->start + cur->blocks, staging[next],
+                         SDLOG_HALF_BLOCKS) == sdcard_ok) {
+        cur->blocks += SDLOG_HALF_BLOCKS;
+        ready[next] = 0;
+        next ^= 1u;
+    }
+
+    count = ((pos % SDLOG_HALF_SAMPLES) * 2u) / SDCARD_BLOCK_SIZE;
+    if (!ready[next] && count != 0 && (pos / SDLOG_HALF_SAMPLES) == next &&
+        cur->blocks + count <= cur->reserved &&
+        sdlog_write_wait(cur->start + cur->blocks, staging[next],
+                         count) == sdcard_ok) {
+        cur->blocks += count;
+    }
+
+    (void) sdlog_write_wait(0, &dir, 1);
+}
+
+extern sdlog_session_t const *
+sdlog_session(void)
+{
+    return cur;
+}
+
+/*
+ * DMA interrupt: a half has filled. If it is still marked ready, the card
+ * has not taken the previous lap yet and that data has been overwritten.
+ */
+static void
+sdlog_half_done(uint32_t half)
+{
+    if (ready[half]) {
+        cur->overruns++;
+    }
+    ready[half] = 1;
+}
+
+static sdcard_rc_t
+sdlog_write_wait(uint32_t block, void const *buf, uint32_t count)
+{
+    sdcard_rc_t rc;
+
+    rc = sdcard_write(block, buf, count);
+    if (rc != sdcard_ok) {
+        return rc;
+    }
+    do {
+        rc = sdcard_status();
+    } while (rc == sdcard_busy);
+
+    return rc;
+}
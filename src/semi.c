@@ -0,0 +1,61 @@
+/**
+ ******************************************************************************
+ * @file    semi.c
+ * @author  Joe Todd
+ * @version
+ * @date    October 2026
+ * @brief   Autogrow
+ *          ARM semihosting calls.
+ *
+ ******************************************************************************/
+#include "semi.h"
+
+#define SEMI_SYS_WRITE0     0x04u
+#define SEMI_SYS_EXIT       0x18u
+#define SEMI_EXIT_OK        0x20026u    /* ADP_Stopped_ApplicationExit */
+#define SEMI_EXIT_ERROR     0x20023u    /* ADP_Stopped_RunTimeErrorUnknown */
+
+static uint32_t semi_call(uint32_t op, void const *arg);
+
+extern void
+semi_puts(char const *s)
+{
+    (void) semi_call(SEMI_SYS_WRITE0, s);
+}
+
+extern void
+semi_putu(uint32_t v)
+{
+    char buf[11];
+    char *p = &buf[sizeof(buf) - 1u];
+
+    *p = '\0';
+    do {
+        *--p = (char) ('0' + v % 10u);
+        v /= 10u;
+    } while (v != 0);
+    semi_puts(p);
+}
+
+extern void
+semi_exit(bool ok)
+{
+    (void) semi_call(SEMI_SYS_EXIT,
+                     (void const *) (ok ? SEMI_EXIT_OK : SEMI_EXIT_ERROR));
+    for (;;) {
+    }
+}
+
+/*
+ * Operation in r0, argument in r1, result back in r0.
+ */
+static uint32_t
+semi_call(uint32_t op, void const *arg)
+{
+    register uint32_t r0 __asm__("r0") = op;
+    register void const *r1 __asm__("r1") = arg;
+
+    __asm__ volatile ("bkpt 0xAB" : "+r" (r0) : "r" (r1) : "memory");
+
+    return r0;
+}
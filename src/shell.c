@@ -0,0 +1,617 @@
+/**
+ ******************************************************************************
+ * @file    shell.c
+ * @author  Joe Todd
+ * @version
+ * @date    October 2026
+ * @brief   Autogrow
+ *          Command interpreter on the UART receive path.
+ *
+ * Runs from the event loop only, on evt_shell, which the receive interrupt
+ * posts for each frame and the reply posts once it has gone. A received
+ * frame is copied out of the receive ring into a line buffer, split into
+ * words in place and looked up in a table of commands. The reply is built
+ * in a static buffer and queued on the UART; while it is still going out,
+ * further commands wait in the receive ring rather than the shell waiting
+ * for the UART.
+ ******************************************************************************/
+#include "shell.h"
+#include "string.h"
+
+typedef struct {
+    char const *name;
+    uint8_t min_args;
+    bool (*fn) (uint32_t argc, char *argv[]);
+    char const *help;
+} shell_cmd_t;
+
+static bool shell_help(uint32_t argc, char *argv[]);
+static bool shell_get(uint32_t argc, char *argv[]);
+static bool shell_set(uint32_t argc, char *argv[]);
+static bool shell_save(uint32_t argc, char *argv[]);
+static bool shell_defaults(uint32_t argc, char *argv[]);
+static bool shell_sample(uint32_t argc, char *argv[]);
+static bool shell_water(uint32_t argc, char *argv[]);
+static bool shell_stats(uint32_t argc, char *argv[]);
+static bool shell_bench(uint32_t argc, char *argv[]);
+static bool shell_fault(uint32_t argc, char *argv[]);
+static bool shell_irq(uint32_t argc, char *argv[]);
+static bool shell_hist(uint32_t argc, char *argv[]);
+
+static shell_cmd_t const commands[] = {
+    {"help",     1, shell_help,     "list commands"},
+    {"get",      1, shell_get,      "[name]"},
+    {"set",      3, shell_set,      "<name> <value>"},
+    {"save",     1, shell_save,     "keep parameters over reset"},
+    {"defaults", 1, shell_defaults, "built-in parameters"},
+    {"sample",   1, shell_sample,   "sample now"},
+    {"water",    1, shell_water,    "[pulse [zone]]"},
+    {"stats",    1, shell_stats,    "module counters"},
+    {"bench",    1, shell_bench,    "memcpy/memset cycles, cpu and dma"},
+    {"fault",    1, shell_fault,    "registers saved by the last crash"},
+    {"irq",      1, shell_irq,      "interrupt counts and cycles"},
+    {"hist",     2, shell_hist,     "<zone> [block [first]]"},
+};
+
+#define SHELL_NUM_CMDS      (sizeof(commands) / sizeof(commands[0]))
+
+static char line[SHELL_LINE];
+static char out[SHELL_OUT];
+static uint32_t out_len;
+static uart_tx_desc_t out_desc;
+static volatile bool out_busy;
+
+static shell_req_t request;
+static uint32_t request_arg;
+
+static uint8_t bench_src[SHELL_BENCH_MAX] __attribute__((aligned(16)));
+static uint8_t bench_dst[SHELL_BENCH_MAX] __attribute__((aligned(16)));
+static volatile uint32_t bench_end;
+
+static ts_sample_t hist[SHELL_HIST_MAX];
+
+static void shell_exec(char *s);
+static void shell_puts(char const *s);
+static void shell_putu(uint32_t u);
+static void shell_put_stat(char const *name, uint32_t u);
+static void shell_puthex(uint32_t u);
+static void shell_put_hex(char const *name, uint32_t u);
+static bool shell_atou(char const *s, uint32_t *u);
+static void shell_out_done(void *arg);
+static void shell_bench_done(bool ok, void *arg);
+
+extern void
+shell_poll(void)
+{
+    uart_frame_t frame;
+    uint32_t n;
+    uint32_t i;
+
+    while (!out_busy && uart_frame_get(&frame)) {
+        /*
+         * Copy the command out so the ring space can go straight back.
+         */
+        n = 0;
+        for (i = 0; i < frame.total && n < SHELL_LINE - 1u; i++) {
+            line[n++] = (i < frame.len[0]) ?
+                (char) frame.seg[0][i] : (char) frame.seg[1][i - frame.len[0]];
+        }
+        line[n] = '\0';
+        out_len = 0;
+
+        if (!uart_frame_release()) {
+            shell_puts("err overrun\r\n");
+        }
+        else if (frame.total >= SHELL_LINE) {
+            shell_puts("err too long\r\n");
+        }
+        else {
+            shell_exec(line);
+        }
+
+        if (out_len != 0) {
+            out_busy = true;
+            out_desc.buf = (uint8_t const *) out;
+            out_desc.len = out_len;
+            out_desc.done = shell_out_done;
+            out_desc.arg = NULL;
+            uart_tx_submit(&out_desc);
+        }
+    }
+}
+
+extern bool
+shell_pending(void)
+{
+    uart_frame_t frame;
+
+    return request != shell_req_none || uart_frame_get(&frame);
+}
+
+extern shell_req_t
+shell_take_request(uint32_t *arg)
+{
+    shell_req_t req = request;
+
+    *arg = request_arg;
+    request = shell_req_none;
+
+    return req;
+}
+
+/*
+ * Split into words and run the matching command.
+ */
+static void
+shell_exec(char *s)
+{
+    char *argv[SHELL_ARGS];
+    uint32_t argc = 0;
+    uint32_t i;
+
+    while (*s != '\0' && argc < SHELL_ARGS) {
+        while (*s == ' ' || *s == '\t' || *s == '\r' || *s == '\n') {
+            *s++ = '\0';
+        }
+        if (*s == '\0') {
+            break;
+        }
+        argv[argc++] = s;
+        while (*s != '\0' && *s != ' ' && *s != '\t' &&
+               *s != '\r' && *s != '\n') {
+            s++;
+        }
+    }
+    if (argc == 0) {
+        return;
+    }
+    if (*s != '\0') {
+        *s = '\0';              /* ignore anything past SHELL_ARGS words */
+    }
+
+    for (i = 0; i < SHELL_NUM_CMDS; i++) {
+        if (strcmp(argv[0], commands[i].name) == 0) {
+            break;
+        }
+    }
+    if (i == SHELL_NUM_CMDS) {
+        shell_puts("err unknown\r\n");
+    }
+    else if (argc < commands[i].min_args) {
+        shell_puts("err usage: ");
+        shell_puts(commands[i].name);
+        shell_puts(" ");
+        shell_puts(commands[i].help);
+        shell_puts("\r\n");
+    }
+    else {
+        shell_puts(commands[i].fn(argc, argv) ? "ok\r\n" : "err\r\n");
+    }
+}
+
+static bool
+shell_help(uint32_t argc, char *argv[])
+{
+    uint32_t i;
+
+    for (i = 0; i < SHELL_NUM_CMDS; i++) {
+        shell_puts(commands[i].name);
+        shell_puts(" ");
+        shell_puts(commands[i].help);
+        shell_puts("\r\n");
+    }
+
+    return true;
+}
+
+static bool
+shell_get(uint32_t argc, char *argv[])
+{
+    uint32_t value;
+    uint32_t i;
+
+    if (argc > 1) {
+        if (!param_get(argv[1], &value)) {
+            return false;
+        }
+        shell_put_stat(argv[1], value);
+        return true;
+    }
+
+    for (i = 0; i < param_count(); i++) {
+        (void) param_get(param_name(i), &value);
+        shell_put_stat(param_name(i), value);
+    }
+
+    return true;
+}
+
+static bool
+shell_set(uint32_t argc, char *argv[])
+{
+    uint32_t value;
+
+    return shell_atou(argv[2], &value) && param_set(argv[1], value);
+}
+
+static bool
+shell_save(uint32_t argc, char *argv[])
+{
+    return param_save();
+}
+
+static bool
+shell_defaults(uint32_t argc, char *argv[])
+{
+    param_defaults();
+
+    return true;
+}
+
+static bool
+shell_sample(uint32_t argc, char *argv[])
+{
+    request = shell_req_sample;
+    request_arg = 0;
+
+    return true;
+}
+
+static bool
+shell_water(uint32_t argc, char *argv[])
+{
+    uint32_t pulse = param.valve_pulse;
+    uint32_t zone = 0;
+
+    if (argc > 1 && (!shell_atou(argv[1], &pulse) || pulse == 0 ||
+                     pulse > 60)) {
+        return false;
+    }
+    if (argc > 2 && (!shell_atou(argv[2], &zone) || zone >= zone_count())) {
+        return false;
+    }
+    request = shell_req_water;
+    request_arg = pulse | (zone << 8);
+
+    return true;
+}
+
+static bool
+shell_stats(uint32_t argc, char *argv[])
+{
+    slog_stats_t s;
+    flog_stats_t f;
+    dma_stats_t d;
+    evt_stats_t e;
+    wdg_reset_t r;
+    uint32_t dma_errors = 0;
+    uint32_t evt_max = 0;
+    uint32_t i;
+
+    slog_get_stats(&s);
+    flog_get_stats(&f);
+    for (i = 0; i < DMA_STREAMS; i++) {
+        dma_get_stats(i, &d);
+        dma_errors += d.errors;
+    }
+    for (i = 0; i < EVT_NUM; i++) {
+        evt_get_stats((evt_id_t) i, &e);
+        if (e.max_cycles > evt_max) {
+            evt_max = e.max_cycles;
+        }
+    }
+
+    shell_put_stat("uptime", main_stats.uptime);
+    shell_put_stat("samples", main_stats.samples);
+    shell_put_stat("waterings", main_stats.waterings);
+    shell_put_stat("moisture", main_stats.moisture);
+    shell_put_stat("slog_appended", s.appended);
+    shell_put_stat("slog_dropped", s.dropped);
+    shell_put_stat("slog_erase_full", s.erase_full);
+    shell_put_stat("slog_programs", s.programs);
+    shell_put_stat("slog_erases", s.erases);
+    shell_put_stat("flog_appended", f.appended);
+    shell_put_stat("flog_dropped", f.dropped);
+    shell_put_stat("flog_erases", f.erases);
+    shell_put_stat("flog_errors", f.errors);
+    shell_put_stat("telem_dropped", telem_dropped());
+    shell_put_stat("telem_high", telem_frames_high());
+    shell_put_stat("uart_rx_dropped", uart_rx_dropped());
+    shell_put_stat("dma_errors", dma_errors);
+    shell_put_stat("dma_conflicts", dma_conflicts());
+    shell_put_stat("evt_max_cycles", evt_max);
+    wdg_last_reset(&r);
+    shell_put_stat("reset_flags", r.flags >> 24);
+    shell_put_stat("reset_task", r.task);
+
+    return true;
+}
+
+/*
+ * The record the last crash left, as saved: frame, status registers, then
+ * the words above the frame four to a line.
+ */
+static bool
+shell_fault(uint32_t argc, char *argv[])
+{
+    fault_rec_t const *f = fault_last();
+    uint32_t i;
+
+    if (f == NULL) {
+        return false;
+    }
+
+    shell_put_stat("count", f->count);
+    shell_put_stat("type", f->type);
+    shell_put_hex("pc", f->pc);
+    shell_put_hex("lr", f->lr);
+    shell_put_hex("psr", f->psr);
+    shell_put_hex("sp", f->sp);
+    shell_put_hex("exc_return", f->exc_return);
+    shell_put_hex("r0", f->r0);
+    shell_put_hex("r1", f->r1);
+    shell_put_hex("r2", f->r2);
+    shell_put_hex("r3", f->r3);
+    shell_put_hex("r12", f->r12);
+    shell_put_hex("cfsr", f->cfsr);
+    shell_put_hex("hfsr", f->hfsr);
+    shell_put_hex("mmfar", f->mmfar);
+    shell_put_hex("bfar", f->bfar);
+    for (i = 0; i < FAULT_STACK_WORDS; i++) {
+        shell_puts((i % 4u == 0) ? "stack " : " ");
+        shell_puthex(f->stack[i]);
+        if (i % 4u == 3u) {
+            shell_puts("\r\n");
+        }
+    }
+
+    return true;
+}
+
+/*
+ * One line per interrupt that has fired, times in core cycles.
+ */
+static bool
+shell_irq(uint32_t argc, char *argv[])
+{
+    it_stats_t s;
+    uint32_t i;
+
+    shell_puts("irq count max total max_wait total_wait\r\n");
+    for (i = 0; i < IT_NUM; i++) {
+        it_get_stats((it_id_t) i, &s);
+        if (s.count == 0) {
+            continue;
+        }
+        shell_puts(it_name((it_id_t) i));
+        shell_puts(" ");
+        shell_putu(s.count);
+        shell_puts(" ");
+        shell_putu(s.max_cycles);
+        shell_puts(" ");
+        shell_putu(s.total_cycles);
+        shell_puts(" ");
+        shell_putu(s.max_latency);
+        shell_puts(" ");
+        shell_putu(s.total_latency);
+        shell_puts("\r\n");
+    }
+
+    return true;
+}
+
+/*
+ * Up to SHELL_HIST_MAX readings of one block of a zone's history, after
+ * a line giving the size of the whole series. Block 0 is the oldest; a
+ * block holds more readings than fit in a reply, so 'first' pages
+ * through it.
+ */
+static bool
+shell_hist(uint32_t argc, char *argv[])
+{
+    ts_series_t const *s;
+    uint32_t zone;
+    uint32_t block;
+    uint32_t first = 0;
+    uint32_t n;
+    uint32_t i;
+
+    if (!shell_atou(argv[1], &zone) || zone >= zone_count()) {
+        return false;
+    }
+    s = &zone_get(zone)->history;
+    block = (ts_blocks(s) != 0) ? ts_blocks(s) - 1u : 0;
+    if (argc > 2 && !shell_atou(argv[2], &block)) {
+        return false;
+    }
+    if (argc > 3 && !shell_atou(argv[3], &first)) {
+        return false;
+    }
+
+    shell_put_stat("samples", ts_count(s));
+    shell_put_stat("blocks", ts_blocks(s));
+    n = ts_decode(s, block, first, hist, SHELL_HIST_MAX);
+    for (i = 0; i < n; i++) {
+        shell_putu(hist[i].time);
+        shell_puts(" ");
+        shell_putu(hist[i].value);
+        shell_puts("\r\n");
+    }
+
+    return true;
+}
+
+/*
+ * Time each path over a range of sizes. The DMA figures run from the call
+ * to the completion callback, so they include set-up and the interrupt.
+ */
+static bool
+shell_bench(uint32_t argc, char *argv[])
+{
+    uint32_t crossover;
+    uint32_t start;
+    uint32_t len;
+
+    utl_cycles_init();
+    crossover = dma_mem_crossover(0);
+
+    shell_puts("len cpy_cpu cpy_dma set_cpu set_dma\r\n");
+    for (len = 16; len <= SHELL_BENCH_MAX; len *= 4u) {
+        shell_putu(len);
+
+        start = utl_cycles();
+        memcpy(bench_dst, bench_src, len);
+        shell_puts(" ");
+        shell_putu(utl_cycles() - start);
+
+        start = utl_cycles();
+        if (dma_memcpy(bench_dst, bench_src, len, shell_bench_done,
+                       NULL) != dma_ok) {
+            break;
+        }
+        while (dma_mem_busy());
+        shell_puts(" ");
+        shell_putu(bench_end - start);
+
+        start = utl_cycles();
+        memset(bench_dst, 0x55, len);
+        shell_puts(" ");
+        shell_putu(utl_cycles() - start);
+
+        start = utl_cycles();
+        if (dma_memset(bench_dst, 0x55, len, shell_bench_done,
+                       NULL) != dma_ok) {
+            break;
+        }
+        while (dma_mem_busy());
+        shell_puts(" ");
+        shell_putu(bench_end - start);
+        shell_puts("\r\n");
+    }
+
+    (void) dma_mem_crossover(crossover);
+
+    return len > SHELL_BENCH_MAX;
+}
+
+/*
+ * Reply formatting. Output past the end of the buffer is dropped.
+ */
+static void
+shell_puts(char const *s)
+{
+    while (*s != '\0' && out_len < SHELL_OUT) {
+        out[out_len++] = *s++;
+    }
+}
+
+static void
+shell_putu(uint32_t u)
+{
+    char buf[10];
+    uint32_t n = 0;
+
+    do {
+        buf[n++] = (char) ('0' + u % 10u);
+        u /= 10u;
+    } while (u != 0);
+
+    while (n != 0 && out_len < SHELL_OUT) {
+        out[out_len++] = buf[--n];
+    }
+}
+
+static void
+shell_put_stat(char const *name, uint32_t u)
+{
+    shell_puts(name);
+    shell_puts("=");
+    shell_putu(u);
+    shell_puts("\r\n");
+}
+
+static void
+shell_puthex(uint32_t u)
+{
+    uint32_t i;
+
+    shell_puts("0x");
+    for (i = 0; i < 8u && out_len < SHELL_OUT; i++) {
+        out[out_len++] = "0123456789abcdef"[(u >> (28u - 4u * i)) & 0xFu];
+    }
+}
+
+static void
+shell_put_hex(char const *name, uint32_t u)
+{
+    shell_puts(name);
+    shell_puts("=");
+    shell_puthex(u);
+    shell_puts("\r\n");
+}
+
+/*
+ * Decimal, or hex with a 0x prefix.
+ */
+static bool
+shell_atou(char const *s, uint32_t *u)
+{
+    uint32_t base = 10;
+    uint32_t v = 0;
+    uint32_t d;
+
+    if (s[0] == '0' && (s[1] == 'x' || s[1] == 'X')) {
+        base = 16;
+        s += 2;
+    }
+    if (*s == '\0') {
+        return false;
+    }
+
+    for (; *s != '\0'; s++) {
+        if (*s >= '0' && *s <= '9') {
+            d = (uint32_t) (*s - '0');
+        }
+        else if (base == 16 && *s >= 'a' && *s <= 'f') {
+            d = (uint32_t) (*s - 'a' + 10);
+        }
+        else if (base == 16 && *s >= 'A' && *s <= 'F') {
+            d = (uint32_t) (*s - 'A' + 10);
+        }
+        else {
+            return false;
+        }
+        if (v > (0xFFFFFFFFu - d) / base) {
+            return false;
+        }
+        v = v * base + d;
+    }
+    *u = v;
+
+    return true;
+}
+
+/*
+ * UART interrupt: the reply has gone.
+ */
+static void
+shell_out_done(void *arg)
+{
+    out_busy = false;
+    evt_post(evt_shell);
+}
+
+/*
+ * Receive interrupt: a command frame is waiting.
+ */
+void
+data_recv_callback(uint8_t bytes)
+{
+    evt_post(evt_shell);
+}
+
+static void
+shell_bench_done(bool ok, void *arg)
+{
+    bench_end = utl_cycles();
+}
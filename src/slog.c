@@ -0,0 +1,421 @@
+/**
+ ******************************************************************************
+ * @file    slog.c
+ * @author  Joe Todd
+ * @version
+ * @date    October 2026
+ * @brief   Autogrow
+ *          Append-only sample log on the external SPI NOR flash.
+ *
+ * The chip is used as a circular list of 4KB sectors. Each sector starts
+ * with a header carrying a sequence number and the time of its first
+ * record, followed by 8-byte records. Writing sector N schedules the erase
+ * of sector N+1, so every sector is erased once per lap of the chip and
+ * the erase always happens well before the write pointer gets there.
+ *
+ * Records are gathered into page buffers in RAM and programmed a page at a
+ * time from slog_service(), which only ever starts one flash operation and
+ * returns, so a caller sampling on a timer is never held up by the chip.
+ *
+ * The first-record times of all sectors are kept in RAM and are monotonic
+ * from the oldest sector to the newest, so a time-range query is a binary
+ * search over that index followed by a linear read of the matching sectors.
+ ******************************************************************************/
+#include "slog.h"
+
+#define SLOG_MAGIC          0x474f4c53u     /* "SLOG" */
+#define SLOG_EMPTY          0xFFFFFFFFu
+#define REC_SIZE            sizeof(slog_rec_t)
+#define HDR_SIZE            sizeof(slog_hdr_t)
+#define SLOTS_PER_SECTOR    (SPIFLASH_SECTOR_SIZE / REC_SIZE)
+#define RECS_PER_READ       8u
+#define ERASE_Q             2u      /* sector erases waiting */
+
+typedef struct {
+    uint32_t magic;
+    uint32_t seq;
+    uint32_t first_time;
+    uint32_t check;
+} slog_hdr_t;
+
+typedef struct {
+    uint32_t addr;
+    uint32_t len;
+    uint8_t data[SPIFLASH_PAGE_SIZE];
+} slog_buf_t;
+
+static bool mounted;
+static uint32_t nsect;
+static uint32_t head;                   /* sector being written */
+static uint32_t tail;                   /* oldest sector holding data */
+static uint32_t seq;
+static uint32_t wr;                     /* flash address of next record */
+static uint32_t sector_time[SLOG_MAX_SECTORS];
+
+static slog_buf_t bufs[SLOG_NUM_BUFS];
+static uint32_t buf_prog;               /* oldest buffer awaiting program */
+static uint32_t buf_queued;
+
+static uint32_t erase_q[ERASE_Q];
+static uint32_t erase_cnt;
+
+static slog_stats_t stats;
+
+static uint8_t slog_rec_check(slog_rec_t const *rec);
+static bool slog_slot_erased(uint32_t addr);
+static void slog_schedule_erase(uint32_t sector);
+static void slog_put(slog_buf_t *b, void const *data, uint32_t len);
+
+/*
+ * Mount the log.
+ */
+extern bool
+slog_init(void)
+{
+    slog_hdr_t hdr;
+    uint32_t s;
+    uint32_t lo, hi, mid;
+    uint32_t head_seq = 0;
+    uint32_t tail_seq = SLOG_EMPTY;
+    bool found = false;
+
+    mounted = false;
+    buf_prog = 0;
+    buf_queued = 0;
+    erase_cnt = 0;
+    for (s = 0; s < SLOG_NUM_BUFS; s++) {
+        bufs[s].len = 0;
+    }
+
+    if (!spiflash_init()) {
+        return false;
+    }
+
+    nsect = spiflash_size() / SPIFLASH_SECTOR_SIZE;
+    if (nsect > SLOG_MAX_SECTORS) {
+        nsect = SLOG_MAX_SECTORS;
+    }
+
+    /*
+     * One header read per sector rebuilds the whole index.
+     */
+    for (s = 0; s < nsect; s++) {
+        spiflash_read(s * SPIFLASH_SECTOR_SIZE, &hdr, HDR_SIZE);
+        if (hdr.magic != SLOG_MAGIC ||
+            hdr.check != ~(hdr.magic ^ hdr.seq ^ hdr.first_time)) {
+            sector_time[s] = SLOG_EMPTY;
+            continue;
+        }
+        sector_time[s] = hdr.first_time;
+        if (!found || hdr.seq > head_seq) {
+            head_seq = hdr.seq;
+            head = s;
+        }
+        if (hdr.seq < tail_seq) {
+            tail_seq = hdr.seq;
+            tail = s;
+        }
+        found = true;
+    }
+
+    if (!found) {
+        head = 0;
+        tail = 0;
+        seq = 0;
+        wr = 0;
+        slog_schedule_erase(0);
+    }
+    else {
+        /*
+         * Records are only ever appended, so the programmed slots of the
+         * head sector form a prefix and the end can be found by bisection.
+         */
+        seq = head_seq;
+        lo = HDR_SIZE / REC_SIZE;
+        hi = SLOTS_PER_SECTOR;
+        while (lo < hi) {
+            mid = (lo + hi) / 2;
+            if (slog_slot_erased(head * SPIFLASH_SECTOR_SIZE + mid * REC_SIZE)) {
+                hi = mid;
+            }
+            else {
+                lo = mid + 1;
+            }
+        }
+        wr = head * SPIFLASH_SECTOR_SIZE + lo * REC_SIZE;
+        if (lo == SLOTS_PER_SECTOR) {
+            wr = ((head + 1) % nsect) * SPIFLASH_SECTOR_SIZE;
+        }
+        /*
+         * Whatever comes next may have been caught by a reset mid-erase.
+         */
+        slog_schedule_erase((wr / SPIFLASH_SECTOR_SIZE == head) ?
+                            (head + 1) % nsect : wr / SPIFLASH_SECTOR_SIZE);
+    }
+
+    mounted = true;
+
+    return true;
+}
+
+/*
+ * Append one record to the current page buffer.
+ */
+extern slog_rc_t
+slog_append(uint32_t time, uint8_t zone, slog_type_t type, uint16_t value)
+{
+    slog_buf_t *b;
+    slog_hdr_t hdr;
+    slog_rec_t rec;
+    uint32_t s;
+
+    if (!mounted) {
+        return slog_error;
+    }
+    if (buf_queued == SLOG_NUM_BUFS) {
+        stats.dropped++;
+        return slog_full;
+    }
+    if ((wr % SPIFLASH_SECTOR_SIZE) == 0 && erase_cnt == ERASE_Q) {
+        /*
+         * Entering a new sector queues an erase of the next one. With no
+         * room for it, the writer would reach that sector still holding
+         * last lap's data, so wait for slog_service() to catch up.
+         */
+        stats.dropped++;
+        stats.erase_full++;
+        return slog_full;
+    }
+
+    b = &bufs[(buf_prog + buf_queued) % SLOG_NUM_BUFS];
+
+    if ((wr % SPIFLASH_SECTOR_SIZE) == 0) {
+        /*
+         * Entering a new sector: write its header and erase the one after.
+         */
+        s = wr / SPIFLASH_SECTOR_SIZE;
+        hdr.magic = SLOG_MAGIC;
+        hdr.seq = ++seq;
+        hdr.first_time = time;
+        hdr.check = ~(hdr.magic ^ hdr.seq ^ hdr.first_time);
+        slog_put(b, &hdr, HDR_SIZE);
+        sector_time[s] = time;
+        head = s;
+        if (nsect > 1) {
+            slog_schedule_erase((s + 1) % nsect);
+        }
+    }
+
+    rec.time = time;
+    rec.value = value;
+    rec.tag = (zone << 4) | (type & 0x0F);
+    rec.check = slog_rec_check(&rec);
+    slog_put(b, &rec, REC_SIZE);
+
+    stats.appended++;
+
+    return slog_ok;
+}
+
+extern void
+slog_flush(void)
+{
+    if (buf_queued < SLOG_NUM_BUFS &&
+        bufs[(buf_prog + buf_queued) % SLOG_NUM_BUFS].len != 0) {
+        buf_queued++;
+    }
+}
+
+/*
+ * Start at most one flash operation.
+ */
+extern bool
+slog_service(void)
+{
+    slog_buf_t *b;
+    uint32_t i;
+
+    if (!mounted) {
+        return false;
+    }
+    if (erase_cnt == 0 && buf_queued == 0) {
+        return false;
+    }
+    if (spiflash_busy()) {
+        return true;
+    }
+
+    /*
+     * Erases go first: queued pages may be destined for that sector.
+     */
+    if (erase_cnt != 0) {
+        spiflash_erase_sector(erase_q[0] * SPIFLASH_SECTOR_SIZE);
+        erase_cnt--;
+        for (i = 0; i < erase_cnt; i++) {
+            erase_q[i] = erase_q[i + 1u];
+        }
+        stats.erases++;
+        return true;
+    }
+
+    b = &bufs[buf_prog];
+    spiflash_program(b->addr, b->data, b->len);
+    b->len = 0;
+    buf_prog = (buf_prog + 1) % SLOG_NUM_BUFS;
+    buf_queued--;
+    stats.programs++;
+
+    return true;
+}
+
+/*
+ * Walk the records between two times.
+ */
+extern slog_rc_t
+slog_query(uint32_t from, uint32_t to, slog_query_fn fn, void *arg)
+{
+    slog_rec_t recs[RECS_PER_READ];
+    uint32_t used;
+    uint32_t lo, hi, mid;
+    uint32_t k, s, i, n;
+    uint32_t addr, end;
+
+    if (!mounted) {
+        return slog_error;
+    }
+    if (spiflash_busy()) {
+        return slog_busy;
+    }
+    if (sector_time[head] == SLOG_EMPTY) {
+        return slog_ok;
+    }
+
+    used = ((head + nsect - tail) % nsect) + 1;
+
+    /*
+     * Last sector whose first record is not after 'from'.
+     */
+    lo = 0;
+    hi = used;
+    while (hi - lo > 1) {
+        mid = (lo + hi) / 2;
+        if (sector_time[(tail + mid) % nsect] <= from) {
+            lo = mid;
+        }
+        else {
+            hi = mid;
+        }
+    }
+
+    for (k = lo; k < used; k++) {
+        s = (tail + k) % nsect;
+        if (sector_time[s] > to) {
+            break;
+        }
+        addr = s * SPIFLASH_SECTOR_SIZE + HDR_SIZE;
+        end = (s == head && (wr / SPIFLASH_SECTOR_SIZE) == head) ?
+              wr : (s + 1) * SPIFLASH_SECTOR_SIZE;
+
+        while (addr < end) {
+            n = (end - addr) / REC_SIZE;
+            if (n > RECS_PER_READ) {
+                n = RECS_PER_READ;
+            }
+            spiflash_read(addr, recs, n * REC_SIZE);
+            addr += n * REC_SIZE;
+            for (i = 0; i < n; i++) {
+                if (recs[i].check != slog_rec_check(&recs[i])) {
+                    if (recs[i].tag == 0xFF && recs[i].time == SLOG_EMPTY) {
+                        /* erased: nothing more in this sector */
+                        addr = end;
+                        break;
+                    }
+                    /* torn by a reset */
+                    continue;
+                }
+                if (recs[i].time > to) {
+                    return slog_ok;
+                }
+                if (recs[i].time >= from && !fn(&recs[i], arg)) {
+                    return slog_ok;
+                }
+            }
+        }
+    }
+
+    return slog_ok;
+}
+
+extern void
+slog_get_stats(slog_stats_t *out)
+{
+    *out = stats;
+}
+
+static uint8_t
+slog_rec_check(slog_rec_t const *rec)
+{
+    uint8_t const *p = (uint8_t const *) rec;
+    uint8_t c = 0x5A;
+    uint32_t i;
+
+    for (i = 0; i < REC_SIZE - 1; i++) {
+        c ^= p[i];
+    }
+    return c;
+}
+
+static bool
+slog_slot_erased(uint32_t addr)
+{
+    uint32_t slot[2];
+
+    spiflash_read(addr, slot, sizeof(slot));
+    return slot[0] == 0xFFFFFFFFu && slot[1] == 0xFFFFFFFFu;
+}
+
+/*
+ * Queue a sector erase. The sector drops out of the index straight away;
+ * if it was the oldest, the tail moves on.
+ */
+static void
+slog_schedule_erase(uint32_t sector)
+{
+    if (sector_time[sector] != SLOG_EMPTY) {
+        sector_time[sector] = SLOG_EMPTY;
+        if (sector == tail) {
+            tail = (tail + 1) % nsect;
+        }
+    }
+    if (erase_cnt < ERASE_Q) {
+        erase_q[erase_cnt++] = sector;
+    }
+}
+
+/*
+ * Copy into a page buffer, handing it over for programming once the write
+ * pointer reaches a page boundary.
+ */
+static void
+slog_put(slog_buf_t *b, void const *data, uint32_t len)
+{
+    uint8_t const *p = data;
+
+    if (b->len == 0) {
+        b->addr = wr;
+    }
+    wr += len;
+    while (len--) {
+        b->data[b->len++] = *p++;
+    }
+
+    /*
+     * The next buffer was emptied when it was last programmed.
+     */
+    if ((wr % SPIFLASH_PAGE_SIZE) == 0) {
+        buf_queued++;
+        if (wr == nsect * SPIFLASH_SECTOR_SIZE) {
+            wr = 0;
+        }
+    }
+}
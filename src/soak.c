@@ -0,0 +1,202 @@
+/**
+ ******************************************************************************
+ * @file    soak.c
+ * @author  Joe Todd
+ * @version
+ * @date    October 2026
+ * @brief   Autogrow
+ *          Cycle-and-soak watering state machine.
+ *
+ ******************************************************************************/
+#include "soak.h"
+#include "main.h"
+#include "string.h"
+
+#define SOAK_NONE           0xFFFFFFFFu
+
+typedef enum {
+    soak_idle,
+    soak_wait,          /* for the valve */
+    soak_pulse,         /* valve open */
+    soak_soak,          /* water going in */
+    soak_settle,        /* probe powering up */
+} soak_state_t;
+
+typedef struct {
+    soak_state_t state;
+    bool soak;
+    uint32_t left;      /* seconds still to give */
+    uint32_t given;
+    uint32_t pulse;     /* seconds of the pulse under way */
+    timer_alarm_t alarm;
+} soak_zone_t;
+
+static soak_zone_t zones[ZONE_MAX];
+static uint32_t owner;                  /* zone with the valve open */
+static soak_event_fn event;
+
+static void soak_next(void);
+static void soak_alarm(void *arg);
+static void soak_finish(uint32_t i);
+
+extern void
+soak_init(soak_event_fn fn)
+{
+    memset(zones, 0, sizeof(zones));
+    owner = SOAK_NONE;
+    event = fn;
+}
+
+extern bool
+soak_start(uint32_t zone, uint32_t seconds, bool soak)
+{
+    soak_zone_t *z;
+
+    if (zone >= zone_count() || seconds == 0) {
+        return false;
+    }
+    z = &zones[zone];
+    if (z->state != soak_idle) {
+        return false;
+    }
+
+    z->state = soak_wait;
+    z->soak = soak;
+    z->left = seconds;
+    z->given = 0;
+    soak_next();
+
+    return true;
+}
+
+extern void
+soak_stop(void)
+{
+    uint32_t i;
+
+    for (i = 0; i < ZONE_MAX; i++) {
+        if (zones[i].state == soak_idle) {
+            continue;
+        }
+        timer_alarm_stop(&zones[i].alarm);
+        if (zones[i].state == soak_pulse) {
+            zone_valve(i, false);
+            zones[i].given += zones[i].pulse;   /* near enough */
+            event(i, soak_close, zones[i].pulse);
+        }
+        else if (zones[i].state == soak_settle) {
+            zone_probe(i, false);
+        }
+        soak_finish(i);
+    }
+    owner = SOAK_NONE;
+}
+
+extern bool
+soak_busy(void)
+{
+    uint32_t i;
+
+    for (i = 0; i < ZONE_MAX; i++) {
+        if (zones[i].state != soak_idle) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/*
+ * Give the valve to the first zone waiting for it.
+ */
+static void
+soak_next(void)
+{
+    soak_zone_t *z;
+    uint32_t i;
+
+    if (owner != SOAK_NONE) {
+        return;
+    }
+
+    for (i = 0; i < ZONE_MAX; i++) {
+        z = &zones[i];
+        if (z->state != soak_wait) {
+            continue;
+        }
+
+        z->pulse = z->left;
+        if (z->soak && z->pulse > param.soak_pulse) {
+            z->pulse = param.soak_pulse;
+        }
+        z->left -= z->pulse;
+        z->state = soak_pulse;
+        owner = i;
+
+        event(i, soak_open, z->pulse);
+        zone_valve(i, true);
+        timer_alarm_start(&z->alarm, z->pulse * 1000u, soak_alarm,
+                          (void *) i);
+        return;
+    }
+}
+
+static void
+soak_alarm(void *arg)
+{
+    uint32_t i = (uint32_t) arg;
+    soak_zone_t *z = &zones[i];
+    zone_t const *zone = zone_get(i);
+
+    switch (z->state) {
+    case soak_pulse:
+        zone_valve(i, false);
+        z->given += z->pulse;
+        owner = SOAK_NONE;
+        event(i, soak_close, z->pulse);
+        if (z->left == 0) {
+            soak_finish(i);
+        }
+        else {
+            z->state = soak_soak;
+            timer_alarm_start(&z->alarm, param.soak_time * 1000u,
+                              soak_alarm, arg);
+        }
+        soak_next();
+        break;
+
+    case soak_soak:
+        zone_probe(i, true);
+        z->state = soak_settle;
+        timer_alarm_start(&z->alarm, ZONE_SETTLE_MS, soak_alarm, arg);
+        break;
+
+    case soak_settle:
+        /*
+         * Carry on regardless if the reading fails: the dose is still
+         * capped.
+         */
+        if (zone_read(i, main_stats.uptime)) {
+            event(i, soak_reading, zone->level);
+        }
+        zone_probe(i, false);
+        if (zone->level + param.soak_band <= zone->cfg.setpoint) {
+            soak_finish(i);
+        }
+        else {
+            z->state = soak_wait;
+            soak_next();
+        }
+        break;
+
+    default:
+        break;
+    }
+}
+
+static void
+soak_finish(uint32_t i)
+{
+    zones[i].state = soak_idle;
+    zones[i].left = 0;
+    event(i, soak_done, zones[i].given);
+}
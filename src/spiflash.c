@@ -0,0 +1,180 @@
+/**
+ ******************************************************************************
+ * @file    spiflash.c
+ * @author  Joe Todd
+ * @version
+ * @date    October 2026
+ * @brief   Autogrow
+ *          Polled driver for an external 25-series SPI NOR flash on SPI1.
+ *
+ * Connections
+ *
+ *      SCK  - PA5
+ *      MISO - PA6
+ *      MOSI - PA7
+ *      CS   - PB12
+ *
+ * SPI1 is shared with the on-board L3GD20, so its chip select (PE3) is
+ * held high.
+ ******************************************************************************/
+#include "spiflash.h"
+
+#define FLASH_CS_PORT       iox_port_b
+#define FLASH_CS_PIN        12u
+#define GYRO_CS_PORT        iox_port_e
+#define GYRO_CS_PIN         3u
+
+#define CMD_WRITE_ENABLE    0x06u
+#define CMD_READ_STATUS     0x05u
+#define CMD_PAGE_PROGRAM    0x02u
+#define CMD_READ_DATA       0x03u
+#define CMD_SECTOR_ERASE    0x20u
+#define CMD_JEDEC_ID        0x9Fu
+
+#define STATUS_WIP          0x01u
+
+static uint32_t flash_size;
+
+static uint8_t spiflash_xfer(uint8_t byte);
+static void spiflash_cmd_addr(uint8_t cmd, uint32_t addr);
+static void spiflash_write_enable(void);
+
+/*
+ * Initialise SPI1 and read the JEDEC id.
+ */
+extern bool
+spiflash_init(void)
+{
+    uint8_t manuf;
+    uint8_t cap;
+
+    flash_size = 0;
+
+    RCC->APB2ENR |= RCC_APB2ENR_SPI1EN;
+
+    iox_configure_pin(iox_port_a, PIN5, iox_mode_af,
+            iox_type_pp, iox_speed_fast, iox_pupd_none);
+    iox_configure_pin(iox_port_a, PIN6, iox_mode_af,
+            iox_type_pp, iox_speed_fast, iox_pupd_none);
+    iox_configure_pin(iox_port_a, PIN7, iox_mode_af,
+            iox_type_pp, iox_speed_fast, iox_pupd_none);
+    iox_alternate_func(iox_port_a, PIN5, AF5);
+    iox_alternate_func(iox_port_a, PIN6, AF5);
+    iox_alternate_func(iox_port_a, PIN7, AF5);
+
+    iox_configure_pin(FLASH_CS_PORT, FLASH_CS_PIN, iox_mode_out,
+            iox_type_pp, iox_speed_fast, iox_pupd_up);
+    iox_configure_pin(GYRO_CS_PORT, GYRO_CS_PIN, iox_mode_out,
+            iox_type_pp, iox_speed_low, iox_pupd_up);
+    iox_set_pin_state(FLASH_CS_PORT, FLASH_CS_PIN, true);
+    iox_set_pin_state(GYRO_CS_PORT, GYRO_CS_PIN, true);
+
+    /*
+     * Mode 0, master, software NSS, PCLK2 / 2.
+     */
+    SPI1->CR1 = SPI_CR1_MSTR | SPI_CR1_SSM | SPI_CR1_SSI;
+    SPI1->CR2 = 0;
+    SPI1->CR1 |= SPI_CR1_SPE;
+
+    iox_set_pin_state(FLASH_CS_PORT, FLASH_CS_PIN, false);
+    (void) spiflash_xfer(CMD_JEDEC_ID);
+    manuf = spiflash_xfer(0xFF);
+    (void) spiflash_xfer(0xFF);
+    cap = spiflash_xfer(0xFF);
+    iox_set_pin_state(FLASH_CS_PORT, FLASH_CS_PIN, true);
+
+    if (manuf == 0x00 || manuf == 0xFF || cap < 16u || cap > 31u) {
+        return false;
+    }
+    flash_size = 1u << cap;
+
+    return true;
+}
+
+extern uint32_t
+spiflash_size(void)
+{
+    return flash_size;
+}
+
+extern bool
+spiflash_busy(void)
+{
+    uint8_t status;
+
+    iox_set_pin_state(FLASH_CS_PORT, FLASH_CS_PIN, false);
+    (void) spiflash_xfer(CMD_READ_STATUS);
+    status = spiflash_xfer(0xFF);
+    iox_set_pin_state(FLASH_CS_PORT, FLASH_CS_PIN, true);
+
+    return (status & STATUS_WIP) != 0;
+}
+
+extern void
+spiflash_read(uint32_t addr, void *buf, uint32_t len)
+{
+    uint8_t *p = buf;
+
+    spiflash_cmd_addr(CMD_READ_DATA, addr);
+    while (len--) {
+        *p++ = spiflash_xfer(0xFF);
+    }
+    iox_set_pin_state(FLASH_CS_PORT, FLASH_CS_PIN, true);
+}
+
+extern void
+spiflash_program(uint32_t addr, void const *buf, uint32_t len)
+{
+    uint8_t const *p = buf;
+
+    spiflash_write_enable();
+    spiflash_cmd_addr(CMD_PAGE_PROGRAM, addr);
+    while (len--) {
+        (void) spiflash_xfer(*p++);
+    }
+    /*
+     * Programming starts on the rising edge of CS.
+     */
+    iox_set_pin_state(FLASH_CS_PORT, FLASH_CS_PIN, true);
+}
+
+extern void
+spiflash_erase_sector(uint32_t addr)
+{
+    spiflash_write_enable();
+    spiflash_cmd_addr(CMD_SECTOR_ERASE, addr);
+    iox_set_pin_state(FLASH_CS_PORT, FLASH_CS_PIN, true);
+}
+
+/*
+ * Clock one byte out and one byte in.
+ */
+static uint8_t
+spiflash_xfer(uint8_t byte)
+{
+    while ((SPI1->SR & SPI_SR_TXE) == 0);
+    SPI1->DR = byte;
+    while ((SPI1->SR & SPI_SR_RXNE) == 0);
+    return SPI1->DR;
+}
+
+/*
+ * Assert CS and send a command with a 24-bit address. CS is left low.
+ */
+static void
+spiflash_cmd_addr(uint8_t cmd, uint32_t addr)
+{
+    iox_set_pin_state(FLASH_CS_PORT, FLASH_CS_PIN, false);
+    (void) spiflash_xfer(cmd);
+    (void) spiflash_xfer(addr >> 16);
+    (void) spiflash_xfer(addr >> 8);
+    (void) spiflash_xfer(addr);
+}
+
+static void
+spiflash_write_enable(void)
+{
+    iox_set_pin_state(FLASH_CS_PORT, FLASH_CS_PIN, false);
+    (void) spiflash_xfer(CMD_WRITE_ENABLE);
+    iox_set_pin_state(FLASH_CS_PORT, FLASH_CS_PIN, true);
+}
@@ -101,6 +101,20 @@ stepper_turn_acw(uint16_t turns)
 	}
 }
 
+/*
+ * Drive the coils for one of the half phase states.
+ */
+extern void
+stepper_step(uint32_t state)
+{
+	stepper_st_t const *st = &stepper_st[state % NUM_STATES];
+
+	iox_set_pin_state(ORANGE_PORT, ORANGE_PIN, st->org);
+	iox_set_pin_state(YELLOW_PORT, YELLOW_PIN, st->yel);
+	iox_set_pin_state(PINK_PORT, PINK_PIN, st->pnk);
+	iox_set_pin_state(BLUE_PORT, BLUE_PIN, st->blu);
+}
+
 static void
 stepper_do_turns(stepper_dir_t dir) 
 {
@@ -114,11 +128,7 @@ stepper_do_turns(stepper_dir_t dir)
 		s = ((dir == dir_cw) ? 0 : NUM_STATES - 1);
 
 		for (i = 0; i < NUM_STATES; i++) {
-			iox_set_pin_state(ORANGE_PORT, ORANGE_PIN, stepper_st[s].org);
-			iox_set_pin_state(YELLOW_PORT, YELLOW_PIN, stepper_st[s].yel);
-			iox_set_pin_state(PINK_PORT, PINK_PIN, stepper_st[s].pnk);
-			iox_set_pin_state(BLUE_PORT, BLUE_PIN, stepper_st[s].blu);
-
+			stepper_step(s);
 			timer_delay(1u);
 			(dir == dir_cw) ? s++ : s--;
 		}
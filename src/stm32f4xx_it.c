@@ -1,336 +1,192 @@
 /**
-  ******************************************************************************
-  * @file    stm32f4xx_it.c
-  * @author  MCD Application Team
-  * @version V1.0.0
-  * @date    11-September-2013
-  * @brief   Main Interrupt Service Routines.
-  *          This file provides all exceptions handler and peripherals interrupt
-  *          service routine.
-  ******************************************************************************
-  * @attention
-  *
-  * <h2><center>&copy; COPYRIGHT 2013 STMicroelectronics</center></h2>
-  *
-  * Licensed under MCD-ST Liberty SW License Agreement V2, (the "License");
-  * You may not use this file except in compliance with the License.
-  * You may obtain a copy of the License at:
-  *
-  *        http://www.st.com/software_license_agreement_liberty_v2
-  *
-  * Unless required by applicable law or agreed to in writing, software 
-  * distributed under the License is distributed on an "AS IS" BASIS, 
-  * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
-  * See the License for the specific language governing permissions and
-  * limitations under the License.
-  *
-  ******************************************************************************
-  */ 
-
-/* Includes ------------------------------------------------------------------*/
+ ******************************************************************************
+ * @file    stm32f4xx_it.c
+ * @author  Joe Todd
+ * @version
+ * @date    October 2026
+ * @brief   Autogrow
+ *          Interrupt vectors: dispatch to the drivers and time each run.
+ *
+ * Each vector brackets its driver's service function with it_enter() and
+ * it_exit(). Both look at the NVIC pending bits of the dispatched sources
+ * and stamp any that have just been seen waiting; the stamp is taken off
+ * the entry time when that source comes in.
+ ******************************************************************************/
 #include "stm32f4xx_it.h"
-#include "main.h"
-#include "usb_core.h"
-#include "usbd_core.h"
-#include "stm32f401_discovery.h"
-#include "usbd_hid_core.h"
-
-/** @addtogroup STM32F401-Discovery_Demo
-  * @{
-  */
-
-/* Private typedef -----------------------------------------------------------*/
-/* Private define ------------------------------------------------------------*/
-#define CURSOR_STEP     7
-
-extern uint8_t Buffer_X[6];
-extern uint8_t Buffer_Y[6];
-/* Private macro -------------------------------------------------------------*/
-/* Private variables ---------------------------------------------------------*/
-extern __IO uint8_t DemoEnterCondition;
-uint8_t Counter  = 0x00;
-extern int8_t X_Offset;
-extern int8_t Y_Offset;
-extern __IO uint8_t UserButtonPressed;
-__IO uint8_t TempAcceleration = 0;
-/* Private function prototypes -----------------------------------------------*/
-extern USB_OTG_CORE_HANDLE           USB_OTG_dev;
-static uint8_t *USBD_HID_GetPos (void);
-extern uint32_t USBD_OTG_ISR_Handler (USB_OTG_CORE_HANDLE *pdev);
-
-/******************************************************************************/
-/*            Cortex-M3 Processor Exceptions Handlers                         */
-/******************************************************************************/
-
-/**
-  * @brief   This function handles NMI exception.
-  * @param  None
-  * @retval None
-  */
-void NMI_Handler(void)
-{
-}
-
-/**
-  * @brief  This function handles Hard Fault exception.
-  * @param  None
-  * @retval None
-  */
-void HardFault_Handler(void)
-{
-  /* Go to infinite loop when Hard Fault exception occurs */
-  while (1)
-  {
-  }
-}
-
-/**
-  * @brief  This function handles Memory Manage exception.
-  * @param  None
-  * @retval None
-  */
-void MemManage_Handler(void)
-{
-  /* Go to infinite loop when Memory Manage exception occurs */
-  while (1)
-  {
-  }
-}
-
-/**
-  * @brief  This function handles Bus Fault exception.
-  * @param  None
-  * @retval None
-  */
-void BusFault_Handler(void)
-{
-  /* Go to infinite loop when Bus Fault exception occurs */
-  while (1)
-  {
-  }
-}
-
-/**
-  * @brief  This function handles Usage Fault exception.
-  * @param  None
-  * @retval None
-  */
-void UsageFault_Handler(void)
-{
-  /* Go to infinite loop when Usage Fault exception occurs */
-  while (1)
-  {
-  }
-}
-
-/**
-  * @brief  This function handles SVCall exception.
-  * @param  None
-  * @retval None
-  */
-void SVC_Handler(void)
+#include "timer.h"
+#include "uart.h"
+#include "sdcard.h"
+#include "dma.h"
+#include "string.h"
+
+#define IT_IRQ_WORDS        3u              /* ISPR words up to IRQ 95 */
+#define IT_NONE             0xFFu
+
+static IRQn_Type const irqs[IT_NUM] = {
+    TIM2_IRQn,
+    TIM5_IRQn,
+    USART1_IRQn,
+    SDIO_IRQn,
+    DMA1_Stream0_IRQn,
+    DMA1_Stream1_IRQn,
+    DMA1_Stream2_IRQn,
+    DMA1_Stream3_IRQn,
+    DMA1_Stream4_IRQn,
+    DMA1_Stream5_IRQn,
+    DMA1_Stream6_IRQn,
+    DMA1_Stream7_IRQn,
+    DMA2_Stream0_IRQn,
+    DMA2_Stream1_IRQn,
+    DMA2_Stream2_IRQn,
+    DMA2_Stream3_IRQn,
+    DMA2_Stream4_IRQn,
+    DMA2_Stream5_IRQn,
+    DMA2_Stream6_IRQn,
+    DMA2_Stream7_IRQn,
+};
+
+static char const *const names[IT_NUM] = {
+    "tim2", "tim5", "usart1", "sdio",
+    "dma1_s0", "dma1_s1", "dma1_s2", "dma1_s3",
+    "dma1_s4", "dma1_s5", "dma1_s6", "dma1_s7",
+    "dma2_s0", "dma2_s1", "dma2_s2", "dma2_s3",
+    "dma2_s4", "dma2_s5", "dma2_s6", "dma2_s7",
+};
+
+static uint8_t ids[IT_IRQ_WORDS * 32u];     /* IRQ number to it_id_t */
+static uint32_t tracked[IT_IRQ_WORDS];      /* ISPR bits of our sources */
+static it_stats_t stats[IT_NUM];
+static uint32_t pended[IT_NUM];             /* cycles when seen pending */
+static uint32_t waiting;                    /* bit per it_id_t */
+
+static void it_stamp(uint32_t now);
+
+extern void
+it_init(void)
 {
+    uint32_t i;
+
+    memset(ids, IT_NONE, sizeof(ids));
+    memset(tracked, 0, sizeof(tracked));
+    for (i = 0; i < IT_NUM; i++) {
+        ids[irqs[i]] = (uint8_t) i;
+        tracked[irqs[i] / 32u] |= 1u << (irqs[i] % 32u);
+    }
+    memset(stats, 0, sizeof(stats));
+    waiting = 0;
+
+    utl_cycles_init();
 }
 
-/**
-  * @brief  This function handles Debug Monitor exception.
-  * @param  None
-  * @retval None
-  */
-void DebugMon_Handler(void)
+extern void
+it_get_stats(it_id_t id, it_stats_t *s)
 {
+    uint32_t primask;
+
+    if (id < IT_NUM) {
+        primask = __get_PRIMASK();
+        __disable_irq();
+        *s = stats[id];
+        __set_PRIMASK(primask);
+    }
 }
 
-/**
-  * @brief  This function handles PendSVC exception.
-  * @param  None
-  * @retval None
-  */
-void PendSV_Handler(void)
+extern char const *
+it_name(it_id_t id)
 {
+    return (id < IT_NUM) ? names[id] : "";
 }
 
-/**
-  * @brief  This function handles SysTick Handler.
-  * @param  None
-  * @retval None
-  */
-void SysTick_Handler(void)
+/*
+ * Count the entry and settle the latency of a source that was seen
+ * waiting. Returns the entry time for it_exit().
+ */
+static inline uint32_t
+it_enter(it_id_t id)
 {
-	uint8_t *buf;
-  uint8_t temp1, temp2 = 0x00;
-	TimingDelay_Decrement();
-  
-  if (DemoEnterCondition == 0x00)
-  {
-    TimingDelay_Decrement();
-  }
-  else
-  {
-    buf = USBD_HID_GetPos();
-    if((buf[1] != 0) ||(buf[2] != 0))
-    {
-      USBD_HID_SendReport (&USB_OTG_dev, 
-                           buf,
-                           4);
-    } 
-    Counter ++;
-    if (Counter == 10)
-    {
-      Buffer_X[0] = 0;
-      Buffer_Y[0] = 0;
-      /* Disable All TIM4 Capture Compare Channels */
-      TIM_CCxCmd(TIM4, TIM_Channel_1, DISABLE);
-      TIM_CCxCmd(TIM4, TIM_Channel_2, DISABLE);
-      TIM_CCxCmd(TIM4, TIM_Channel_3, DISABLE);
-      TIM_CCxCmd(TIM4, TIM_Channel_4, DISABLE);
-      
-      LSM303DLHC_Read(ACC_I2C_ADDRESS, LSM303DLHC_OUT_X_H_A, 6, Buffer_X);
-      /* Remove the offsets values from data */
-      Buffer_X[0] -= X_Offset;
-      
-      LSM303DLHC_Read(ACC_I2C_ADDRESS, LSM303DLHC_OUT_Y_H_A, 6, Buffer_Y);
-      /* Remove the offsets values from data */
-      Buffer_Y[0] -= Y_Offset;
-      
-      /* Update autoreload and capture compare registers value*/
-      temp1 = ABS((int8_t)(Buffer_X[0]));
-      temp2 = ABS((int8_t)(Buffer_Y[0]));       
-      TempAcceleration = MAX(temp1, temp2);
-
-      if(TempAcceleration != 0)
-      { 
-        if ((int8_t)Buffer_X[0] < -2)
-        {
-          /* Enable TIM4 Capture Compare Channel 4 */
-          TIM_CCxCmd(TIM4, TIM_Channel_4, ENABLE);
-          /* Sets the TIM4 Capture Compare4 Register value */
-          TIM_SetCompare4(TIM4, TIM_CCR/TempAcceleration);
-        }
-        if ((int8_t)Buffer_X[0] > 2)
-        {
-          /* Enable TIM4 Capture Compare Channel 2 */
-          TIM_CCxCmd(TIM4, TIM_Channel_2, ENABLE);
-          /* Sets the TIM4 Capture Compare2 Register value */
-          TIM_SetCompare2(TIM4, TIM_CCR/TempAcceleration);
+    it_stats_t *s = &stats[id];
+    uint32_t now = utl_cycles();
+    uint32_t latency;
+
+    s->count++;
+    if (waiting & (1u << id)) {
+        waiting &= ~(1u << id);
+        latency = now - pended[id];
+        s->total_latency += latency;
+        if (latency > s->max_latency) {
+            s->max_latency = latency;
         }
-        if ((int8_t)Buffer_Y[0] > 2)
-        { 
-          /* Enable TIM4 Capture Compare Channel 1 */
-          TIM_CCxCmd(TIM4, TIM_Channel_1, ENABLE);
-          /* Sets the TIM4 Capture Compare1 Register value */
-          TIM_SetCompare1(TIM4, TIM_CCR/TempAcceleration);
-        }      
-        if ((int8_t)Buffer_Y[0] < -2)
-        { 
-          /* Enable TIM4 Capture Compare Channel 3 */
-          TIM_CCxCmd(TIM4, TIM_Channel_3, ENABLE);
-          /* Sets the TIM4 Capture Compare3 Register value */
-          TIM_SetCompare3(TIM4, TIM_CCR/TempAcceleration);
-        }
-        /* Time base configuration */
-        TIM_SetAutoreload(TIM4,  TIM_ARR/TempAcceleration);
-      }
-      Counter = 0x00;
-    }  
-  }
-}
-
-/******************************************************************************/
-/*                 STM32Fxxx Peripherals Interrupt Handlers                   */
-/*  Add here the Interrupt Handler for the used peripheral(s) (PPP), for the  */
-/*  available peripheral interrupt handler's name please refer to the startup */
-/*  file (startup_stm32fxxx.s).                                               */
-/******************************************************************************/
-
-/**
-  * @brief  This function handles PPP interrupt request.
-  * @param  None
-  * @retval None
-  */
-/*void PPP_IRQHandler(void)
-{
-}*/
+    }
+    it_stamp(now);
 
-/**
-  * @brief  This function handles EXTI0_IRQ Handler.
-  * @param  None
-  * @retval None
-  */
-void EXTI0_IRQHandler(void)
-{
-  UserButtonPressed = 0x01;
-  
-  /* Clear the EXTI line pending bit */
-  EXTI_ClearITPendingBit(USER_BUTTON_EXTI_LINE);
-}
-
-/**
-  * @brief  This function handles EXTI15_10_IRQ Handler.
-  * @param  None
-  * @retval None
-  */
-void OTG_FS_WKUP_IRQHandler(void)
-{
-  if(USB_OTG_dev.cfg.low_power)
-  {
-	/* Reset SLEEPDEEP and SLEEPONEXIT bits */
-	SCB->SCR &= (uint32_t)~((uint32_t)(SCB_SCR_SLEEPDEEP_Msk | SCB_SCR_SLEEPONEXIT_Msk));
-
-	/* After wake-up from sleep mode, reconfigure the system clock */
-	SystemInit();
-    USB_OTG_UngateClock(&USB_OTG_dev);
-  }
-  EXTI_ClearITPendingBit(EXTI_Line18);
+    return now;
 }
 
-/**
-  * @brief  This function handles OTG_HS Handler.
-  * @param  None
-  * @retval None
-  */
-void OTG_FS_IRQHandler(void)
+static inline void
+it_exit(it_id_t id, uint32_t start)
 {
-  USBD_OTG_ISR_Handler (&USB_OTG_dev);
+    it_stats_t *s = &stats[id];
+    uint32_t now = utl_cycles();
+    uint32_t cycles = now - start;
+
+    s->total_cycles += cycles;
+    if (cycles > s->max_cycles) {
+        s->max_cycles = cycles;
+    }
+    it_stamp(now);
 }
 
-/**
-* @brief  USBD_HID_GetPos
-* @param  None
-* @retval Pointer to report
-*/
-static uint8_t *USBD_HID_GetPos (void)
+/*
+ * Note the first sighting of each source that is pending. Nothing is
+ * usually pending, so this is normally three loads.
+ */
+static void
+it_stamp(uint32_t now)
 {
-  static uint8_t HID_Buffer[4] = {0};
-  
-  HID_Buffer[1] = 0;
-  HID_Buffer[2] = 0;
-  /* LEFT Direction */
-  if(((int8_t)Buffer_Y[0]) < -2)
-  {
-    HID_Buffer[1] += CURSOR_STEP;
-  }
-  /* RIGHT Direction */ 
-  if(((int8_t)Buffer_Y[0]) > 2)
-  {
-   HID_Buffer[1] -= CURSOR_STEP;
-  } 
-  /* UP Direction */
-  if(((int8_t)Buffer_X[0]) < -2)
-  {
-    HID_Buffer[2] += CURSOR_STEP;
-  }
-  /* DOWN Direction */ 
-  if(((int8_t)Buffer_X[0]) > 2)
-  {
-    HID_Buffer[2] -= CURSOR_STEP;
-  } 
-  
-  return HID_Buffer;
+    uint32_t pending;
+    uint32_t bit;
+    uint32_t id;
+    uint32_t w;
+
+    for (w = 0; w < IT_IRQ_WORDS; w++) {
+        pending = NVIC->ISPR[w] & tracked[w];
+        while (pending != 0) {
+            bit = 31u - __CLZ(pending);
+            pending &= ~(1u << bit);
+            id = ids[w * 32u + bit];
+            if ((waiting & (1u << id)) == 0) {
+                waiting |= 1u << id;
+                pended[id] = now;
+            }
+        }
+    }
 }
 
-/**
-  * @}
-  */
-
-/************************ (C) COPYRIGHT STMicroelectronics *****END OF FILE****/ 
+#define IT_VECTOR(vector, id, call)     \
+    void vector(void)                   \
+    {                                   \
+        uint32_t start = it_enter(id);  \
+        call;                           \
+        it_exit(id, start);             \
+    }
+
+IT_VECTOR(TIM2_IRQHandler, it_tim2, timer_hold_irq())
+IT_VECTOR(TIM5_IRQHandler, it_tim5, timer_alarm_irq())
+IT_VECTOR(USART1_IRQHandler, it_usart1, uart_irq())
+IT_VECTOR(SDIO_IRQHandler, it_sdio, sdcard_irq())
+IT_VECTOR(DMA1_Stream0_IRQHandler, it_dma1_s0, dma_irq(0))
+IT_VECTOR(DMA1_Stream1_IRQHandler, it_dma1_s1, dma_irq(1))
+IT_VECTOR(DMA1_Stream2_IRQHandler, it_dma1_s2, dma_irq(2))
+IT_VECTOR(DMA1_Stream3_IRQHandler, it_dma1_s3, dma_irq(3))
+IT_VECTOR(DMA1_Stream4_IRQHandler, it_dma1_s4, dma_irq(4))
+IT_VECTOR(DMA1_Stream5_IRQHandler, it_dma1_s5, dma_irq(5))
+IT_VECTOR(DMA1_Stream6_IRQHandler, it_dma1_s6, dma_irq(6))
+IT_VECTOR(DMA1_Stream7_IRQHandler, it_dma1_s7, dma_irq(7))
+IT_VECTOR(DMA2_Stream0_IRQHandler, it_dma2_s0, dma_irq(8))
+IT_VECTOR(DMA2_Stream1_IRQHandler, it_dma2_s1, dma_irq(9))
+IT_VECTOR(DMA2_Stream2_IRQHandler, it_dma2_s2, dma_irq(10))
+IT_VECTOR(DMA2_Stream3_IRQHandler, it_dma2_s3, dma_irq(11))
+IT_VECTOR(DMA2_Stream4_IRQHandler, it_dma2_s4, dma_irq(12))
+IT_VECTOR(DMA2_Stream5_IRQHandler, it_dma2_s5, dma_irq(13))
+IT_VECTOR(DMA2_Stream6_IRQHandler, it_dma2_s6, dma_irq(14))
+IT_VECTOR(DMA2_Stream7_IRQHandler, it_dma2_s7, dma_irq(15))
@@ -0,0 +1,164 @@
+/**
+ ******************************************************************************
+ * @file    telem.c
+ * @author  Joe Todd
+ * @version
+ * @date    October 2026
+ * @brief   Autogrow
+ *          Binary telemetry records, COBS framed, CRC from the CRC unit.
+ *
+ * Records are built in a word-aligned scratch buffer so the CRC unit can
+ * take them a word at a time, then COBS encoded straight into a frame
+ * buffer that is handed to the UART transmit queue without copying. Frame
+ * buffers come from a pool and go back to it from the UART's completion
+ * interrupt.
+ ******************************************************************************/
+#include "telem.h"
+#include "string.h"
+
+#define HDR_WORDS           2u
+
+typedef struct {
+    uart_tx_desc_t desc;
+    uint8_t data[TELEM_MAX_FRAME];
+} telem_frame_t;
+
+POOL_DEFINE(frames, sizeof(telem_frame_t), TELEM_FRAMES);
+static uint16_t seq;
+
+static void telem_frame_done(void *arg);
+
+extern void
+telem_init(void)
+{
+    crc_init();
+    pool_init(&frames);
+    seq = 0;
+}
+
+/*
+ * Build, checksum and COBS encode one record.
+ */
+extern uint32_t
+telem_encode(uint8_t *out, telem_type_t type, uint32_t time,
+             void const *payload, uint32_t len)
+{
+    uint32_t rec[(TELEM_MAX_RECORD + 3u) / 4u];
+    uint8_t const *in = (uint8_t const *) rec;
+    uint8_t const *p = payload;
+    uint32_t words;
+    uint32_t code_at;
+    uint32_t n;
+    uint32_t i;
+    uint8_t code;
+
+    /*
+     * Header and payload, then the CRC of both.
+     */
+    rec[0] = TELEM_VERSION | ((uint32_t) type << 8) | ((uint32_t) seq++ << 16);
+    rec[1] = time;
+    for (i = 0; i < len; i++) {
+        ((uint8_t *) &rec[HDR_WORDS])[i] = p[i];
+    }
+    words = HDR_WORDS + len / 4u;
+    rec[words] = crc_block(rec, words);
+    n = (words + 1u) * 4u;
+
+    /*
+     * COBS: each zero is replaced by the distance to the next one. The
+     * record is shorter than 254 bytes so no extra block codes are needed.
+     */
+    code_at = 0;
+    code = 1;
+    out[0] = 0;
+    for (i = 0; i < n; i++) {
+        if (in[i] == 0) {
+            out[code_at] = code;
+            code_at += code;
+            code = 1;
+        }
+        else {
+            out[code_at + code] = in[i];
+            code++;
+        }
+    }
+    out[code_at] = code;
+    out[code_at + code] = 0;
+
+    return code_at + code + 1u;
+}
+
+/*
+ * Encode into a free frame buffer and queue it.
+ */
+extern bool
+telem_send(telem_type_t type, uint32_t time, void const *payload, uint32_t len)
+{
+    telem_frame_t *f;
+
+    f = pool_alloc(&frames);
+    if (f == NULL) {
+        return false;
+    }
+
+    f->desc.buf = f->data;
+    f->desc.len = telem_encode(f->data, type, time, payload, len);
+    f->desc.done = telem_frame_done;
+    f->desc.arg = f;
+    uart_tx_submit(&f->desc);
+
+    return true;
+}
+
+extern bool
+telem_send_sample(uint32_t time, uint8_t zone, uint16_t value)
+{
+    uint32_t payload = zone | ((uint32_t) value << 16);
+
+    return telem_send(telem_sample, time, &payload, sizeof(payload));
+}
+
+extern bool
+telem_send_water(uint32_t time, uint8_t zone, uint16_t amount)
+{
+    uint32_t payload = zone | ((uint32_t) amount << 16);
+
+    return telem_send(telem_water, time, &payload, sizeof(payload));
+}
+
+extern bool
+telem_send_counter(uint32_t time, uint16_t id, uint32_t value)
+{
+    uint32_t payload[2] = {id, value};
+
+    return telem_send(telem_counter, time, payload, sizeof(payload));
+}
+
+extern bool
+telem_send_fault(uint32_t time, uint16_t code, uint16_t aux, uint32_t value)
+{
+    uint32_t payload[2] = {code | ((uint32_t) aux << 16), value};
+
+    return telem_send(telem_fault, time, payload, sizeof(payload));
+}
+
+extern uint32_t
+telem_dropped(void)
+{
+    return pool_exhausted(&frames);
+}
+
+extern uint32_t
+telem_frames_high(void)
+{
+    return pool_high(&frames);
+}
+
+/*
+ * UART has finished with the frame.
+ */
+static void
+telem_frame_done(void *arg)
+{
+    pool_free(&frames, arg);
+}
@@ -9,8 +9,15 @@
   ******************************************************************************/
 
 #include "timer.h"
+#include "evt.h"
+#include "string.h"
 
 static uint32_t timer;
+static volatile bool expired;
+static timer_alarm_t *alarms;           /* armed, soonest first */
+static volatile bool due;
+
+static void timer_alarm_load(void);
 
 /* 
  * SYSCLK = 250kHz
@@ -26,6 +33,7 @@ timer_init(void)
     TIM2->DIER |= TIM_DIER_UIE;     /* enable update interrupt */
     TIM2->ARR = 0xFFFF;             /* count to 65535 */
     TIM2->CR1 |= TIM_CR1_ARPE;      /* autoreload on */
+    TIM2->CR1 |= TIM_CR1_URS;       /* only overflow raises the interrupt */
     TIM2->EGR = TIM_EGR_UG;         /* trigger update event */
 
     utl_enable_irq(TIM2_IRQn);
@@ -52,11 +60,152 @@ timer_reconfigure(uint16_t prescalar, uint16_t reload)
     TIM2->ARR = reload;
     TIM2->CNT = 0;
     TIM2->EGR = TIM_EGR_UG;     /* update registers now */
+    TIM2->SR = 0;
+    expired = false;
 
     TIM2->CR1 |= TIM_CR1_CEN;       /* counter enabled */
 }
 
-void TIM2_IRQHandler(void) 
+/*
+ * True once the counter has overflowed since the last reconfigure.
+ */
+extern bool
+timer_expired(void)
+{
+    return expired;
+}
+
+extern void
+timer_alarm_init(void)
+{
+    alarms = NULL;
+    due = false;
+
+    RCC->APB1ENR |= RCC_APB1ENR_TIM5EN;
+    RCC->APB1LPENR |= RCC_APB1LPENR_TIM5LPEN;   /* and in sleep mode */
+
+    TIM5->CR1 = 0;
+    TIM5->PSC = 0x001e;             /* 1ms */
+    TIM5->ARR = 0xFFFFFFFF;         /* free running, all 32 bits */
+    TIM5->CNT = 0;
+    TIM5->EGR = TIM_EGR_UG;
+    TIM5->SR = 0;
+    TIM5->DIER = 0;
+
+    utl_enable_irq(TIM5_IRQn);
+
+    TIM5->CR1 |= TIM_CR1_CEN;
+}
+
+extern uint32_t
+timer_now(void)
+{
+    return TIM5->CNT;
+}
+
+/*
+ * Insert in due order; equal times keep the order they were started in.
+ */
+extern void
+timer_alarm_start(timer_alarm_t *alarm, uint32_t ms, timer_alarm_fn fn,
+                  void *arg)
+{
+    timer_alarm_t **p;
+
+    timer_alarm_stop(alarm);
+    alarm->due = timer_now() + ms;
+    alarm->fn = fn;
+    alarm->arg = arg;
+
+    for (p = &alarms; *p != NULL; p = &(*p)->next) {
+        if ((int32_t) (alarm->due - (*p)->due) < 0) {
+            break;
+        }
+    }
+    alarm->next = *p;
+    *p = alarm;
+
+    timer_alarm_load();
+}
+
+extern void
+timer_alarm_stop(timer_alarm_t *alarm)
+{
+    timer_alarm_t **p;
+
+    for (p = &alarms; *p != NULL; p = &(*p)->next) {
+        if (*p == alarm) {
+            *p = alarm->next;
+            alarm->next = NULL;
+            break;
+        }
+    }
+    timer_alarm_load();
+}
+
+extern bool
+timer_due(void)
+{
+    return due;
+}
+
+extern void
+timer_poll(void)
+{
+    timer_alarm_t *a;
+
+    if (!due) {
+        return;
+    }
+    due = false;
+
+    while (alarms != NULL && (int32_t) (timer_now() - alarms->due) >= 0) {
+        a = alarms;
+        alarms = a->next;
+        a->next = NULL;
+        a->fn(a->arg);          /* may start alarms, this one included */
+    }
+    timer_alarm_load();
+}
+
+/*
+ * Point the compare at the soonest alarm. If that time has already gone
+ * by, the compare would not match until the counter wraps, so mark it due
+ * straight away instead.
+ */
+static void
+timer_alarm_load(void)
+{
+    TIM5->DIER &= ~TIM_DIER_CC1IE;
+    if (alarms == NULL) {
+        return;
+    }
+
+    TIM5->CCR1 = alarms->due;
+    TIM5->SR = ~TIM_SR_CC1IF;
+    TIM5->DIER |= TIM_DIER_CC1IE;
+    if ((int32_t) (timer_now() - alarms->due) >= 0) {
+        due = true;
+        evt_post(evt_alarm);
+    }
+}
+
+/*
+ * Interrupt service, called from the vector in stm32f4xx_it.c.
+ */
+extern void
+timer_hold_irq(void)
 {
     TIM2->SR = 0x0;
+    expired = true;
+    evt_post(evt_hold);
+}
+
+extern void
+timer_alarm_irq(void)
+{
+    TIM5->SR = ~TIM_SR_CC1IF;
+    TIM5->DIER &= ~TIM_DIER_CC1IE;
+    due = true;
+    evt_post(evt_alarm);
 }
@@ -0,0 +1,270 @@
+/**
+ ******************************************************************************
+ * @file    ts.c
+ * @author  Joe Todd
+ * @version
+ * @date    October 2026
+ * @brief   Autogrow
+ *          Delta-of-delta / zig-zag bit packed time series, see ts.h.
+ *
+ * Bits are packed least significant first into 32-bit words. Each code is
+ * a unary class prefix (n ones, then a zero unless it is the last class)
+ * followed by the zig-zag value less one, since a zero delta has its own
+ * one-bit code.
+ ******************************************************************************/
+#include "ts.h"
+#include "string.h"
+
+#define TS_CLASSES          5u
+
+typedef struct {
+    uint32_t const *words;
+    uint32_t pos;
+} ts_reader_t;
+
+/*
+ * Payload bits for each class after the zero class.
+ */
+static uint8_t const time_bits[TS_CLASSES - 1u] = {4, 12, 20, 32};
+static uint8_t const value_bits[TS_CLASSES - 1u] = {1, 6, 12, 17};
+
+static uint32_t ts_code_class(uint32_t zz, uint8_t const *bits);
+static uint32_t ts_code_len(uint32_t zz, uint8_t const *bits);
+static void ts_put_code(ts_series_t *s, uint32_t zz, uint8_t const *bits);
+static void ts_put(ts_series_t *s, uint32_t val, uint32_t n);
+static uint32_t ts_get_code(ts_reader_t *r, uint8_t const *bits);
+static uint32_t ts_get(ts_reader_t *r, uint32_t n);
+static uint32_t ts_zigzag(uint32_t d);
+static uint32_t ts_unzigzag(uint32_t zz);
+
+extern void
+ts_init(ts_series_t *s, ts_block_t *blocks, uint32_t nblocks, uint32_t shift)
+{
+    memset(s, 0, sizeof(*s));
+    s->blocks = blocks;
+    s->nblocks = nblocks;
+    s->shift = shift;
+}
+
+extern void
+ts_append(ts_series_t *s, uint32_t time, uint16_t value)
+{
+    ts_block_t *b;
+    uint16_t v = value >> s->shift;
+    uint32_t dt = time - s->last_t;
+    uint32_t tzz = ts_zigzag(dt - s->last_dt);
+    uint32_t vzz = ts_zigzag((uint32_t) v - s->last_v);
+
+    if (s->used == 0 ||
+        s->nbits + ts_code_len(tzz, time_bits) + ts_code_len(vzz, value_bits)
+            > TS_BLOCK_BITS || s->blocks[s->head].count == 0xFFFFu) {
+        /*
+         * New block, dropping the oldest if the ring is full.
+         */
+        if (s->used != 0) {
+            s->head = (s->head + 1u) % s->nblocks;
+        }
+        if (s->used < s->nblocks) {
+            s->used++;
+        }
+        b = &s->blocks[s->head];
+        b->t0 = time;
+        b->v0 = v;
+        b->count = 1;
+        memset(b->bits, 0, sizeof(b->bits));
+        s->nbits = 0;
+        s->last_dt = 0;
+    }
+    else {
+        ts_put_code(s, tzz, time_bits);
+        ts_put_code(s, vzz, value_bits);
+        s->blocks[s->head].count++;
+        s->last_dt = dt;
+    }
+
+    s->last_t = time;
+    s->last_v = v;
+}
+
+extern uint32_t
+ts_blocks(ts_series_t const *s)
+{
+    return s->used;
+}
+
+extern uint32_t
+ts_count(ts_series_t const *s)
+{
+    uint32_t n = 0;
+    uint32_t i;
+
+    for (i = 0; i < s->used; i++) {
+        n += s->blocks[i].count;
+    }
+
+    return n;
+}
+
+extern uint32_t
+ts_decode(ts_series_t const *s, uint32_t i, uint32_t first,
+          ts_sample_t *out, uint32_t max)
+{
+    ts_block_t const *b;
+    ts_reader_t r;
+    uint32_t t;
+    uint32_t dt = 0;
+    uint32_t v;
+    uint32_t n;
+    uint32_t got = 0;
+
+    if (i >= s->used || max == 0) {
+        return 0;
+    }
+    b = &s->blocks[(s->head + s->nblocks - (s->used - 1u) + i) % s->nblocks];
+
+    r.words = b->bits;
+    r.pos = 0;
+    t = b->t0;
+    v = b->v0;
+
+    for (n = 0; n < b->count && got < max; n++) {
+        if (n != 0) {
+            dt += ts_unzigzag(ts_get_code(&r, time_bits));
+            t += dt;
+            v += ts_unzigzag(ts_get_code(&r, value_bits));
+        }
+        if (n >= first) {
+            out[got].time = t;
+            out[got].value = (uint16_t) ((v & 0xFFFFu) << s->shift);
+            got++;
+        }
+    }
+
+    return got;
+}
+
+extern bool
+ts_last(ts_series_t const *s, ts_sample_t *last)
+{
+    if (s->used == 0) {
+        return false;
+    }
+    last->time = s->last_t;
+    last->value = (uint16_t) (s->last_v << s->shift);
+
+    return true;
+}
+
+/*
+ * Class 0 is the zero delta, classes 1.. carry zz - 1 in bits[class - 1].
+ */
+static uint32_t
+ts_code_class(uint32_t zz, uint8_t const *bits)
+{
+    uint32_t c;
+
+    if (zz == 0) {
+        return 0;
+    }
+    for (c = 1; c < TS_CLASSES - 1u; c++) {
+        if (zz - 1u < (1u << bits[c - 1u])) {
+            break;
+        }
+    }
+
+    return c;
+}
+
+static uint32_t
+ts_code_len(uint32_t zz, uint8_t const *bits)
+{
+    uint32_t c = ts_code_class(zz, bits);
+
+    if (c == 0) {
+        return 1;
+    }
+
+    return ((c < TS_CLASSES - 1u) ? c + 1u : c) + bits[c - 1u];
+}
+
+static void
+ts_put_code(ts_series_t *s, uint32_t zz, uint8_t const *bits)
+{
+    uint32_t c = ts_code_class(zz, bits);
+
+    if (c < TS_CLASSES - 1u) {
+        ts_put(s, (1u << c) - 1u, c + 1u);     /* c ones then a zero */
+    }
+    else {
+        ts_put(s, (1u << c) - 1u, c);
+    }
+    if (c != 0) {
+        ts_put(s, zz - 1u, bits[c - 1u]);
+    }
+}
+
+static void
+ts_put(ts_series_t *s, uint32_t val, uint32_t n)
+{
+    uint32_t *w = s->blocks[s->head].bits;
+    uint32_t i = s->nbits / 32u;
+    uint32_t off = s->nbits % 32u;
+
+    if (n == 0) {
+        return;
+    }
+    if (n < 32u) {
+        val &= (1u << n) - 1u;
+    }
+    w[i] |= val << off;
+    if (off + n > 32u) {
+        w[i + 1u] |= val >> (32u - off);
+    }
+    s->nbits += n;
+}
+
+static uint32_t
+ts_get_code(ts_reader_t *r, uint8_t const *bits)
+{
+    uint32_t c = 0;
+
+    while (c < TS_CLASSES - 1u && ts_get(r, 1) != 0) {
+        c++;
+    }
+    if (c == 0) {
+        return 0;
+    }
+
+    return ts_get(r, bits[c - 1u]) + 1u;
+}
+
+static uint32_t
+ts_get(ts_reader_t *r, uint32_t n)
+{
+    uint32_t i = r->pos / 32u;
+    uint32_t off = r->pos % 32u;
+    uint32_t val;
+
+    val = r->words[i] >> off;
+    if (off + n > 32u) {
+        val |= r->words[i + 1u] << (32u - off);
+    }
+    if (n < 32u) {
+        val &= (1u << n) - 1u;
+    }
+    r->pos += n;
+
+    return val;
+}
+
+static uint32_t
+ts_zigzag(uint32_t d)
+{
+    return (d << 1) ^ (uint32_t) ((int32_t) d >> 31);
+}
+
+static uint32_t
+ts_unzigzag(uint32_t zz)
+{
+    return (zz >> 1) ^ (0u - (zz & 1u));
+}
@@ -0,0 +1,377 @@
+/**
+ ******************************************************************************
+ * @file    uart.c
+ * @author  Joe Todd
+ * @version
+ * @date    October 2026
+ * @brief   Autogrow
+ *          USART1 with DMA reception into a circular ring.
+ *
+ * Connections
+ *
+ *      TX - PA9
+ *      RX - PA10
+ *
+ * DMA2 Stream 2 runs continuously in circular mode, so bytes land in the
+ * ring without any CPU involvement. The USART idle-line interrupt marks
+ * the end of a frame: one interrupt per command rather than one per byte.
+ * Frames are queued as (position, length) pairs on an SPSC ring, filled
+ * by the interrupt, and read in place.
+ *
+ * Positions are kept as free-running byte counts (laps of the ring are
+ * counted on DMA transfer-complete), so the distance between the DMA and
+ * any frame is a plain subtraction and overwrites can be detected.
+ *
+ * Transmission takes caller-owned buffers on a linked list of descriptors
+ * and sends each with one DMA2 Stream 7 transfer. The transfer-complete
+ * interrupt starts the next buffer before it calls the completion of the
+ * last one, so the USART data register is refilled straight away and the
+ * line never idles while there is anything queued.
+ ******************************************************************************/
+#include "uart.h"
+#include "string.h"
+
+#define UART_DMA_CHAN       4u
+
+typedef struct {
+    uint32_t start;
+    uint32_t len;
+} uart_rx_frame_t;
+
+static uint8_t rx_ring[RX_BUFFER_SIZE];
+static volatile uint32_t rx_laps;
+static uint32_t rx_frame_start;             /* where the next frame begins */
+static uint32_t rx_dropped;
+static uint32_t tx_errors;                  /* buffers dropped on a DMA error */
+
+static uart_rx_frame_t rx_frame_buf[RX_MAX_FRAMES];
+static ring_t rx_frames;                    /* interrupt in, application out */
+
+static uart_tx_desc_t *tx_head;             /* being sent */
+static uart_tx_desc_t *tx_tail;
+static uart_tx_desc_t tx_slots[UART_TX_SLOTS];
+static volatile bool tx_slot_busy[UART_TX_SLOTS];
+
+static uint32_t uart_rx_pos(void);
+static void uart_tx_start(uart_tx_desc_t const *desc);
+static void uart_tx_slot_done(void *arg);
+static void uart_rx_dma_event(uint32_t flags, void *arg);
+static void uart_tx_dma_event(uint32_t flags, void *arg);
+
+/*
+ * Initialise the USART and start reception.
+ */
+extern void
+uart_init(uint32_t baudrate)
+{
+    DMA_Stream_TypeDef cfg;
+
+    RCC->APB2ENR |= RCC_APB2ENR_USART1EN;
+
+    iox_configure_pin(iox_port_a, PIN9, iox_mode_af,
+            iox_type_pp, iox_speed_med, iox_pupd_up);
+    iox_configure_pin(iox_port_a, PIN10, iox_mode_af,
+            iox_type_pp, iox_speed_med, iox_pupd_up);
+    iox_alternate_func(iox_port_a, PIN9, AF7);
+    iox_alternate_func(iox_port_a, PIN10, AF7);
+
+    rx_laps = 0;
+    rx_frame_start = 0;
+    (void) ring_init(&rx_frames, rx_frame_buf, RX_MAX_FRAMES,
+                     sizeof(uart_rx_frame_t));
+    tx_head = NULL;
+    tx_tail = NULL;
+
+    USART1->CR1 = 0;
+    USART1->BRR = (PCLK2 + baudrate / 2) / baudrate;  /* 16x oversampling */
+    USART1->CR2 = 0;
+    USART1->CR3 = USART_CR3_DMAR | USART_CR3_DMAT;
+
+    /*
+     * Circular reception into rx_ring.
+     */
+    (void) dma_claim(UART_DMA, UART_DMA_CHAN, uart_rx_dma_event, NULL);
+    cfg.PAR = (uint32_t) &USART1->DR;
+    cfg.M0AR = (uint32_t) rx_ring;
+    cfg.M1AR = 0;
+    cfg.NDTR = RX_BUFFER_SIZE;
+    cfg.FCR = 0;
+    cfg.CR = (2u << DMA_CR_PL_Pos)
+        | (1u << DMA_CR_MINC_Pos)
+        | (1u << DMA_CR_CIRC_Pos)
+        | (1u << DMA_CR_TCIE_Pos);
+    dma_configure(UART_DMA, &cfg);
+    dma_start(UART_DMA);
+
+    USART1->CR1 = USART_CR1_UE | USART_CR1_RE | USART_CR1_TE
+        | USART_CR1_IDLEIE;
+
+    /*
+     * Transmit stream: memory to peripheral, one transfer per buffer.
+     */
+    (void) dma_claim(UART_TX_DMA, UART_DMA_CHAN, uart_tx_dma_event, NULL);
+    cfg.M0AR = 0;
+    cfg.NDTR = 0;
+    cfg.CR = (2u << DMA_CR_PL_Pos)
+        | (1u << DMA_CR_MINC_Pos)
+        | (1u << DMA_CR_DIR_Pos)
+        | (1u << DMA_CR_TEIE_Pos)
+        | (1u << DMA_CR_TCIE_Pos);
+    dma_configure(UART_TX_DMA, &cfg);
+
+    utl_enable_irq(USART1_IRQn);
+}
+
+/*
+ * Send a buffer using one of the driver's own descriptors.
+ */
+extern void
+uart_send_data(unsigned char *buf, uint32_t len)
+{
+    uint32_t i = 0;
+
+    if (len == 0) {
+        return;
+    }
+
+    for (;;) {
+        if (!tx_slot_busy[i]) {
+            break;
+        }
+        i = (i + 1) % UART_TX_SLOTS;
+    }
+
+    tx_slot_busy[i] = true;
+    tx_slots[i].buf = buf;
+    tx_slots[i].len = len;
+    tx_slots[i].done = uart_tx_slot_done;
+    tx_slots[i].arg = (void *) &tx_slot_busy[i];
+    uart_tx_submit(&tx_slots[i]);
+}
+
+/*
+ * Chain a descriptor on to the transmit list. NDTR=0 would never
+ * complete, so an empty buffer is handed straight back unsent.
+ */
+extern void
+uart_tx_submit(uart_tx_desc_t *desc)
+{
+    uint32_t primask;
+
+    if (desc->len == 0) {
+        if (desc->done != NULL) {
+            desc->done(desc->arg);
+        }
+        return;
+    }
+    desc->next = NULL;
+
+    primask = __get_PRIMASK();
+    __disable_irq();
+    if (tx_head == NULL) {
+        tx_head = desc;
+        tx_tail = desc;
+        uart_tx_start(desc);
+    }
+    else {
+        tx_tail->next = desc;
+        tx_tail = desc;
+    }
+    __set_PRIMASK(primask);
+}
+
+extern bool
+uart_tx_idle(void)
+{
+    return tx_head == NULL;
+}
+
+extern uint8_t
+uart_get_byte(uint32_t i)
+{
+    return rx_ring[i % RX_BUFFER_SIZE];
+}
+
+/*
+ * Describe the oldest frame in place.
+ */
+extern bool
+uart_frame_get(uart_frame_t *frame)
+{
+    uart_rx_frame_t const *f;
+    uint32_t off;
+
+    f = ring_peek(&rx_frames);
+    if (f == NULL) {
+        return false;
+    }
+
+    off = f->start % RX_BUFFER_SIZE;
+
+    frame->total = f->len;
+    frame->seg[0] = &rx_ring[off];
+    frame->seg[1] = rx_ring;
+    if (off + f->len > RX_BUFFER_SIZE) {
+        frame->len[0] = RX_BUFFER_SIZE - off;
+        frame->len[1] = f->len - frame->len[0];
+    }
+    else {
+        frame->len[0] = f->len;
+        frame->len[1] = 0;
+    }
+
+    return true;
+}
+
+extern bool
+uart_frame_release(void)
+{
+    uart_rx_frame_t const *f;
+    uint32_t primask;
+    uint32_t pos;
+    uint32_t start;
+
+    f = ring_peek(&rx_frames);
+    if (f == NULL) {
+        return false;
+    }
+    start = f->start;
+
+    primask = __get_PRIMASK();
+    __disable_irq();
+    pos = uart_rx_pos();
+    __set_PRIMASK(primask);
+
+    ring_drop(&rx_frames);
+
+    return (pos - start) <= RX_BUFFER_SIZE;
+}
+
+extern uint32_t
+uart_rx_dropped(void)
+{
+    return rx_dropped;
+}
+
+extern uint32_t
+uart_tx_errors(void)
+{
+    return tx_errors;
+}
+
+__attribute__((weak)) void
+data_recv_callback(uint8_t bytes)
+{
+    (void) bytes;
+}
+
+/*
+ * Idle line: everything since the last idle is one frame.
+ */
+extern void
+uart_irq(void)
+{
+    uart_rx_frame_t f;
+    uint32_t pos;
+    uint32_t waiting;
+
+    if ((USART1->SR & USART_SR_IDLE) == 0) {
+        return;
+    }
+    (void) USART1->DR;              /* SR then DR clears IDLE */
+
+    pos = uart_rx_pos();
+    if (pos == rx_frame_start) {
+        return;
+    }
+
+    f.start = rx_frame_start;
+    f.len = pos - rx_frame_start;
+    if (!ring_put(&rx_frames, &f)) {
+        rx_dropped++;
+    }
+    rx_frame_start = pos;
+
+    waiting = ring_count(&rx_frames);
+    data_recv_callback(waiting > 0xFF ? 0xFF : waiting);
+}
+
+/*
+ * Transfer complete: the DMA has wrapped back to the start of the ring.
+ */
+static void
+uart_rx_dma_event(uint32_t flags, void *arg)
+{
+    if (flags & DMA_FLAG_TC) {
+        rx_laps++;
+    }
+}
+
+/*
+ * Transmit transfer complete: start the next buffer, then release this one.
+ * On a transfer error the stream has disabled itself without a TC, so the
+ * buffer is dropped, counted, and released the same way.
+ */
+static void
+uart_tx_dma_event(uint32_t flags, void *arg)
+{
+    uart_tx_desc_t *done;
+
+    if ((flags & (DMA_FLAG_TC | DMA_FLAG_TE)) == 0) {
+        return;
+    }
+    if (flags & DMA_FLAG_TE) {
+        tx_errors++;
+    }
+
+    done = tx_head;
+    if (done == NULL) {
+        return;
+    }
+    tx_head = done->next;
+    if (tx_head != NULL) {
+        uart_tx_start(tx_head);
+    }
+    else {
+        tx_tail = NULL;
+    }
+
+    if (done->done != NULL) {
+        done->done(done->arg);
+    }
+}
+
+/*
+ * Free-running count of bytes received. Must not be preempted by the
+ * other receive interrupt, and takes care of a lap the DMA interrupt has
+ * not got round to yet.
+ */
+static uint32_t
+uart_rx_pos(void)
+{
+    uint32_t ndtr;
+
+    ndtr = dma_stream(UART_DMA)->NDTR;
+    if (dma_ack(UART_DMA) & DMA_FLAG_TC) {
+        rx_laps++;
+        ndtr = dma_stream(UART_DMA)->NDTR;
+    }
+
+    return rx_laps * RX_BUFFER_SIZE + (RX_BUFFER_SIZE - ndtr);
+}
+
+static void
+uart_tx_start(uart_tx_desc_t const *desc)
+{
+    DMA_Stream_TypeDef *tx = dma_stream(UART_TX_DMA);
+
+    tx->M0AR = (uint32_t) desc->buf;
+    tx->NDTR = desc->len;
+    dma_start(UART_TX_DMA);
+}
+
+static void
+uart_tx_slot_done(void *arg)
+{
+    *(volatile bool *) arg = false;
+}
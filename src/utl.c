@@ -33,4 +33,18 @@ utl_disable_irq(IRQn_Type irq)
 
 	i = irq / 32;
 	NVIC->ICER[i] = 1 << (irq - (i * 32));
-}
\ No newline at end of file
+}
+
+/**
+ * Start the DWT cycle counter. Once it is running it is left alone, so
+ * every user can call this without upsetting the others' readings.
+ */
+extern void
+utl_cycles_init(void)
+{
+	CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+	if ((UTL_DWT_CTRL & UTL_DWT_CYCCNTENA) == 0) {
+		UTL_DWT_CYCCNT = 0;
+		UTL_DWT_CTRL |= UTL_DWT_CYCCNTENA;
+	}
+}
@@ -0,0 +1,108 @@
+/**
+ ******************************************************************************
+ * @file    wdg.c
+ * @author  Joe Todd
+ * @version
+ * @date    October 2026
+ * @brief   Autogrow
+ *          Independent watchdog and task supervisor.
+ *
+ ******************************************************************************/
+#include "wdg.h"
+#include "string.h"
+
+#define WDG_BKP             (RTC->BKP19R)
+#define WDG_BKP_MAGIC       0x57440000u     /* "WD" in the top half */
+#define WDG_RELOAD          (WDG_TIMEOUT_MS / 8u)   /* LSI 32kHz / 256, 12 bits */
+#define WDG_RESET_FLAGS     0xFE000000u
+
+static uint32_t due[WDG_TASKS];
+static bool armed[WDG_TASKS];
+static timer_alarm_t check;
+static wdg_reset_t last;
+
+static void wdg_check(void *arg);
+static void wdg_blame(wdg_task_t task);
+
+extern void
+wdg_init(void)
+{
+    uint32_t bkp = WDG_BKP;
+
+    last.flags = RCC->CSR & WDG_RESET_FLAGS;
+    last.task = wdg_task_none;
+    if ((last.flags & RCC_CSR_WDGRSTF) &&
+        (bkp & 0xFFFF0000u) == WDG_BKP_MAGIC) {
+        last.task = (wdg_task_t) (bkp & 0xFFu);
+    }
+    RCC->CSR |= RCC_CSR_RMVF;
+
+    memset(armed, 0, sizeof(armed));
+    wdg_blame(wdg_task_loop);
+
+    IWDG_WriteAccessCmd(IWDG_WriteAccess_Enable);
+    IWDG_SetPrescaler(IWDG_Prescaler_256);
+    IWDG_SetReload(WDG_RELOAD);
+    IWDG_ReloadCounter();
+    IWDG_Enable();
+
+    timer_alarm_start(&check, WDG_CHECK_MS, wdg_check, NULL);
+}
+
+extern void
+wdg_start(wdg_task_t task, uint32_t ms)
+{
+    if (task < WDG_TASKS) {
+        due[task] = timer_now() + ms;
+        armed[task] = true;
+    }
+}
+
+extern void
+wdg_stop(wdg_task_t task)
+{
+    if (task < WDG_TASKS) {
+        armed[task] = false;
+    }
+}
+
+extern void
+wdg_last_reset(wdg_reset_t *reset)
+{
+    *reset = last;
+}
+
+extern bool
+wdg_was_reset(void)
+{
+    return (last.flags & RCC_CSR_WDGRSTF) != 0;
+}
+
+/*
+ * Reload only if every armed task is in time. Once one is late the alarm
+ * is not restarted either, so nothing else can reload the IWDG.
+ */
+static void
+wdg_check(void *arg)
+{
+    uint32_t now = timer_now();
+    uint32_t i;
+
+    for (i = 0; i < WDG_TASKS; i++) {
+        if (armed[i] && (int32_t) (now - due[i]) > 0) {
+            wdg_blame((wdg_task_t) i);
+            return;
+        }
+    }
+
+    IWDG_ReloadCounter();
+    timer_alarm_start(&check, WDG_CHECK_MS, wdg_check, NULL);
+}
+
+static void
+wdg_blame(wdg_task_t task)
+{
+    if ((WDG_BKP & 0xFFu) != task) {
+        WDG_BKP = WDG_BKP_MAGIC | task;
+    }
+}
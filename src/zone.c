@@ -0,0 +1,157 @@
+/**
+ ******************************************************************************
+ * @file    zone.c
+ * @author  Joe Todd
+ * @version
+ * @date    October 2026
+ * @brief   Autogrow
+ *          Table-driven sensor/valve zones.
+ *
+ ******************************************************************************/
+#include "zone.h"
+#include "string.h"
+
+static zone_t zones[ZONE_MAX];
+static uint32_t count;
+static uint8_t chans[ZONE_MAX];
+static uint16_t levels[ZONE_MAX];
+static uint8_t probe_users[ZONE_MAX];
+static ts_block_t history_blocks[ZONE_MAX][ZONE_HISTORY_BLOCKS];
+static ts_block_t flow_blocks[ZONE_MAX][ZONE_FLOW_BLOCKS];
+
+static void zone_probes(bool on);
+
+extern uint32_t
+zone_init(zone_cfg_t const *table, uint32_t n)
+{
+    zone_t *z;
+    iox_port_t port;
+    uint32_t pin;
+    uint32_t i;
+
+    count = 0;
+    for (i = 0; i < n && i < ZONE_MAX; i++) {
+        if (!adc_channel_pin(table[i].chan, &port, &pin)) {
+            break;
+        }
+        z = &zones[i];
+        z->cfg = table[i];
+        z->level = 0;
+        z->dose = 0;
+        probe_users[i] = 0;
+        ctl_init(&z->ctl, 0, 0, 0);
+        ts_init(&z->history, history_blocks[i], ZONE_HISTORY_BLOCKS, 4);
+        ts_init(&z->flow, flow_blocks[i], ZONE_FLOW_BLOCKS, 0);
+        chans[i] = table[i].chan;
+
+        iox_configure_pin(port, pin, iox_mode_analog,
+                iox_type_pp, iox_speed_low, iox_pupd_none);
+        iox_configure_pin((iox_port_t) z->cfg.en_port, z->cfg.en_pin,
+                iox_mode_out, iox_type_pp, iox_speed_low, iox_pupd_down);
+        iox_configure_pin((iox_port_t) z->cfg.valve_port, z->cfg.valve_pin,
+                iox_mode_out, iox_type_pp, iox_speed_low, iox_pupd_down);
+        count++;
+    }
+
+    return count;
+}
+
+extern uint32_t
+zone_count(void)
+{
+    return count;
+}
+
+extern zone_t *
+zone_get(uint32_t i)
+{
+    return (i < count) ? &zones[i] : NULL;
+}
+
+extern void
+zone_sample_start(void)
+{
+    zone_probes(true);
+}
+
+extern bool
+zone_sample_end(uint32_t time)
+{
+    bool ok;
+    uint32_t i;
+
+    ok = (count != 0) && adc_scan(chans, count, levels);
+    zone_probes(false);
+    if (!ok) {
+        return false;
+    }
+
+    for (i = 0; i < count; i++) {
+        zones[i].level = levels[i];
+        ts_append(&zones[i].history, time, levels[i]);
+    }
+
+    return true;
+}
+
+extern void
+zone_control(uint16_t kp, uint16_t ki, uint16_t kd, uint32_t dose_max)
+{
+    zone_t *z;
+    uint32_t i;
+
+    for (i = 0; i < count; i++) {
+        z = &zones[i];
+        ctl_gains(&z->ctl, kp, ki, kd);
+        z->dose = ctl_update(&z->ctl, z->level, z->cfg.setpoint, dose_max);
+    }
+}
+
+extern void
+zone_probe(uint32_t i, bool on)
+{
+    if (i >= count) {
+        return;
+    }
+    if (on) {
+        probe_users[i]++;
+    }
+    else if (probe_users[i] != 0) {
+        probe_users[i]--;
+    }
+    iox_set_pin_state((iox_port_t) zones[i].cfg.en_port,
+                      zones[i].cfg.en_pin, probe_users[i] != 0);
+}
+
+extern bool
+zone_read(uint32_t i, uint32_t time)
+{
+    uint16_t level;
+
+    if (i >= count || !adc_scan(&chans[i], 1, &level)) {
+        return false;
+    }
+    zones[i].level = level;
+    ts_append(&zones[i].history, time, level);
+
+    return true;
+}
+
+extern void
+zone_valve(uint32_t i, bool open)
+{
+    if (i < count) {
+        iox_set_pin_state((iox_port_t) zones[i].cfg.valve_port,
+                          zones[i].cfg.valve_pin, open);
+    }
+}
+
+static void
+zone_probes(bool on)
+{
+    uint32_t i;
+
+    for (i = 0; i < count; i++) {
+        zone_probe(i, on);
+    }
+}
@@ -0,0 +1,216 @@
+#!/usr/bin/env python3
+"""
+Boot the QEMU test image and check what it reports on semihosting.
+
+    make qemu
+    tools/qemu_test.py autogrow-qemu.elf
+    tools/qemu_test.py --save run.txt autogrow-qemu.elf
+    tools/qemu_test.py --log run.txt        # check a saved run
+
+The image (see src/qemu.c) prints "<ms> <event> [<zone> <value>]" lines:
+boot, timclk, cycle, adc, valve and end. The checks:
+
+    timclk      the timers count; the rate QEMU runs them at is shown
+    boot        the event loop starts within --boot-ms of reset
+    cadence     cycles are one hold apart, to within --tolerance
+    valve       the dry pot is watered in the first cycle; every open is
+                shut again, no pulse is longer than soak_pulse, no cycle
+                gives more than dose_max, and a zone that reads wet after
+                a pulse is not opened again that cycle
+    end         the image ran all its cycles and exited cleanly
+
+QEMU runs its timers on a clock that its STM32F405 model sets, not the
+board's 31.25kHz, and -global cannot move it. The image measures it and gives every time in board milliseconds,
+so the holds and pulses check against the board's figures whatever the
+clock. What the CPU alone decides, boot and the time from an alarm to
+the valve moving, is squeezed by the same factor, so those limits are
+taken in QEMU's own time and scaled by timclk.
+
+QEMU runs with -icount shift=0, one ns an instruction, so a run is the
+same on any host, and sleep=off so that the holds pass as fast as the
+host can go. The defaults follow inc/param.h and inc/zone.h.
+"""
+
+import argparse
+import subprocess
+import sys
+
+TIMER_HZ = 31250                # APB1 timer clock, see src/timer.c
+HOLD_PSC = 0xF000
+HOLD_TIME = 86400 // 2          # PARAM_HOLD_TIME
+SETTLE_MS = 2000                # ZONE_SETTLE_MS
+HOLD_MS = HOLD_TIME * (HOLD_PSC + 1) * 1000 // TIMER_HZ + SETTLE_MS
+SETPOINT = 2048                 # PARAM_MOIST_LEVEL
+SOAK_BAND = 200                 # PARAM_SOAK_BAND
+SOAK_PULSE_S = 10               # PARAM_SOAK_PULSE
+DOSE_MAX_S = 20                 # PARAM_DOSE_MAX
+SLACK_MS = 50                   # alarm granularity against SysTick
+CPU_SLACK_US = 20               # alarm to valve on the CPU, QEMU time
+
+QEMU = [
+    "qemu-system-arm", "-M", "netduinoplus2", "-nographic",
+    "-monitor", "none", "-serial", "null",
+    "-semihosting-config", "enable=on,target=native",
+    "-icount", "shift=0,sleep=off",
+]
+
+
+def parse(text):
+    events = []
+    for line in text.splitlines():
+        f = line.split()
+        if len(f) < 2 or not f[0].isdigit():
+            continue
+        events.append((int(f[0]), f[1], [int(x) for x in f[2:]]))
+    return events
+
+
+def split_cycles(events):
+    cycles = []
+    for ev in events:
+        if ev[1] == "cycle":
+            cycles.append([ev])
+        elif cycles:
+            cycles[-1].append(ev)
+    return cycles
+
+
+def timer_clock(events):
+    for _, what, a in events:
+        if what == "timclk" and len(a) == 2:
+            return a[1]
+    return 0
+
+
+def check_timclk(events):
+    if timer_clock(events) == 0:
+        return "the timers did not count"
+    return None
+
+
+def check_boot(events, args):
+    boot = [t for t, what, _ in events if what == "boot"]
+    if not boot:
+        return "no boot event"
+    hz = timer_clock(events) or TIMER_HZ
+    ms = boot[0] * TIMER_HZ / hz
+    if ms > args.boot_ms:
+        return "boot took %.3f ms, limit %d" % (ms, args.boot_ms)
+    return None
+
+
+def check_cadence(events, args):
+    starts = [t for t, what, _ in events if what == "cycle"]
+    if len(starts) < 2:
+        return "%d cycles, need two to time" % len(starts)
+    for a, b in zip(starts, starts[1:]):
+        if abs((b - a) - args.hold_ms) > args.hold_ms * args.tolerance:
+            return "cycle at %d ms came %d ms after the last, expected %d" % (
+                b, b - a, args.hold_ms)
+    return None
+
+
+def check_valve(events, args):
+    cycles = split_cycles(events)
+    if not cycles:
+        return "no cycles"
+    hz = timer_clock(events) or TIMER_HZ
+    slack = SLACK_MS + CPU_SLACK_US * hz / TIMER_HZ / 1000
+
+    for n, cycle in enumerate(cycles):
+        opened = {}
+        given = {}
+        wet = set()
+        for t, what, a in cycle:
+            if (what == "adc" and a[0] in given and
+                    a[1] <= SETPOINT - SOAK_BAND):
+                wet.add(a[0])       # re-read after a pulse
+            if what != "valve":
+                continue
+            zone, state = a
+            if state:
+                if zone in opened:
+                    return "zone %d opened twice at %d ms" % (zone, t)
+                if zone in wet:
+                    return "zone %d opened at %d ms after reading wet" % (
+                        zone, t)
+                opened[zone] = t
+                continue
+            if zone not in opened:
+                continue            # shut at boot
+            pulse = t - opened.pop(zone)
+            if pulse > SOAK_PULSE_S * 1000 + slack:
+                return "zone %d pulse of %d ms at %d ms" % (zone, pulse, t)
+            given[zone] = given.get(zone, 0) + pulse
+        if opened:
+            return "cycle %d left zone %d open" % (n, min(opened))
+        for zone, ms in given.items():
+            if ms > DOSE_MAX_S * 1000 + 2 * slack:
+                return "cycle %d gave zone %d %d ms" % (n, zone, ms)
+        if n == 0 and not given:
+            return "the dry pot was not watered in the first cycle"
+    return None
+
+
+def check_end(events, status):
+    if not any(what == "end" for _, what, _ in events):
+        return "the image did not finish its cycles"
+    if status != 0:
+        return "exit status %d" % status
+    return None
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.splitlines()[1])
+    ap.add_argument("elf", nargs="?", help="image built by 'make qemu'")
+    ap.add_argument("--log", help="check this saved output instead")
+    ap.add_argument("--save", help="write the image's output here too")
+    ap.add_argument("--qemu", default=QEMU[0], help="qemu-system-arm to run")
+    ap.add_argument("--timeout", type=float, default=600.0,
+                    help="host seconds before giving up")
+    ap.add_argument("--boot-ms", type=int, default=500)
+    ap.add_argument("--hold-ms", type=int, default=HOLD_MS)
+    ap.add_argument("--tolerance", type=float, default=0.005)
+    args = ap.parse_args()
+
+    if args.log:
+        with open(args.log) as f:
+            text = f.read()
+        status = 0
+    elif args.elf:
+        cmd = [args.qemu] + QEMU[1:] + ["-kernel", args.elf]
+        try:
+            run = subprocess.run(cmd, stdout=subprocess.PIPE, text=True,
+                                 timeout=args.timeout)
+        except subprocess.TimeoutExpired as e:
+            text = e.stdout or ""
+            if isinstance(text, bytes):
+                text = text.decode(errors="replace")
+            status = -1
+        else:
+            text = run.stdout
+            status = run.returncode
+    else:
+        ap.error("give an image or --log")
+    if args.save and not args.log:
+        with open(args.save, "w") as f:
+            f.write(text)
+
+    events = parse(text)
+    failed = 0
+    for name, err in (("timclk", check_timclk(events)),
+                      ("boot", check_boot(events, args)),
+                      ("cadence", check_cadence(events, args)),
+                      ("valve", check_valve(events, args)),
+                      ("end", check_end(events, status))):
+        print("%-8s %s" % (name, "ok" if err is None else "FAIL: " + err))
+        failed += err is not None
+    if timer_clock(events):
+        print("timer clock %d Hz, %.0fx the board's" % (
+            timer_clock(events), timer_clock(events) / TIMER_HZ))
+
+    return 1 if failed else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
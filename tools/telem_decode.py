@@ -0,0 +1,93 @@
+#!/usr/bin/env python3
+"""
+Decode a captured autogrow telemetry stream into CSV.
+
+    telem_decode.py capture.bin > telemetry.csv
+    cat /dev/ttyUSB0 | telem_decode.py > telemetry.csv
+
+See inc/telem.h for the record layout. Frames that fail COBS, length or
+CRC checks are counted and reported on stderr.
+"""
+
+import struct
+import sys
+
+VERSION = 1
+TYPES = {1: "sample", 2: "water", 3: "counter", 4: "fault"}
+PAYLOAD_LEN = {1: 4, 2: 4, 3: 8, 4: 8}
+FIELDS = ["seq", "time", "type", "zone", "value", "id", "count"]
+
+
+def stm32_crc(data):
+    """CRC unit: poly 0x04C11DB7, init all ones, LE words fed MSB first."""
+    crc = 0xFFFFFFFF
+    for (word,) in struct.iter_unpack("<I", data):
+        crc ^= word
+        for _ in range(32):
+            if crc & 0x80000000:
+                crc = ((crc << 1) ^ 0x04C11DB7) & 0xFFFFFFFF
+            else:
+                crc = (crc << 1) & 0xFFFFFFFF
+    return crc
+
+
+def cobs_decode(frame):
+    out = bytearray()
+    i = 0
+    while i < len(frame):
+        code = frame[i]
+        if code == 0 or i + code > len(frame) + 1:
+            return None
+        out += frame[i + 1:i + code]
+        i += code
+        if code < 0xFF and i < len(frame):
+            out.append(0)
+    return bytes(out)
+
+
+def decode_record(rec):
+    if len(rec) < 12 or len(rec) % 4:
+        return None
+    body, (crc,) = rec[:-4], struct.unpack("<I", rec[-4:])
+    if stm32_crc(body) != crc:
+        return None
+    version, rtype, seq, time = struct.unpack("<BBHI", body[:8])
+    payload = body[8:]
+    if version != VERSION or PAYLOAD_LEN.get(rtype) != len(payload):
+        return None
+
+    row = {"seq": seq, "time": time, "type": TYPES[rtype]}
+    if rtype in (1, 2):
+        zone, _, value = struct.unpack("<BBH", payload)
+        row.update(zone=zone, value=value)
+    elif rtype == 3:
+        ident, _, count = struct.unpack("<HHI", payload)
+        row.update(id=ident, count=count)
+    else:
+        code, aux, count = struct.unpack("<HHI", payload)
+        row.update(id=code, value=aux, count=count)
+    return row
+
+
+def main():
+    src = open(sys.argv[1], "rb") if len(sys.argv) > 1 else sys.stdin.buffer
+    stream = src.read()
+    bad = 0
+
+    print(",".join(FIELDS))
+    for frame in stream.split(b"\x00"):
+        if not frame:
+            continue
+        rec = cobs_decode(frame)
+        row = decode_record(rec) if rec is not None else None
+        if row is None:
+            bad += 1
+            continue
+        print(",".join(str(row.get(f, "")) for f in FIELDS))
+
+    if bad:
+        print("%d bad frames" % bad, file=sys.stderr)
+
+
+if __name__ == "__main__":
+    main()